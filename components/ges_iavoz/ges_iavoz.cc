@@ -61,6 +61,9 @@ static IAVoz_ModelSettings_t IAVoz_ModelSettings = {
     .kCategoryLabels = kCategoryLabels,
 };
 
+// The service runs one system on the microphone. Every stream keeps its whole state in its
+// IAVoz_System_t, so more of them can be driven through the IAVoz_System_* API, sharing
+// these settings and the model.
 static IAVoz_System_t * IAVoz_System;
 
 /* EXTERNAL VARIABLES */
@@ -84,7 +87,7 @@ bool IAVOZ_Init ( int iCore, pIAVOZCallback_t pCallback )
     {
         ESP_LOGI(TAG, "%p %p ptr", IAVoz_System, &IAVoz_System);
         ESP_LOGI(TAG, "Starting System");
-        IAVoz_System_Start(IAVoz_System);
+        IAVoz_System_Start(IAVoz_System, iCore);
     }
     return ok;
 }
@@ -96,6 +99,27 @@ bool IAVOZ_Deinit ( void )
     return ok;
 }
 
+bool IAVOZ_GetArenaSize ( size_t * puiArenaSize, size_t * puiArenaUsed )
+{
+    if (!IAVoz_System || !IAVoz_System->interpreter) {return false;}
+    if (puiArenaSize) {*puiArenaSize = IAVoz_System->tensor_arena_size;}
+    if (puiArenaUsed) {*puiArenaUsed = IAVoz_System->interpreter->arena_used_bytes();}
+    return true;
+}
+
+bool IAVOZ_GetGateStats ( uint32_t * puiWindows, uint32_t * puiSkipped )
+{
+#if CONFIG_IAVOZ_VAD_GATE
+    if (!IAVoz_System) {return false;}
+    if (puiWindows) {*puiWindows = IAVoz_System->gate.windows;}
+    if (puiSkipped) {*puiSkipped = IAVoz_System->gate.skipped_silence + IAVoz_System->gate.skipped_position;}
+    return true;
+#else
+    (void) puiWindows; (void) puiSkipped;
+    return false;
+#endif
+}
+
 
 /* CODE */
 /* ---- */
@@ -20,6 +20,7 @@ extern "C" {
 #ifdef CONFIG_IAVOZ_ENABLE
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdarg.h>
 
@@ -72,6 +73,32 @@ bool IAVOZ_Init(int iCore, pIAVOZCallback_t pCallback);
  */
 bool IAVOZ_Deinit(void);
 
+/**
+ * @brief Get the size of the tensor arena of the IAVOZ service.
+ *
+ * @param puiArenaSize    Bytes allocated for the tensor arena.
+ *
+ * @param puiArenaUsed    Bytes of it the model actually uses.
+ *
+ * @return
+ *     - true if all is ok
+ *     - false if the service is not initialized.
+ */
+bool IAVOZ_GetArenaSize(size_t * puiArenaSize, size_t * puiArenaUsed);
+
+/**
+ * @brief Get how many feature windows the voice activity gate let through to the model.
+ *
+ * @param puiWindows      Windows that reached the gate.
+ *
+ * @param puiSkipped      Windows skipped without invoking the model.
+ *
+ * @return
+ *     - true if all is ok
+ *     - false if the service is not initialized or was built without CONFIG_IAVOZ_VAD_GATE.
+ */
+bool IAVOZ_GetGateStats(uint32_t * puiWindows, uint32_t * puiSkipped);
+
 
 
 #endif // CONFIG_IAVOZ_ENABLE
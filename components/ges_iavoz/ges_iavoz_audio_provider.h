@@ -3,12 +3,11 @@
 
 #include "sdkconfig.h"
 
-#include "driver/i2s.h"
 #include "esp_log.h"
 
 #include "freertos/task.h"
 
-#include "ringbuf.h"
+#include "ges_iavoz_ringbuf.h"
 #include "ges_iavoz_model_settings.h"
 
 #include "tensorflow/lite/c/common.h"
@@ -19,23 +18,33 @@
 #define GES_IAVOZ_PIN_DIN   25
 
 typedef struct {
-    ringbuf_t * audio_capture_buffer;
-    uint32_t audio_capture_buffer_size;
+    IAVoz_RingBuf_t * audio_capture_buffer;
     volatile int32_t latest_audio_timestamp;
+    // esp_timer time at which latest_audio_timestamp was reached.
+    volatile int64_t latest_audio_us;
     int32_t history_samples_to_keep;
     int32_t new_samples_to_get;
+    // Samples of the windows handed out by GetAudioSlices, released on the next call
+    // or by ReleaseAudioSlices.
+    int32_t samples_to_release;
 
-    int16_t * audio_output_buffer;
     bool is_audio_started;
-    int16_t * history_buffer;
 
     TaskHandle_t audio_task_handle;
 
     IAVoz_ModelSettings_t * ms;
+
+#if CONFIG_IAVOZ_AUDIO_SOURCE_WAV
+    int16_t * wav_samples;
+    int32_t wav_sample_count;
+    int32_t wav_position;
+#endif
 } IAVoz_AudioProvider_t;
 
-const int32_t kAudioCaptureBufferSize = 80000;
-const int32_t i2s_bytes_to_read = 3200 * 2;
+// In samples, 2 s at 16 kHz after rounding up to a power of two.
+const int32_t kAudioCaptureBufferSize = 32768;
+// One 20 ms slice stride of stereo frames, so new slices are signalled as soon as they are captured.
+const int32_t i2s_bytes_to_read = 320 * 2 * 2;
 
 
 
@@ -45,11 +54,40 @@ bool IAVoz_AudioProvider_Init ( IAVoz_AudioProvider_t ** apptr, IAVoz_ModelSetti
 bool IAVoz_AudioProvider_DeInit ( IAVoz_AudioProvider_t * ap );
 void IAVoz_AudioProvider_Start ( IAVoz_AudioProvider_t * ap );
 void IAVoz_AudioProvider_Stop ( IAVoz_AudioProvider_t * ap );
+// Drops the captured audio and starts over at timestamp 0, as after init. The audio
+// source must be stopped.
+void IAVoz_AudioProvider_Reset ( IAVoz_AudioProvider_t * ap );
+
+// Backend API, implemented by the I2S (device) or WAV (host) audio source
+bool IAVoz_AudioProvider_BackendInit ( IAVoz_AudioProvider_t * ap );
+void IAVoz_AudioProvider_BackendDeInit ( IAVoz_AudioProvider_t * ap );
+
+#if CONFIG_IAVOZ_AUDIO_SOURCE_WAV
+// WAV API, audio is pushed into the capture buffer by the caller instead of an I2S task
+bool IAVoz_AudioProvider_LoadWav ( IAVoz_AudioProvider_t * ap, const char * path );
+int32_t IAVoz_AudioProvider_FeedWav ( IAVoz_AudioProvider_t * ap, int32_t duration_ms );
+bool IAVoz_AudioProvider_IsWavDone ( IAVoz_AudioProvider_t * ap );
+int32_t IAVoz_AudioProvider_WavDurationMs ( IAVoz_AudioProvider_t * ap );
+#endif
 
 
 // TF API
-TfLiteStatus GetAudioSamples( IAVoz_AudioProvider_t * ap , int start_ms, int duration_ms, int *audio_samples_size, int16_t **audio_samples );
+// Points *audio_samples at up to max_slices consecutive windows, read in place from the
+// capture buffer, window i starting i slice strides after *audio_samples. Hands out as
+// many as are captured and contiguous in the capture buffer, at least one, and stores
+// their number in *slices. The windows stay valid until the next call, which moves past
+// them.
+TfLiteStatus GetAudioSlices ( IAVoz_AudioProvider_t * ap, int max_slices, int * slices, const int16_t ** audio_samples );
+
+// Hands the windows of the last call back to the capture buffer right away, instead of
+// on the next call, once the caller is done reading them.
+void ReleaseAudioSlices ( IAVoz_AudioProvider_t * ap );
 
 int32_t LatestAudioTimestamp( IAVoz_AudioProvider_t * ap );
 
+// Blocks on the capture buffer notification until the audio of `slices` more windows
+// past the last one handed out by GetAudioSlices has been captured. Returns false on
+// timeout.
+bool IAVoz_AudioProvider_WaitSlices ( IAVoz_AudioProvider_t * ap, int slices, TickType_t ticks_to_wait );
+
 #endif // IAVOZ_ENABLE
\ No newline at end of file
@@ -0,0 +1,146 @@
+
+#include "ges_iavoz_audio_provider.h"
+#include "sdkconfig.h"
+
+#include "driver/i2s.h"
+#include "esp_timer.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+static const char * TAG = "IAVOZ_AP_I2S";
+
+void IAVoz_AudioProvider_I2STask ( void * vParam );
+
+bool IAVoz_I2SInit ( void ) {
+    // Init I2S
+
+    // Start listening for audio: MONO @ 16KHz
+    i2s_config_t i2s_config = {
+        .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_TX),
+        .sample_rate = 16000,
+        .bits_per_sample = (i2s_bits_per_sample_t)16,
+        .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
+        .intr_alloc_flags = 0,
+        .dma_buf_count = 3,
+        .dma_buf_len = 300,
+        .use_apll = false,
+        .tx_desc_auto_clear = false,
+        .fixed_mclk = -1,
+    };
+
+    i2s_pin_config_t pin_config = {
+        .mck_io_num = I2S_PIN_NO_CHANGE,
+        .bck_io_num = CONFIG_IAVOZ_MIC_I2S_PIN_BCK,    // IIS_SCLK
+        .ws_io_num = CONFIG_IAVOZ_MIC_I2S_PIN_WS,     // IIS_LCLK
+        .data_out_num = I2S_PIN_NO_CHANGE,  // IIS_DSIN
+        .data_in_num = CONFIG_IAVOZ_MIC_I2S_PIN_DIN,   // IIS_DOUT
+    };
+
+    bool success = true;
+    esp_err_t ret = 0;
+
+    ret = i2s_driver_install((i2s_port_t) CONFIG_IAVOZ_MIC_I2S_NUM, &i2s_config, 0, NULL);
+    if (ret != ESP_OK) {
+        success = false;
+        ESP_LOGE(TAG, "Error in i2s_driver_install");
+    }
+
+    ret = i2s_set_pin((i2s_port_t) CONFIG_IAVOZ_MIC_I2S_NUM, &pin_config);
+    if (ret != ESP_OK) {
+        success = false;
+        ESP_LOGE(TAG, "Error in i2s_set_pin");
+    }
+
+    ret = i2s_zero_dma_buffer((i2s_port_t) CONFIG_IAVOZ_MIC_I2S_NUM);
+    if (ret != ESP_OK) {
+        success = false;
+        ESP_LOGE(TAG, "Error in initializing dma buffer with 0");
+    }
+
+    return success;
+}
+
+bool IAVoz_AudioProvider_BackendInit ( IAVoz_AudioProvider_t * ap ) {
+    return IAVoz_I2SInit();
+}
+
+void IAVoz_AudioProvider_BackendDeInit ( IAVoz_AudioProvider_t * ap ) {
+    i2s_driver_uninstall((i2s_port_t) CONFIG_IAVOZ_MIC_I2S_NUM);
+}
+
+void IAVoz_AudioProvider_Start ( IAVoz_AudioProvider_t * ap ) {
+    if ( ap->is_audio_started ) {
+        ESP_LOGW(TAG, "AudioProvider Task already started");
+        return;
+    }
+
+    ap->is_audio_started = true;
+    xTaskCreatePinnedToCore(IAVoz_AudioProvider_I2STask, "AudioProvider_I2STask", CONFIG_IAVOZ_MIC_TASK_STACK_SIZE, (void *) ap, CONFIG_IAVOZ_MIC_TASK_PRIORITY, &(ap->audio_task_handle),
+                            CONFIG_IAVOZ_MIC_TASK_CORE < 0 ? tskNO_AFFINITY : CONFIG_IAVOZ_MIC_TASK_CORE);
+
+    ESP_LOGI(TAG, "AudioProvider Task started");
+}
+
+void IAVoz_AudioProvider_Stop ( IAVoz_AudioProvider_t * ap ) {
+    if ( !ap->is_audio_started ) {
+        ESP_LOGW(TAG, "AudioProvider Task already stopped");
+        return;
+    }
+
+    if ( !ap->audio_task_handle ) {
+        ESP_LOGE(TAG, "AudioProvider Task has NULL handler");
+        return;
+    }
+
+    vTaskDelete(ap->audio_task_handle);
+    ap->audio_task_handle = NULL;
+    ap->is_audio_started = false;
+
+    ESP_LOGI(TAG, "AudioProvider Task stopped");
+}
+
+void IAVoz_AudioProvider_I2STask ( void * vParam ) {
+    IAVoz_AudioProvider_t * ap = (IAVoz_AudioProvider_t *) vParam;
+
+    size_t bytes_read = i2s_bytes_to_read;
+    uint16_t i2s_read_buffer[i2s_bytes_to_read / 2] = {};
+
+    for ( ;; ) {
+        i2s_read((i2s_port_t) GES_IAVOZ_I2S_NUM, (void*)i2s_read_buffer, i2s_bytes_to_read, &bytes_read, 10);
+
+        if (bytes_read <= 0) {
+            ESP_LOGE(TAG, "Error in I2S read : %d", bytes_read);
+        } else {
+            if (bytes_read < i2s_bytes_to_read) {ESP_LOGE(TAG, "Partial I2S read");}
+
+            /* write one channel of the frames read by i2s straight into the ring buffer */
+            const int32_t samples_to_write = bytes_read / 4;
+            int32_t samples_written = 0;
+            int16_t * span;
+            uint32_t span_size;
+
+            IAVoz_RingBuf_WaitAvailable(ap->audio_capture_buffer, samples_to_write, 10);
+            while (samples_written < samples_to_write && (span_size = IAVoz_RingBuf_WriteSpan(ap->audio_capture_buffer, &span)) > 0) {
+                if (span_size > (uint32_t) (samples_to_write - samples_written)) {span_size = samples_to_write - samples_written;}
+                for (uint32_t sample = 0; sample < span_size; sample++) {
+                    span[sample] = (int16_t) i2s_read_buffer[2 * (samples_written + sample)];
+                }
+                IAVoz_RingBuf_Commit(ap->audio_capture_buffer, span_size);
+                samples_written += span_size;
+            }
+
+            /* update the timestamp (in ms) to let the model know that new data has
+            * arrived */
+            ap->latest_audio_timestamp += ((1000 * samples_written) / ap->ms->kAudioSampleFrequency);
+            ap->latest_audio_us = esp_timer_get_time();
+            ESP_LOGD(TAG, "%d-%d-%d-%d", i2s_read_buffer[0], i2s_read_buffer[1], i2s_read_buffer[2], i2s_read_buffer[3]);
+
+            if (samples_written <= 0) {ESP_LOGE(TAG, "Could Not Write in Ring Buffer: %d ", samples_written);} 
+            else if (samples_written < samples_to_write) {ESP_LOGW(TAG, "Partial Write");}
+        }
+    }
+}
+
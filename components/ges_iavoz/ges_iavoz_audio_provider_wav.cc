@@ -0,0 +1,161 @@
+#include "ges_iavoz_audio_provider.h"
+#include "sdkconfig.h"
+
+#if CONFIG_IAVOZ_AUDIO_SOURCE_WAV
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "esp_timer.h"
+
+static const char * TAG = "IAVOZ_AP_WAV";
+
+static uint32_t IAVoz_WavReadLE ( const uint8_t * data, int bytes ) {
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {value = (value << 8) | data[i];}
+    return value;
+}
+
+bool IAVoz_AudioProvider_BackendInit ( IAVoz_AudioProvider_t * ap ) {
+    ap->wav_samples = NULL;
+    ap->wav_sample_count = 0;
+    ap->wav_position = 0;
+    return true;
+}
+
+void IAVoz_AudioProvider_BackendDeInit ( IAVoz_AudioProvider_t * ap ) {
+    if (ap->wav_samples) {free(ap->wav_samples);}
+    ap->wav_samples = NULL;
+}
+
+void IAVoz_AudioProvider_Start ( IAVoz_AudioProvider_t * ap ) {
+    // Nothing to spawn, samples are pushed by IAVoz_AudioProvider_FeedWav.
+    ap->is_audio_started = true;
+}
+
+void IAVoz_AudioProvider_Stop ( IAVoz_AudioProvider_t * ap ) {
+    ap->is_audio_started = false;
+}
+
+bool IAVoz_AudioProvider_LoadWav ( IAVoz_AudioProvider_t * ap, const char * path ) {
+    FILE * file = fopen(path, "rb");
+    if (!file) {
+        ESP_LOGE(TAG, "Could not open %s", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t * raw = (uint8_t *) malloc(file_size > 0 ? file_size : 1);
+    if (!raw) {
+        ESP_LOGE(TAG, "Error allocating %ld bytes for %s", file_size, path);
+        fclose(file);
+        return false;
+    }
+
+    size_t raw_size = fread(raw, 1, file_size, file);
+    fclose(file);
+
+    if (raw_size < 12 || memcmp(raw, "RIFF", 4) || memcmp(raw + 8, "WAVE", 4)) {
+        ESP_LOGE(TAG, "%s is not a RIFF/WAVE file", path);
+        free(raw);
+        return false;
+    }
+
+    uint32_t format = 0, channels = 0, sample_rate = 0, bits = 0;
+    const uint8_t * data = NULL;
+    uint32_t data_size = 0;
+
+    // Walk the chunk list, we only care about "fmt " and "data".
+    size_t offset = 12;
+    while (offset + 8 <= raw_size) {
+        const uint8_t * chunk = raw + offset;
+        uint32_t chunk_size = IAVoz_WavReadLE(chunk + 4, 4);
+        if (chunk_size > raw_size - offset - 8) {chunk_size = raw_size - offset - 8;}
+
+        if (!memcmp(chunk, "fmt ", 4) && chunk_size >= 16) {
+            format = IAVoz_WavReadLE(chunk + 8, 2);
+            channels = IAVoz_WavReadLE(chunk + 10, 2);
+            sample_rate = IAVoz_WavReadLE(chunk + 12, 4);
+            bits = IAVoz_WavReadLE(chunk + 22, 2);
+        } else if (!memcmp(chunk, "data", 4)) {
+            data = chunk + 8;
+            data_size = chunk_size;
+        }
+
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    if (format != 1 || bits != 16 || channels == 0 || !data) {
+        ESP_LOGE(TAG, "%s must be 16 bit PCM (format %u, %u bits, %u channels)", path, format, bits, channels);
+        free(raw);
+        return false;
+    }
+
+    if (sample_rate != (uint32_t) ap->ms->kAudioSampleFrequency) {
+        ESP_LOGE(TAG, "%s is sampled at %u Hz, expected %d Hz", path, sample_rate, ap->ms->kAudioSampleFrequency);
+        free(raw);
+        return false;
+    }
+
+    int32_t sample_count = data_size / (2 * channels);
+    int16_t * samples = (int16_t *) malloc(sizeof(int16_t) * (sample_count > 0 ? sample_count : 1));
+    if (!samples) {
+        ESP_LOGE(TAG, "Error allocating samples for %s", path);
+        free(raw);
+        return false;
+    }
+
+    // Keep the first channel only, as the I2S task does with the microphone frames.
+    for (int32_t i = 0; i < sample_count; i++) {
+        samples[i] = (int16_t) IAVoz_WavReadLE(data + 2 * channels * i, 2);
+    }
+    free(raw);
+
+    if (ap->wav_samples) {free(ap->wav_samples);}
+    ap->wav_samples = samples;
+    ap->wav_sample_count = sample_count;
+    ap->wav_position = 0;
+
+    ESP_LOGD(TAG, "Loaded %s: %d samples", path, sample_count);
+    return true;
+}
+
+int32_t IAVoz_AudioProvider_FeedWav ( IAVoz_AudioProvider_t * ap, int32_t duration_ms ) {
+    if (!ap->wav_samples) {return 0;}
+
+    int32_t samples_to_write = duration_ms * (ap->ms->kAudioSampleFrequency / 1000);
+    int32_t samples_left = ap->wav_sample_count - ap->wav_position;
+    if (samples_to_write > samples_left) {samples_to_write = samples_left;}
+    if (samples_to_write <= 0) {return 0;}
+
+    /* write the next samples into the ring buffer, never block: the caller drives the clock */
+    int32_t samples_written = IAVoz_RingBuf_Write(ap->audio_capture_buffer, ap->wav_samples + ap->wav_position, samples_to_write, 0);
+    if (samples_written <= 0) {
+        ESP_LOGW(TAG, "Capture buffer full, dropping feed of %d ms", duration_ms);
+        return 0;
+    }
+
+    ap->wav_position += samples_written;
+
+    /* update the timestamp (in ms) exactly as the I2S task does */
+    int32_t fed_ms = (1000 * samples_written) / ap->ms->kAudioSampleFrequency;
+    ap->latest_audio_timestamp += fed_ms;
+    ap->latest_audio_us = esp_timer_get_time();
+
+    return fed_ms;
+}
+
+bool IAVoz_AudioProvider_IsWavDone ( IAVoz_AudioProvider_t * ap ) {
+    return ap->wav_position >= ap->wav_sample_count;
+}
+
+int32_t IAVoz_AudioProvider_WavDurationMs ( IAVoz_AudioProvider_t * ap ) {
+    return (int32_t) ((1000LL * ap->wav_sample_count) / ap->ms->kAudioSampleFrequency);
+}
+
+#endif // CONFIG_IAVOZ_AUDIO_SOURCE_WAV
@@ -45,8 +45,10 @@ RecognizeCommands::RecognizeCommands(tflite::ErrorReporter* error_reporter,
 TfLiteStatus RecognizeCommands::ProcessLatestResults(
             const TfLiteTensor* latest_results, const int32_t current_time_ms,
             IAVOZ_KEY_t* found_command, uint8_t* score, bool* is_new_command, 
-            uint8_t* found_index) {
+            uint8_t* found_index, IAVOZ_KEY_t* activated) {
     
+    *activated = IAVOZ_KEY_NULL;
+
     if ((latest_results->dims->size != 2) || (latest_results->dims->data[0] != 1) || (latest_results->dims->data[1] != kCategoryCount)) {
         TF_LITE_REPORT_ERROR(error_reporter_,
             "The results for recognition should contain %d elements, but there are %d in an %d-dimensional shape",
@@ -85,7 +87,9 @@ TfLiteStatus RecognizeCommands::ProcessLatestResults(
         *found_command = previous_top_label_;
         *score = 0;
         *is_new_command = false;
+#if CONFIG_IAVOZ_RECOGNIZER_LOG_SCORES
         printf("Too few results %lld\n", how_many_results);
+#endif
         return kTfLiteOk;
     }
 
@@ -126,6 +130,7 @@ TfLiteStatus RecognizeCommands::ProcessLatestResults(
         time_since_last_top = current_time_ms - previous_top_label_time_;
     }
 
+#if CONFIG_IAVOZ_RECOGNIZER_LOG_SCORES
     std::cout << std::setprecision(2) << std::fixed;
     std::cout << "SCORES " << current_time_ms << "ms";
     for (int i = 0; i < kCategoryCount; ++i) 
@@ -133,6 +138,7 @@ TfLiteStatus RecognizeCommands::ProcessLatestResults(
     std::cout << "\t " << kCategoryLabels[i] << ": " << 100*(((float)average_scores[i]) / ((float)253)) << "% ";
     std::cout << "\t top label: " << current_top_label << " " << 100*((float)current_top_score / (float)253) << "%";
     std::cout << std::endl;
+#endif
 
     *is_new_command = false;
 
@@ -169,30 +175,13 @@ TfLiteStatus RecognizeCommands::ProcessLatestResults(
     if (current_top_label == previous_top_label_)    {return kTfLiteOk;}
     
     previous_top_label_ = current_top_label;
-    std::cout << "Activation " << current_top_label << std::endl;
-    return kTfLiteOk;
-    
-    if (current_top_label == IAVOZ_KEY_HEYLOLA && !activation) {
-        if (current_top_score < detection_threshold_) {weak_activation = true; /*std::cout << "Weak ";*/}
-        
-        activation = true;
-        previous_top_label_time_ = current_time_ms;
-        std::cout << "Activation" << std::endl;
-    } else if (current_top_label != IAVOZ_KEY_HEYLOLA && current_top_label != IAVOZ_KEY_NULL && activation) {
-        if (weak_activation && current_top_score < detection_threshold_) {return kTfLiteOk;}
-        // if (current_top_score < detection_threshold_) {std::cout << "Weak ";}
-
-        *is_new_command = true;
-        activation = false;
-        previous_top_label_time_ = std::numeric_limits<int32_t>::min();
-        std::cout << "Command " << current_top_label << std::endl;
-    }
-
-    previous_top_label_ = current_top_label;
-
+    *activated = current_top_label;
     *found_command = current_top_label;
     *score = current_top_score;
     *found_index = current_top_index;
+#if CONFIG_IAVOZ_RECOGNIZER_LOG_SCORES
+    std::cout << "Activation " << current_top_label << std::endl;
+#endif
 
     return kTfLiteOk;
 }
@@ -138,12 +138,15 @@ class RecognizeCommands {
                              uint8_t weak_detection_threshold = 100,
                              int32_t suppression_ms = 250);
 
-  // Call this with the results of running a model on sample data.
+  // Call this with the results of running a model on sample data. activated
+  // gets the keyword when these results trigger an activation, IAVOZ_KEY_NULL
+  // otherwise; found_command can repeat an earlier keyword.
   TfLiteStatus ProcessLatestResults(const TfLiteTensor* latest_results,
                                     const int32_t current_time_ms,
                                     IAVOZ_KEY_t* found_command, uint8_t* score,
                                     bool* is_new_command,
-                                    uint8_t* found_index);
+                                    uint8_t* found_index,
+                                    IAVOZ_KEY_t* activated);
   // bool activation;
   
  private:
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "ges_iavoz_feature_provider.h"
+#include "ges_iavoz_filterbank_table.h"
 
 
 
@@ -29,10 +30,9 @@ limitations under the License.
 static const char *TAG = "IAVOZ_FP";
 
 
-TfLiteStatus InitializeMicroFeatures( IAVoz_FeatureProvider_t * fp );
-TfLiteStatus GenerateMicroFeatures ( IAVoz_FeatureProvider_t * fp, const int16_t* input, int input_size, int output_size, int8_t* output, size_t* num_samples_read, int32_t* STP);
+TfLiteStatus InitializeMicroFeatures( IAVoz_FeatureProvider_t * fp, TfLiteQuantizationParams input_params );
 
-bool IAVoz_FeatureProvider_Init ( IAVoz_FeatureProvider_t ** fpptr, IAVoz_ModelSettings_t * ms ) {
+bool IAVoz_FeatureProvider_Init ( IAVoz_FeatureProvider_t ** fpptr, IAVoz_ModelSettings_t * ms, TfLiteQuantizationParams input_params ) {
     IAVoz_FeatureProvider_t * fp = (IAVoz_FeatureProvider_t *) malloc (sizeof(IAVoz_FeatureProvider_t));
     (*fpptr) = fp;
     if ( !fp ) {
@@ -53,6 +53,7 @@ bool IAVoz_FeatureProvider_Init ( IAVoz_FeatureProvider_t ** fpptr, IAVoz_ModelS
         return false;
     }
 
+#if !CONFIG_IAVOZ_VAD_FRONTEND
     fp->vad = fvad_new();
     if (!fp->vad) {
         ESP_LOGE(TAG, "Error allocating Fvad");
@@ -61,23 +62,44 @@ bool IAVoz_FeatureProvider_Init ( IAVoz_FeatureProvider_t ** fpptr, IAVoz_ModelS
 
     fvad_set_sample_rate(fp->vad, fp->ms->kAudioSampleFrequency);
     fvad_set_mode(fp->vad, 2);
+#endif
 
-    fp->voices_in_frame = (bool*) malloc(sizeof(bool)*fp->ms->kFeatureSliceCount);
+    fp->voices_in_frame = (uint8_t*) malloc(fp->ms->kFeatureSliceCount);
     if (!fp->voices_in_frame) {
         ESP_LOGE(TAG, "Error allocating space for voices in frame array");
         return false;
     }
 
     fp->voices_write_pointer = 0;
+    fp->feature_write_pointer = 0;
+    fp->is_first_run = true;
 
     memset(fp->feature_data, 0, fp->ms->kFeatureElementCount);
-    memset(fp->voices_in_frame, 0, sizeof(bool)*fp->ms->kFeatureSliceCount);
+    memset(fp->voices_in_frame, 0, fp->ms->kFeatureSliceCount);
 
-    InitializeMicroFeatures( fp );
+    if (InitializeMicroFeatures( fp, input_params ) != kTfLiteOk) {return false;}
 
     return true;
 }
 
+void IAVoz_FeatureProvider_Reset ( IAVoz_FeatureProvider_t * fp ) {
+    fp->voices_write_pointer = 0;
+    fp->feature_write_pointer = 0;
+    fp->is_first_run = true;
+
+    memset(fp->feature_data, 0, fp->ms->kFeatureElementCount);
+    memset(fp->voices_in_frame, 0, fp->ms->kFeatureSliceCount);
+
+    FrontendReset(&(fp->frontend_state));
+
+#if !CONFIG_IAVOZ_VAD_FRONTEND
+    // fvad_reset goes back to its default rate and mode as well.
+    fvad_reset(fp->vad);
+    fvad_set_sample_rate(fp->vad, fp->ms->kAudioSampleFrequency);
+    fvad_set_mode(fp->vad, 2);
+#endif
+}
+
 bool IAVoz_FeatureProvider_DeInit ( IAVoz_FeatureProvider_t * fp ) {
     if (!fp ) {
         ESP_LOGE(TAG, "Failed to de-init Feature Provider");
@@ -87,8 +109,10 @@ bool IAVoz_FeatureProvider_DeInit ( IAVoz_FeatureProvider_t * fp ) {
     if ( !fp->feature_data ) {ESP_LOGW(TAG, "Null feature data");} 
     else {free(fp->feature_data);}
 
+#if !CONFIG_IAVOZ_VAD_FRONTEND
     if (!fp->vad) {ESP_LOGW(TAG, "Null Fvad");}
     else {fvad_free(fp->vad);}
+#endif
 
     if (!fp->voices_in_frame) {ESP_LOGW(TAG, "Null voices in frame");}
     else {free(fp->voices_in_frame);}
@@ -99,10 +123,15 @@ bool IAVoz_FeatureProvider_DeInit ( IAVoz_FeatureProvider_t * fp ) {
     return true;
 }
 
+void IAVoz_FeatureProvider_CopyWindow ( IAVoz_FeatureProvider_t * fp, int8_t * output ) {
+    const int oldest = fp->feature_write_pointer * fp->ms->kFeatureSliceSize;
+    memcpy(output, fp->feature_data + oldest, fp->ms->kFeatureElementCount - oldest);
+    memcpy(output + fp->ms->kFeatureElementCount - oldest, fp->feature_data, oldest);
+}
+
 TfLiteStatus IAVoz_FeatureProvider_PopulateFeatureData (IAVoz_FeatureProvider_t * fp, IAVoz_AudioProvider_t * ap, 
-        int32_t last_time_in_ms, int32_t time_in_ms, int* how_many_new_slices, float* STP) {
+        int32_t last_time_in_ms, int32_t time_in_ms, int* how_many_new_slices, int32_t* STP) {
 
-    static bool is_first_run_ = true;
     // Quantize the time into steps as long as each window stride, so we can
     // figure out which audio data we need to fetch.
     const int last_step = (last_time_in_ms / fp->ms->kFeatureSliceStrideMs);
@@ -111,8 +140,8 @@ TfLiteStatus IAVoz_FeatureProvider_PopulateFeatureData (IAVoz_FeatureProvider_t
     int slices_needed = current_step - last_step;
     // If this is the first call, make sure we don't use any cached information.
 
-    if (is_first_run_) {
-        is_first_run_ = false;
+    if (fp->is_first_run) {
+        fp->is_first_run = false;
         slices_needed = fp->ms->kFeatureSliceCount;
     }
 
@@ -121,58 +150,54 @@ TfLiteStatus IAVoz_FeatureProvider_PopulateFeatureData (IAVoz_FeatureProvider_t
     *how_many_new_slices = slices_needed;
 
     const int slices_to_keep = fp->ms->kFeatureSliceCount - slices_needed;
-    const int slices_to_drop = fp->ms->kFeatureSliceCount - slices_to_keep;
 
-    // If we can avoid recalculating some slices, just move the existing data
-    // up in the spectrogram, to perform something like this:
+    // The window is a ring of slices, new slices overwrite the oldest ones in place
+    // instead of moving the kept ones up:
     // last time = 80ms          current time = 120ms
     // +-----------+             +-----------+
-    // | data@20ms |         --> | data@60ms |
-    // +-----------+       --    +-----------+
-    // | data@40ms |     --  --> | data@80ms |
-    // +-----------+   --  --    +-----------+
-    // | data@60ms | --  --      |  <empty>  |
-    // +-----------+   --        +-----------+
-    // | data@80ms | --          |  <empty>  |
+    // | data@20ms | <- write    | data@100ms|
+    // +-----------+             +-----------+
+    // | data@40ms |             | data@120ms|
+    // +-----------+             +-----------+
+    // | data@60ms |             | data@60ms | <- write
+    // +-----------+             +-----------+
+    // | data@80ms |             | data@80ms |
     // +-----------+             +-----------+
-
-    if (slices_to_keep > 0) {
-        for (int dest_slice = 0; dest_slice < slices_to_keep; ++dest_slice) {
-            int8_t* dest_slice_data = fp->feature_data + (dest_slice * fp->ms->kFeatureSliceSize);
-            const int src_slice = dest_slice + slices_to_drop;
-            const int8_t* src_slice_data = fp->feature_data + (src_slice * fp->ms->kFeatureSliceSize);
-            
-            for (int i = 0; i < fp->ms->kFeatureSliceSize; ++i) {
-                dest_slice_data[i] = src_slice_data[i];
-            }
-        }
-    }
 
     // Any slices that need to be filled in with feature data have their
     // appropriate audio data pulled, and features calculated for that slice.
-    if (slices_needed > 0) {
-        for (int new_slice = slices_to_keep; new_slice < fp->ms->kFeatureSliceCount; ++new_slice) {
-            const int new_step = (current_step - fp->ms->kFeatureSliceCount + 1) + new_slice;
-            const int32_t slice_start_ms = (new_step * fp->ms->kFeatureSliceStrideMs);
-            int16_t* audio_samples = nullptr;
-            int audio_samples_size = 0;
-            int vadres;
-
-            // TODO(petewarden): Fix bug that leads to non-zero slice_start_ms
-            GetAudioSamples(ap, (slice_start_ms > 0 ? slice_start_ms : 0),
-                            fp->ms->kFeatureSliceDurationMs, &audio_samples_size,
-                            &audio_samples);
-
-            if (audio_samples_size < fp->ms->kMaxAudioSampleSize) {
-                ESP_LOGE(TAG, "Audio data size %d too small, want %d", audio_samples_size, fp->ms->kMaxAudioSampleSize);
-                return kTfLiteError;
-            }
+    // The windows that are already captured and contiguous in the capture buffer
+    // are taken together and run through the frontend in one go.
+    const int window_samples = fp->ms->kFeatureSliceDurationMs * (fp->ms->kAudioSampleFrequency / 1000);
+    const int stride_samples = fp->ms->kFeatureSliceStrideMs * (fp->ms->kAudioSampleFrequency / 1000);
+    int new_slice = slices_to_keep;
+    while (new_slice < fp->ms->kFeatureSliceCount) {
+        const int16_t* audio_samples = nullptr;
+        int slices = 0;
+
+        if (GetAudioSlices(ap, fp->ms->kFeatureSliceCount - new_slice, &slices, &audio_samples) != kTfLiteOk) {
+            ESP_LOGD(TAG, "Audio data for slice %d not captured yet", new_slice);
+            // Report the slices already taken from the capture buffer, so the caller stays in step with it.
+            *how_many_new_slices = new_slice - slices_to_keep;
+            return kTfLiteError;
+        }
+
+        // On failure the slices taken are dropped: they are released and reported to the
+        // caller, so it stays in step with the capture buffer, and the voice flags are
+        // rewound, so they stay in step with the features.
+        const int voices_write_pointer = fp->voices_write_pointer;
+        const int how_many_taken = new_slice + slices - slices_to_keep;
 
+#if !CONFIG_IAVOZ_VAD_FRONTEND
+        for (int slice = 0; slice < slices; slice++) {
             // fvad only accepts frames of 30ms (480 samples @ 16kHz)
-            vadres = fvad_process(fp->vad, audio_samples, fp->ms->kFeatureSliceDurationMs*fp->ms->kAudioSampleFrequency/1000);
+            int vadres = fvad_process(fp->vad, audio_samples + slice * stride_samples, window_samples);
 
             if (vadres < 0) {
                 ESP_LOGE(TAG, "fvad process faied with error: %d", vadres);
+                ReleaseAudioSlices(ap);
+                fp->voices_write_pointer = voices_write_pointer;
+                *how_many_new_slices = how_many_taken;
                 return kTfLiteApplicationError;
             }
 
@@ -180,13 +205,19 @@ TfLiteStatus IAVoz_FeatureProvider_PopulateFeatureData (IAVoz_FeatureProvider_t
 
             fp->voices_in_frame[fp->voices_write_pointer] = vadres;
             fp->voices_write_pointer = (fp->voices_write_pointer + 1) % fp->ms->kFeatureSliceCount;
+        }
+#endif
+
+        TfLiteStatus generate_status = GenerateMicroFeatures(fp, audio_samples, slices, STP);
+        ReleaseAudioSlices(ap);
+        if (generate_status != kTfLiteOk) {
+            fp->voices_write_pointer = voices_write_pointer;
+            *how_many_new_slices = how_many_taken;
+            return generate_status;
+        }
 
-            int8_t* new_slice_data = fp->feature_data + (new_slice * fp->ms->kFeatureSliceSize);
-            size_t num_samples_read;
-            TfLiteStatus generate_status = GenerateMicroFeatures(
-                fp, audio_samples, audio_samples_size, fp->ms->kFeatureSliceSize,
-                new_slice_data, &num_samples_read, STP);
-            
+        for (int slice = 0; slice < slices; slice++) {
+            int8_t* new_slice_data = fp->feature_data + (fp->feature_write_pointer * fp->ms->kFeatureSliceSize);
             int8_t max_bank = 0;
             int16_t max_value = new_slice_data[0];
             int32_t low_band_power = 0;
@@ -200,17 +231,22 @@ TfLiteStatus IAVoz_FeatureProvider_PopulateFeatureData (IAVoz_FeatureProvider_t
                 if (6 < sample && sample < 13) {low_band_power += new_slice_data[sample];}
                 if (12 < sample && sample < 19) {mid_band_power += new_slice_data[sample];}
             }
-    
+
             // UpdateState(fp, STP, ZCR, max_bank, low_band_power, mid_band_power);
-            
-            if (generate_status != kTfLiteOk) {return generate_status;}         
+
+            fp->feature_write_pointer = (fp->feature_write_pointer + 1) % fp->ms->kFeatureSliceCount;
+#if CONFIG_IAVOZ_VAD_FRONTEND
+            // The frontend wrote the decisions next to the features.
+            fp->voices_write_pointer = fp->feature_write_pointer;
+#endif
         }
+        new_slice += slices;
     }
 
     return kTfLiteOk;
 }
 
-TfLiteStatus InitializeMicroFeatures( IAVoz_FeatureProvider_t * fp ) 
+TfLiteStatus InitializeMicroFeatures( IAVoz_FeatureProvider_t * fp, TfLiteQuantizationParams input_params ) 
 {
     FrontendConfig config;
     config.window.size_ms = fp->ms->kFeatureSliceDurationMs;
@@ -219,6 +255,15 @@ TfLiteStatus InitializeMicroFeatures( IAVoz_FeatureProvider_t * fp )
     config.filterbank.num_channels = fp->ms->kFeatureSliceSize;
     config.filterbank.lower_band_limit = 125.0;
     config.filterbank.upper_band_limit = 7500.0;
+    // Generated by iavoz_filterbank_gen, used when the model settings match it.
+    config.filterbank.table = &kIAVozFilterbankTable;
+#if CONFIG_IAVOZ_FRONTEND_LUT_MATH
+    config.filterbank.lut_sqrt = 1;
+    config.log_scale.lut_log = 1;
+#else
+    config.filterbank.lut_sqrt = 0;
+    config.log_scale.lut_log = 0;
+#endif
     config.noise_reduction.smoothing_bits = 10;
     config.noise_reduction.even_smoothing = 0.025;
     config.noise_reduction.odd_smoothing = 0.06;
@@ -229,6 +274,31 @@ TfLiteStatus InitializeMicroFeatures( IAVoz_FeatureProvider_t * fp )
     config.pcan_gain_control.gain_bits = 21;
     config.log_scale.enable_log = 1;
     config.log_scale.scale_shift = 6;
+    // These scaling values are derived from those used in input_data.py in the
+    // training pipeline.
+    // The feature pipeline outputs 16-bit signed integers in roughly a 0 to 670
+    // range. In training, these are then arbitrarily divided by 25.6 to get
+    // float values in the rough range of 0.0 to 26.0. This scaling is performed
+    // for historical reasons, to match up with the output of other feature
+    // generators. The model then takes them divided by 26.0 again, quantized
+    // with the scale and zero point of its input tensor, so one step of the
+    // int8 input is (25.6 * 26.0) * scale frontend units. 25.6 * 26.0 is
+    // rounded to an integer as the quantization always did.
+    constexpr int32_t value_div = static_cast<int32_t>((25.6f * 26.0f) + 0.5f);
+    config.log_scale.int8_step = value_div * input_params.scale;
+    config.log_scale.int8_zero_point = input_params.zero_point;
+#if CONFIG_IAVOZ_VAD_FRONTEND
+    // Voice is decided from the filterbank against the noise reduction estimate, instead of
+    // running fvad's own filters over the same audio.
+    config.voice_activity.enable_vad = 1;
+    config.voice_activity.snr_db = CONFIG_IAVOZ_VAD_FRONTEND_SNR_DB;
+    config.voice_activity.min_signal = 40.0;
+    config.voice_activity.min_voiced_channels = 0.25;
+    config.voice_activity.warmup_frames = 40;
+    config.voice_activity.hangover_frames = 20;
+#else
+    config.voice_activity.enable_vad = 0;
+#endif
 
     if (!FrontendPopulateState(&config, &(fp->frontend_state), fp->ms->kAudioSampleFrequency)) 
     {
@@ -239,49 +309,26 @@ TfLiteStatus InitializeMicroFeatures( IAVoz_FeatureProvider_t * fp )
     return kTfLiteOk;
 }
 
-TfLiteStatus GenerateMicroFeatures ( IAVoz_FeatureProvider_t * fp, const int16_t* input, int input_size, int output_size, int8_t* output, size_t* num_samples_read, float* STP) {
-    const int16_t* frontend_input;
-    static bool g_is_first_time = true;
-    if (g_is_first_time) {
-        frontend_input = input;
-        g_is_first_time = false;
-    } else {
-        frontend_input = input + 160;
+TfLiteStatus GenerateMicroFeatures ( IAVoz_FeatureProvider_t * fp, const int16_t* input, int slices, int32_t* STP) {
+    const int slice_size = fp->ms->kFeatureSliceSize;
+    const size_t step = fp->frontend_state.window.step;
+
+    for (int done = 0; done < slices; ) {
+        // The frontend writes the quantized slices straight into the ring, up to its end.
+        const int slot = (fp->feature_write_pointer + done) % fp->ms->kFeatureSliceCount;
+        int batch = fp->ms->kFeatureSliceCount - slot;
+        if (batch > slices - done) {batch = slices - done;}
+
+        // input holds the windows back to back, the frontend reads them in place.
+        *STP = FrontendProcessFramesInt8(&(fp->frontend_state), input + done * step, batch,
+                                         fp->feature_data + slot * slice_size,
+#if CONFIG_IAVOZ_VAD_FRONTEND
+                                         fp->voices_in_frame + slot);
+#else
+                                         nullptr);
+#endif
+        done += batch;
     }
-    
-    FrontendOutput frontend_output = FrontendProcessSamples(&(fp->frontend_state), frontend_input, input_size, num_samples_read);
-
-
-    *STP = 0;
-    for (size_t i = 0; i < frontend_output.size; ++i) {
-    // These scaling values are derived from those used in input_data.py in the
-    // training pipeline.
-    // The feature pipeline outputs 16-bit signed integers in roughly a 0 to 670
-    // range. In training, these are then arbitrarily divided by 25.6 to get
-    // float values in the rough range of 0.0 to 26.0. This scaling is performed
-    // for historical reasons, to match up with the output of other feature
-    // generators.
-    // The process is then further complicated when we quantize the model. This
-    // means we have to scale the 0.0 to 26.0 real values to the -128 to 127
-    // signed integer numbers.
-    // All this means that to get matching values from our integer feature
-    // output into the tensor input, we have to perform:
-    // input = (((feature / 25.6) / 26.0) * 256) - 128
-    // To simplify this and perform it in 32-bit integer math, we rearrange to:
-    // input = (feature * 256) / (25.6 * 26.0) - 128
-        constexpr int32_t value_scale = 256;
-        constexpr int32_t value_div = static_cast<int32_t>((25.6f * 26.0f) + 0.5f);
-        int32_t value = ((frontend_output.values[i] * value_scale) + (value_div / 2)) / value_div;
-        value -= 128;
-        
-        if (value < -128) {value = -128;}
-        if (value > 127) {value = 127;}
-        
-        output[i] = value;
-        *STP += frontend_output.values[i];
-    }
-
-    *STP /= frontend_output.size;
 
     return kTfLiteOk;
 }
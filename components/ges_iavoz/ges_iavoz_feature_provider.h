@@ -4,6 +4,7 @@
 #include "tensorflow/lite/c/common.h"
 
 #include "esp_log.h"
+#include "sdkconfig.h"
 
 #include "ges_iavoz_audio_provider.h"
 #include "ges_iavoz_model_settings.h"
@@ -15,22 +16,39 @@
 #include <fvad.h>
 
 typedef struct {
+    // Ring of kFeatureSliceCount slices, feature_write_pointer is the oldest one.
     int8_t * feature_data;
+    uint8_t feature_write_pointer;
     IAVoz_ModelSettings_t * ms;
     struct FrontendState frontend_state;
+#if !CONFIG_IAVOZ_VAD_FRONTEND
     Fvad* vad;
-    bool* voices_in_frame;
+#endif
+    // Ring of kFeatureSliceCount VAD decisions, one per slice.
+    uint8_t* voices_in_frame;
     uint8_t voices_write_pointer;
+    // Nothing in the window yet, the next call fills all of it.
+    bool is_first_run;
 } IAVoz_FeatureProvider_t;
 
 // GES API
-bool IAVoz_FeatureProvider_Init ( IAVoz_FeatureProvider_t ** fpptr, IAVoz_ModelSettings_t * ms );
+// input_params are the quantization of the model input, the features are written with it.
+bool IAVoz_FeatureProvider_Init ( IAVoz_FeatureProvider_t ** fpptr, IAVoz_ModelSettings_t * ms, TfLiteQuantizationParams input_params );
 bool IAVoz_FeatureProvider_DeInit ( IAVoz_FeatureProvider_t * fp );
+// Empties the window and the frontend and VAD state, as after init.
+void IAVoz_FeatureProvider_Reset ( IAVoz_FeatureProvider_t * fp );
+
+// Writes the window to output (e.g. the model input tensor) from the oldest to the newest slice.
+void IAVoz_FeatureProvider_CopyWindow ( IAVoz_FeatureProvider_t * fp, int8_t * output );
 
 
 // TF API
-TfLiteStatus IAVoz_FeatureProvider_PopulateFeatureData ( IAVoz_FeatureProvider_t * fp, IAVoz_AudioProvider_t * ap, int32_t last_time_in_ms, int32_t time_in_ms, int* how_many_new_slices, float* STP);
-TfLiteStatus GenerateMicroFeatures ( IAVoz_FeatureProvider_t * fp, const int16_t* input, int input_size, int output_size, int8_t* output, size_t* num_samples_read, float* STP);
+TfLiteStatus IAVoz_FeatureProvider_PopulateFeatureData ( IAVoz_FeatureProvider_t * fp, IAVoz_AudioProvider_t * ap, int32_t last_time_in_ms, int32_t time_in_ms, int* how_many_new_slices, int32_t* STP);
+// Computes slices consecutive slices from the windows at input, one slice stride apart, into
+// the ring from feature_write_pointer on, without moving it. STP is the sum of the frontend
+// outputs of the last slice. With CONFIG_IAVOZ_VAD_FRONTEND the frontend VAD decisions go to
+// voices_in_frame at the same positions.
+TfLiteStatus GenerateMicroFeatures ( IAVoz_FeatureProvider_t * fp, const int16_t* input, int slices, int32_t* STP);
 
 
 
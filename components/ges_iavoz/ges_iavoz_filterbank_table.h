@@ -0,0 +1,67 @@
+// Generated by iavoz_filterbank_gen, do not edit: 40 channels over 125-7500 Hz,
+// 16000 Hz audio, 257 spectrum bins.
+
+#ifndef GES_IAVOZ_FILTERBANK_TABLE_H
+#define GES_IAVOZ_FILTERBANK_TABLE_H
+
+#include "tensorflow/lite/experimental/microfrontend/lib/filterbank.h"
+
+static const int16_t kIAVozFilterbankChannelWidths[41] = {
+    1, 2, 1, 2, 2, 2, 2, 2, 3, 2, 3, 3,
+    3, 3, 3, 4, 4, 3, 5, 4, 5, 5, 5, 5,
+    6, 6, 7, 7, 7, 8, 8, 9, 9, 9, 11, 10,
+    12, 12, 13, 13, 15,
+};
+
+static const int16_t kIAVozFilterbankWeights[236] = {
+    1377, 2852, 321, 1971, 3701, 1408, 3281, 1124, 3124, 1087, 3201, 1272,
+    3488, 1655, 3963, 2218, 513, 2943, 1314, 3817, 2258, 731, 3332, 1866,
+    430, 3117, 1734, 377, 3141, 1833, 548, 3381, 2139, 918, 3814, 2632,
+    1470, 325, 3294, 2185, 1092, 15, 3049, 2003, 972, 4051, 3048, 2058,
+    1082, 118, 3263, 2324, 1398, 482, 3674, 2782, 1899, 1028, 167, 3411,
+    2570, 1738, 915, 102, 3393, 2598, 1810, 1032, 261, 3594, 2840, 2093,
+    1353, 621, 3993, 3275, 2564, 1861, 1163, 473, 3885, 3207, 2536, 1870,
+    1211, 557, 4006, 3364, 2727, 2096, 1471, 850, 235, 3721, 3117, 2517,
+    1922, 1331, 746, 165, 3685, 3113, 2546, 1983, 1424, 870, 320, 3869,
+    3327, 2789, 2255, 1725, 1198, 676, 157, 3737, 3226, 2717, 2213, 1711,
+    1214, 719, 228, 3836, 3352, 2870, 2392, 1917, 1445, 976, 510, 46,
+    3682, 3225, 2770, 2319, 1870, 1424, 980, 539, 101, 3762, 3329, 2898,
+    2470, 2045, 1622, 1202, 784, 368, 4050, 3639, 3231, 2824, 2420, 2018,
+    1618, 1220, 825, 432, 40, 3747, 3360, 2975, 2592, 2211, 1832, 1455,
+    1079, 706, 335, 4061, 3693, 3328, 2964, 2601, 2241, 1882, 1526, 1170,
+    817, 465, 115, 3863, 3516, 3171, 2827, 2486, 2145, 1807, 1469, 1134,
+    800, 467, 136, 3903, 3575, 3248, 2923, 2599, 2277, 1956, 1636, 1318,
+    1002, 686, 372, 60, 3844, 3534, 3226, 2918, 2612, 2307, 2004, 1702,
+    1400, 1101, 802, 505, 208, 4010, 3716, 3423, 3132, 2841, 2552, 2264,
+    1977, 1692, 1407, 1123, 841, 560, 279, 0,
+};
+
+static const int16_t kIAVozFilterbankUnweights[236] = {
+    2719, 1244, 3775, 2125, 395, 2688, 815, 2972, 972, 3009, 895, 2824,
+    608, 2441, 133, 1878, 3583, 1153, 2782, 279, 1838, 3365, 764, 2230,
+    3666, 979, 2362, 3719, 955, 2263, 3548, 715, 1957, 3178, 282, 1464,
+    2626, 3771, 802, 1911, 3004, 4081, 1047, 2093, 3124, 45, 1048, 2038,
+    3014, 3978, 833, 1772, 2698, 3614, 422, 1314, 2197, 3068, 3929, 685,
+    1526, 2358, 3181, 3994, 703, 1498, 2286, 3064, 3835, 502, 1256, 2003,
+    2743, 3475, 103, 821, 1532, 2235, 2933, 3623, 211, 889, 1560, 2226,
+    2885, 3539, 90, 732, 1369, 2000, 2625, 3246, 3861, 375, 979, 1579,
+    2174, 2765, 3350, 3931, 411, 983, 1550, 2113, 2672, 3226, 3776, 227,
+    769, 1307, 1841, 2371, 2898, 3420, 3939, 359, 870, 1379, 1883, 2385,
+    2882, 3377, 3868, 260, 744, 1226, 1704, 2179, 2651, 3120, 3586, 4050,
+    414, 871, 1326, 1777, 2226, 2672, 3116, 3557, 3995, 334, 767, 1198,
+    1626, 2051, 2474, 2894, 3312, 3728, 46, 457, 865, 1272, 1676, 2078,
+    2478, 2876, 3271, 3664, 4056, 349, 736, 1121, 1504, 1885, 2264, 2641,
+    3017, 3390, 3761, 35, 403, 768, 1132, 1495, 1855, 2214, 2570, 2926,
+    3279, 3631, 3981, 233, 580, 925, 1269, 1610, 1951, 2289, 2627, 2962,
+    3296, 3629, 3960, 193, 521, 848, 1173, 1497, 1819, 2140, 2460, 2778,
+    3094, 3410, 3724, 4036, 252, 562, 870, 1178, 1484, 1789, 2092, 2394,
+    2696, 2995, 3294, 3591, 3888, 86, 380, 673, 964, 1255, 1544, 1832,
+    2119, 2404, 2689, 2973, 3255, 3536, 3817, 4096,
+};
+
+static const struct FilterbankTable kIAVozFilterbankTable = {
+    16000, 257, 40, 125.000000f, 7500.00000f, 5, 241,
+    kIAVozFilterbankChannelWidths, kIAVozFilterbankWeights, kIAVozFilterbankUnweights,
+};
+
+#endif
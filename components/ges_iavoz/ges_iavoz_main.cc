@@ -1,18 +1,67 @@
 #include "ges_iavoz_main.h"
 
-#include <sys/_stdint.h>
+#include <stdint.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "ges_iavoz_audio_provider.h"
 
 #include "ges_iavoz_command_responder.h"
 #include "model.h"
 
-#define MAX_STP_SAMPLES 10
+#include "tensorflow/lite/micro/recording_micro_interpreter.h"
 
 const char * TAG = "IAVOZ_SYS";
 
-// constexpr int kTensorArenaSize = g_model_len;
-
+#if CONFIG_IAVOZ_PIPELINED
+void IAVoz_System_FeatureTask ( void * vParam );
+void IAVoz_System_InferenceTask ( void * vParam );
+#else
 void IAVoz_System_Task ( void * vParam );
+#endif
+
+// Negative cores leave the task unpinned.
+static BaseType_t IAVoz_System_CreateTask ( TaskFunction_t task, const char * name, IAVoz_System_t * sys, int core, TaskHandle_t * handle ) {
+    return xTaskCreatePinnedToCore(task, name, CONFIG_IAVOZ_SYS_TASK_STACK_SIZE, (void *) sys, CONFIG_IAVOZ_SYS_TASK_PRIORITY, handle, core < 0 ? tskNO_AFFINITY : core);
+}
+
+#define IAVOZ_ARENA_MEASURE_TRIES 4
+
+// Dry run of the tensor allocation on a scratch arena, to learn how many bytes the memory
+// plan really takes. The scratch starts at g_model_len bytes and doubles every time the
+// plan does not fit in it, e.g. when the streaming activation caches outgrow the model.
+static bool IAVoz_System_MeasureArena ( IAVoz_System_t * sys, size_t * used_bytes ) {
+    size_t scratch_size = g_model_len;
+
+    for (int tries = 0; tries < IAVOZ_ARENA_MEASURE_TRIES; tries++, scratch_size *= 2) {
+        uint8_t * scratch = (uint8_t *) malloc(scratch_size);
+        if (!scratch) {
+            ESP_LOGE(TAG, "Error allocating %u bytes to measure the tensor arena", (unsigned) scratch_size);
+            return false;
+        }
+
+        bool ok;
+        {
+#if CONFIG_IAVOZ_STREAMING_INFERENCE
+            // The activation caches live in the arena as well.
+            tflite::StreamingMicroInterpreter dry_run(sys->model, *(sys->micro_op_resolver), scratch, scratch_size, sys->error_reporter);
+            ok = dry_run.AllocateTensors() == kTfLiteOk && dry_run.AllocateStreamingState() == kTfLiteOk;
+#else
+            tflite::RecordingMicroInterpreter dry_run(sys->model, *(sys->micro_op_resolver), scratch, scratch_size, sys->error_reporter);
+            ok = dry_run.AllocateTensors() == kTfLiteOk;
+#endif
+            *used_bytes = dry_run.arena_used_bytes();
+        }
+
+        free(scratch);
+        if (ok) {return true;}
+        ESP_LOGW(TAG, "Tensor arena dry run failed on %u bytes", (unsigned) scratch_size);
+    }
+
+    ESP_LOGE(TAG, "Tensor arena dry run failed up to %u bytes, set CONFIG_IAVOZ_TENSOR_ARENA_SIZE",
+             (unsigned) (scratch_size / 2));
+    return false;
+}
 
 
 bool IAVoz_System_Init ( IAVoz_System_t ** sysptr, IAVoz_ModelSettings_t * ms, pIAVOZCallback_t cb ) {
@@ -24,8 +73,8 @@ bool IAVoz_System_Init ( IAVoz_System_t ** sysptr, IAVoz_ModelSettings_t * ms, p
     }
 
     sys->ms = ms;
-
-    sys->tensor_arena = (uint8_t *) malloc(g_model_len);
+    sys->tensor_arena = NULL;
+    sys->interpreter = NULL;
 
     // TF API
     sys->model = tflite::GetModel(g_model);
@@ -77,8 +126,28 @@ bool IAVoz_System_Init ( IAVoz_System_t ** sysptr, IAVoz_ModelSettings_t * ms, p
         return false;
     }
 
+    // The allocator aligns the start of the arena, hence the extra 16 bytes.
+    size_t arena_used = CONFIG_IAVOZ_TENSOR_ARENA_SIZE;
+    if (arena_used == 0 && !IAVoz_System_MeasureArena(sys, &arena_used)) {return false;}
+    sys->tensor_arena_size = arena_used + 16 + CONFIG_IAVOZ_TENSOR_ARENA_MARGIN;
+
+#if CONFIG_IAVOZ_TENSOR_ARENA_INTERNAL
+    sys->tensor_arena = (uint8_t *) heap_caps_malloc(sys->tensor_arena_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!sys->tensor_arena) {ESP_LOGW(TAG, "Not enough internal RAM for the tensor arena, using the default heap");}
+#endif
+    if (!sys->tensor_arena) {sys->tensor_arena = (uint8_t *) malloc(sys->tensor_arena_size);}
+    if (!sys->tensor_arena) {
+        ESP_LOGE(TAG, "Error allocating a %u byte tensor arena", (unsigned) sys->tensor_arena_size);
+        return false;
+    }
+    ESP_LOGI(TAG, "Tensor arena: %u bytes planned, %u allocated", (unsigned) arena_used, (unsigned) sys->tensor_arena_size);
+
     ESP_LOGI(TAG, "Creating micro interpreter");
-    sys->interpreter = new tflite::MicroInterpreter(sys->model, *(sys->micro_op_resolver), sys->tensor_arena, g_model_len, sys->error_reporter);
+#if CONFIG_IAVOZ_STREAMING_INFERENCE
+    sys->interpreter = new tflite::StreamingMicroInterpreter(sys->model, *(sys->micro_op_resolver), sys->tensor_arena, sys->tensor_arena_size, sys->error_reporter);
+#else
+    sys->interpreter = new tflite::MicroInterpreter(sys->model, *(sys->micro_op_resolver), sys->tensor_arena, sys->tensor_arena_size, sys->error_reporter);
+#endif
 
     ESP_LOGI(TAG, "Allocating tensors");
     TfLiteStatus allocate_status = sys->interpreter->AllocateTensors();
@@ -87,6 +156,14 @@ bool IAVoz_System_Init ( IAVoz_System_t ** sysptr, IAVoz_ModelSettings_t * ms, p
         return false;
     }
 
+#if CONFIG_IAVOZ_STREAMING_INFERENCE
+    if (sys->interpreter->AllocateStreamingState() != kTfLiteOk) {
+        ESP_LOGE(TAG, "AllocateStreamingState() failed");
+        return false;
+    }
+    ESP_LOGI(TAG, "Streaming %u operators, %u bytes of cache", (unsigned) sys->interpreter->streaming_operators(), (unsigned) sys->interpreter->streaming_bytes());
+#endif
+
     // Get information about the memory area to use for the model's input.
     sys->model_input = sys->interpreter->input(0);
     if ((sys->model_input->dims->size != 2) || (sys->model_input->dims->data[0] != 1) || (sys->model_input->dims->data[1] != (sys->ms->kFeatureSliceCount * sys->ms->kFeatureSliceSize)) || (sys->model_input->type != kTfLiteInt8)) 
@@ -106,7 +183,7 @@ bool IAVoz_System_Init ( IAVoz_System_t ** sysptr, IAVoz_ModelSettings_t * ms, p
     }
 
     ESP_LOGI(TAG, "Initializing FeatureProvider");
-    if ( !IAVoz_FeatureProvider_Init(&sys->fp, sys->ms) )
+    if ( !IAVoz_FeatureProvider_Init(&sys->fp, sys->ms, sys->model_input->params) )
     {
         ESP_LOGE(TAG, "FeatureProvider Init Failed");
         return false;
@@ -124,22 +201,48 @@ bool IAVoz_System_Init ( IAVoz_System_t ** sysptr, IAVoz_ModelSettings_t * ms, p
     sys->recognizer = new RecognizeCommands(sys->error_reporter);
 
     sys->previous_time = 0;
+    sys->STP_position = 0;
+    memset(sys->STP_buffer, 0, sizeof(sys->STP_buffer));
+    memset(&sys->timings, 0, sizeof(sys->timings));
+    sys->activation = IAVOZ_KEY_NULL;
+    memset(&sys->latency, 0, sizeof(sys->latency));
+    memset(&sys->gate, 0, sizeof(sys->gate));
+    sys->gate_open_until = 0;
+    sys->gate_skipped_slices = -1;
 
     sys->is_sys_started = false;
+    sys->th = NULL;
+
+#if CONFIG_IAVOZ_PIPELINED
+    sys->inference_th = NULL;
+    sys->input_free = xSemaphoreCreateBinary();
+    sys->input_ready = xSemaphoreCreateBinary();
+    if (!sys->input_free || !sys->input_ready) {
+        ESP_LOGE(TAG, "Error creating input semaphores");
+        return false;
+    }
+    xSemaphoreGive(sys->input_free);
+#endif
 
     initCommandResponder();
 
     return true;
 }
 
-void IAVoz_System_Start ( IAVoz_System_t * sys ) {
+void IAVoz_System_Start ( IAVoz_System_t * sys, int core ) {
     //ESP_LOGI(TAG, "%p ptr", sys);
     if ( sys->is_sys_started ) {
         ESP_LOGW(TAG, "System Task already started");
         return;
     }
 
-    xTaskCreate(IAVoz_System_Task, "System_Task", CONFIG_IAVOZ_SYS_TASK_STACK_SIZE, (void *) sys, CONFIG_IAVOZ_SYS_TASK_PRIORITY, &(sys->th));
+#if CONFIG_IAVOZ_PIPELINED
+    (void) core;
+    IAVoz_System_CreateTask(IAVoz_System_InferenceTask, "Inference_Task", sys, CONFIG_IAVOZ_INFERENCE_TASK_CORE, &(sys->inference_th));
+    IAVoz_System_CreateTask(IAVoz_System_FeatureTask, "Feature_Task", sys, CONFIG_IAVOZ_FEATURE_TASK_CORE, &(sys->th));
+#else
+    IAVoz_System_CreateTask(IAVoz_System_Task, "System_Task", sys, core, &(sys->th));
+#endif
     sys->is_sys_started = true;
 
     IAVoz_AudioProvider_Start(sys->ap);
@@ -160,6 +263,14 @@ void IAVoz_System_Stop ( IAVoz_System_t * sys ) {
 
     vTaskDelete(sys->th);
     sys->th = NULL;
+#if CONFIG_IAVOZ_PIPELINED
+    if (sys->inference_th) {vTaskDelete(sys->inference_th);}
+    sys->inference_th = NULL;
+
+    // Hand the input back to the next feature task whatever state the tasks were left in.
+    xSemaphoreTake(sys->input_ready, 0);
+    xSemaphoreGive(sys->input_free);
+#endif
     sys->is_sys_started = false;
 
     IAVoz_AudioProvider_Stop(sys->ap);
@@ -167,12 +278,41 @@ void IAVoz_System_Stop ( IAVoz_System_t * sys ) {
     ESP_LOGI(TAG, "System Task stopped");
 }
 
+bool IAVoz_System_Reset ( IAVoz_System_t * sys ) {
+    if ( sys->is_sys_started ) {
+        ESP_LOGE(TAG, "Cannot reset a started system");
+        return false;
+    }
+
+    IAVoz_AudioProvider_Reset(sys->ap);
+    IAVoz_FeatureProvider_Reset(sys->fp);
+#if CONFIG_IAVOZ_STREAMING_INFERENCE
+    sys->interpreter->ResetStreamingState();
+#endif
+
+    delete sys->recognizer;
+    sys->recognizer = new RecognizeCommands(sys->error_reporter);
+
+    sys->previous_time = 0;
+    sys->STP_position = 0;
+    memset(sys->STP_buffer, 0, sizeof(sys->STP_buffer));
+    sys->gate_open_until = 0;
+    sys->gate_skipped_slices = -1;
+
+    return true;
+}
+
 bool IAVoz_System_DeInit ( IAVoz_System_t * sys ) {
     delete sys->error_reporter;
     delete sys->micro_op_resolver;
     delete sys->interpreter;
 
-    if(!sys->tensor_arena) {free(sys->tensor_arena);}  
+    if (sys->tensor_arena) {free(sys->tensor_arena);}
+
+#if CONFIG_IAVOZ_PIPELINED
+    vSemaphoreDelete(sys->input_free);
+    vSemaphoreDelete(sys->input_ready);
+#endif
 
     // safely delete model settings
     bool ok = IAVoz_FeatureProvider_DeInit(sys->fp);
@@ -183,108 +323,251 @@ bool IAVoz_System_DeInit ( IAVoz_System_t * sys ) {
     return ok;
 }
 
-void IAVoz_System_Task ( void * vParam ) {
-    IAVoz_System_t * sys = (IAVoz_System_t *) vParam;
-    IAVoz_ModelSettings_t * ms = sys->ms;
+// Feature half of a step: pulls the newest audio into the feature window and describes it.
+static TfLiteStatus IAVoz_System_PopulateFeatures ( IAVoz_System_t * sys, IAVoz_SystemWindow_t * window ) {
+    uint64_t start = esp_timer_get_time();
+
+    window->audio_us = sys->ap->latest_audio_us;
+    window->time = LatestAudioTimestamp(sys->ap);
+    TfLiteStatus feature_status = IAVoz_FeatureProvider_PopulateFeatureData(sys->fp, sys->ap, sys->previous_time, window->time, &window->new_slices, sys->STP_buffer + sys->STP_position);
+    sys->timings.populate_us = esp_timer_get_time() - start;
+
+    sys->STP_position = (sys->STP_position + 1) % MAX_STP_SAMPLES;
+    if (feature_status != kTfLiteOk) {
+        // Audio behind the slices that made it in is gone from the capture buffer, do not ask for it again.
+        sys->previous_time += window->new_slices * sys->ms->kFeatureSliceStrideMs;
+        window->new_slices = 0;
+        return feature_status;
+    }
+    sys->previous_time = window->time;
 
-    int32_t previous_time = 0;
-    float STP_buffer[MAX_STP_SAMPLES];
-    uint8_t STP_position = 0;
-    int how_many_new_slices = 0;
-    
-    uint8_t voice_in_frame = 0;
-    uint8_t voice_in_bof = 0;
-    uint8_t voice_in_eof = 0;
-    char voice_visualization[49 + 1] = {0};
+    // Mean frontend output over the last MAX_STP_SAMPLES steps, from the sums of their newest slices.
+    window->STP = 0;
+    for (int i = 0; i < MAX_STP_SAMPLES; i++) {
+        window->STP += sys->STP_buffer[i];
+    }
+    window->STP /= MAX_STP_SAMPLES * sys->ms->kFeatureSliceSize;
 
-    int32_t current_time = LatestAudioTimestamp(sys->ap);
-    TfLiteStatus feature_status = IAVoz_FeatureProvider_PopulateFeatureData(sys->fp, sys->ap, previous_time, current_time, &how_many_new_slices, STP_buffer + STP_position);
-    TfLiteStatus invoke_status = sys->interpreter->Invoke();
+    return kTfLiteOk;
+}
 
-    uint64_t start, end, process_start, invoke_time, populate_time;
+static void IAVoz_System_RecordLatency ( IAVoz_System_t * sys, int64_t audio_us ) {
+    if (audio_us <= 0) {return;}
 
-    for (;;) {
-        // vTaskDelay(100/portTICK_PERIOD_MS);
-        process_start = esp_timer_get_time();
+    uint32_t latency_us = esp_timer_get_time() - audio_us;
+    uint32_t bucket = latency_us / (1000 * IAVOZ_LATENCY_BUCKET_MS);
+    if (bucket >= IAVOZ_LATENCY_BUCKETS) {bucket = IAVOZ_LATENCY_BUCKETS - 1;}
 
-        current_time = LatestAudioTimestamp(sys->ap);
-        feature_status = IAVoz_FeatureProvider_PopulateFeatureData(sys->fp, sys->ap, previous_time, current_time, &how_many_new_slices, STP_buffer + STP_position);
-        populate_time = esp_timer_get_time() - process_start;
+    sys->latency.buckets[bucket]++;
+    sys->latency.count++;
+    sys->latency.total_us += latency_us;
+    if (latency_us > sys->latency.max_us) {sys->latency.max_us = latency_us;}
+}
 
-        STP_position = (STP_position + 1) % MAX_STP_SAMPLES;
-        if (feature_status != kTfLiteOk) {continue;}
-        previous_time = current_time;
+#if CONFIG_IAVOZ_VAD_GATE
+// Decides from the fvad result of every slice in the feature window whether it may hold a
+// keyword. Skipped windows add up their slices to the next invoked one, so streaming
+// inference still knows how far the input moved.
+static bool IAVoz_System_GateWindow ( IAVoz_System_t * sys, IAVoz_SystemWindow_t * window ) {
+    const int slices = sys->ms->kFeatureSliceCount;
+    const int quarter = slices / 4;
+    int voiced = 0;
+    int voiced_begin = 0;
+    int voiced_end = 0;
+
+    // voices_write_pointer is the oldest slice of the window.
+    for (int slice = 0; slice < slices; slice++) {
+        if (!sys->fp->voices_in_frame[(slice + sys->fp->voices_write_pointer) % slices]) {continue;}
+        voiced++;
+        if (slice < quarter) {voiced_begin++;}
+        if (slice >= slices - quarter) {voiced_end++;}
+    }
 
-        if (how_many_new_slices == 0 ) {
-            vTaskDelay(100/portTICK_PERIOD_MS);
-            continue;
-        }
-        int32_t STP = 0;
-        for (int i = 0; i < MAX_STP_SAMPLES; i++) {
-            STP += STP_buffer[i];
-        }
-        STP /= MAX_STP_SAMPLES;
-
-        voice_in_frame = 0;
-        voice_in_bof = 0; // voice in begining of frame
-        voice_in_eof = 0; // voice in end of frame
-
-        // Collect VAD data from voices_in_frame array.
-        // voice_in_bof
-        // for (uint16_t sample = 0; sample < 49; sample++) {
-        //     uint16_t position = (sample + sys->fp->voices_write_pointer) % 49;
-        //     if (sample < 49/4) {voice_in_bof += sys->fp->voices_in_frame[position];}
-        //     if (sample > 3*49/4) {voice_in_eof += sys->fp->voices_in_frame[position];}
-
-        //     voice_in_frame += sys->fp->voices_in_frame[position];
-        //     if (sys->fp->voices_in_frame[position]) {voice_visualization[sample] = '|';}
-        //     else {voice_visualization[sample] = ' ';}
-        // }
-
-        // Print VAD data
-        // ESP_LOGI(TAG, "[%s] vif: %3d\t vib: %3d\t vie: %3d\t STP: %d", voice_visualization, voice_in_frame, voice_in_bof, voice_in_eof, STP);
-        // ESP_LOGD(TAG, "Free heap in SPIRAM: %d", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
-       
-        // Invoke model only if it looks like we have a windowed keyword
-        // if (voice_in_frame < 49/3){continue;}
-        // if (voice_in_eof > voice_in_frame/2) {continue;}
-        // if (voice_in_bof > voice_in_frame/2) {continue;}
-        // if (voice_in_bof != 0 && voice_in_eof == 0) {continue;}
-        // if (voice_in_bof == 0 && voice_in_eof != 0) {continue;}
-        // if (STP < 50) {continue;}
-
-        for (int i = 0; i < ms->kFeatureElementCount; i++) {
-            sys->model_input_buffer[i] = sys->fp->feature_data[i];
+    sys->gate.windows++;
+
+    bool is_open = voiced * 100 >= CONFIG_IAVOZ_VAD_GATE_MIN_VOICED_PERCENT * slices && voiced > 0;
+    bool is_centred = true;
+#if CONFIG_IAVOZ_VAD_GATE_POSITION
+    // Voice mostly in the newest quarter is still starting, mostly in the oldest one is leaving.
+    is_centred = voiced_end * 2 <= voiced && voiced_begin * 2 <= voiced;
+#else
+    (void) voiced_begin; (void) voiced_end;
+#endif
+
+    if (is_open && is_centred) {
+        sys->gate_open_until = window->time + CONFIG_IAVOZ_VAD_GATE_HANGOVER_MS;
+    } else if (window->time < sys->gate_open_until) {
+        sys->gate.hangover++;
+    } else {
+        if (!is_open) {sys->gate.skipped_silence++;}
+        else {sys->gate.skipped_position++;}
+
+        if (sys->gate_skipped_slices >= 0) {
+            sys->gate_skipped_slices = window->new_slices < 0 ? -1 : sys->gate_skipped_slices + window->new_slices;
         }
+        return false;
+    }
 
-        start = esp_timer_get_time();
-        TfLiteStatus invoke_status = sys->interpreter->Invoke();
-        invoke_time = esp_timer_get_time() - start;
-        if (invoke_status != kTfLiteOk ) { ESP_LOGE(TAG, "Interpeter failed");}
-        vTaskDelay(100/portTICK_PERIOD_MS);
-        
-        TfLiteTensor * output = sys->interpreter->output(0);
-        IAVOZ_KEY_t found_command;
-        uint8_t found_index;
-        uint8_t score = 0;
-        bool is_new_command = false;
-
-        // Results processing, in this function we decide if voice is a valid keyword
-        TfLiteStatus process_status = sys->recognizer->ProcessLatestResults(
-            output, current_time, &found_command, &score, &is_new_command, &found_index);
-        if (process_status != kTfLiteOk) {
-            ESP_LOGE(TAG, "RecognizeCommands::ProcessLatestResults() failed");
-            return;
-        }
+    if (window->new_slices >= 0) {
+        window->new_slices = sys->gate_skipped_slices < 0 ? -1 : window->new_slices + sys->gate_skipped_slices;
+    }
+    sys->gate_skipped_slices = 0;
+    return true;
+}
+#endif
+
+// Inference half of a step: runs the model on the input tensor and feeds the recognizer.
+static TfLiteStatus IAVoz_System_Infer ( IAVoz_System_t * sys, const IAVoz_SystemWindow_t * window ) {
+    const int32_t current_time = window->time;
+    const int32_t STP = window->STP;
+    uint64_t start, invoke_time, recognize_time;
+
+    sys->timings.invoked = false;
+    sys->timings.invoke_us = 0;
+    sys->timings.recognize_us = 0;
+
+    start = esp_timer_get_time();
+#if CONFIG_IAVOZ_STREAMING_INFERENCE
+    TfLiteStatus invoke_status = sys->interpreter->InvokeStreaming(window->new_slices);
+#else
+    TfLiteStatus invoke_status = sys->interpreter->Invoke();
+#endif
+    invoke_time = esp_timer_get_time() - start;
+    if (invoke_status != kTfLiteOk ) { ESP_LOGE(TAG, "Interpeter failed");}
+    sys->timings.invoked = true;
+    sys->timings.invoke_us = invoke_time;
+    
+    TfLiteTensor * output = sys->interpreter->output(0);
+    IAVOZ_KEY_t found_command = IAVOZ_KEY_NULL;
+    IAVOZ_KEY_t activated = IAVOZ_KEY_NULL;
+    uint8_t found_index;
+    uint8_t score = 0;
+    bool is_new_command = false;
+
+    // Results processing, in this function we decide if voice is a valid keyword
+    start = esp_timer_get_time();
+    TfLiteStatus process_status = sys->recognizer->ProcessLatestResults(
+        output, current_time, &found_command, &score, &is_new_command, &found_index, &activated);
+    recognize_time = esp_timer_get_time() - start;
+    sys->timings.recognize_us = recognize_time;
+    sys->activation = activated;
+    if (process_status != kTfLiteOk) {
+        ESP_LOGE(TAG, "RecognizeCommands::ProcessLatestResults() failed");
+        return process_status;
+    }
+
+    if (is_new_command) {
+        sys->cb(found_command, STP);
+        RespondToCommand(found_command);
+    }
+    IAVoz_System_RecordLatency(sys, window->audio_us);
+
+    // To check model execution time
+    ESP_LOGD(TAG, "invoke time: %llu, populate time: %lu, recognize time: %llu (us)",
+             (unsigned long long) invoke_time, (unsigned long) sys->timings.populate_us,
+             (unsigned long long) recognize_time);
+
+    return kTfLiteOk;
+}
+
+TfLiteStatus IAVoz_System_Step ( IAVoz_System_t * sys, int * how_many_new_slices ) {
+    uint64_t process_start = esp_timer_get_time();
+    IAVoz_SystemWindow_t window;
+
+    sys->timings.invoked = false;
+    sys->timings.invoke_us = 0;
+    sys->timings.recognize_us = 0;
+    sys->activation = IAVOZ_KEY_NULL;
+
+    TfLiteStatus feature_status = IAVoz_System_PopulateFeatures(sys, &window);
+    *how_many_new_slices = window.new_slices;
+    sys->timings.step_us = esp_timer_get_time() - process_start;
+    if (feature_status != kTfLiteOk) {
+#if CONFIG_IAVOZ_STREAMING_INFERENCE
+        // The feature window may have been partially shifted.
+        sys->interpreter->ResetStreamingState();
+#endif
+        return feature_status;
+    }
+
+    if (*how_many_new_slices == 0 ) {return kTfLiteOk;}
+#if CONFIG_IAVOZ_VAD_GATE
+    if (!IAVoz_System_GateWindow(sys, &window)) {return kTfLiteOk;}
+#endif
+
+    IAVoz_FeatureProvider_CopyWindow(sys->fp, sys->model_input_buffer);
 
-        if (is_new_command) {
-            sys->cb(found_command, STP);
-            RespondToCommand(found_command);
+    TfLiteStatus infer_status = IAVoz_System_Infer(sys, &window);
+    sys->timings.step_us = esp_timer_get_time() - process_start;
+    return infer_status;
+}
+
+#if CONFIG_IAVOZ_PIPELINED
+// Produces feature windows for IAVoz_System_InferenceTask. The feature window and the
+// model input tensor are the two halves of a double buffer: a new window is only copied
+// into the input once the inference task has released it, and the next window is built
+// while the model runs.
+void IAVoz_System_FeatureTask ( void * vParam ) {
+    IAVoz_System_t * sys = (IAVoz_System_t *) vParam;
+    IAVoz_SystemWindow_t window;
+    bool is_window_broken = true;
+
+    for (;;) {
+        IAVoz_AudioProvider_WaitSlices(sys->ap, CONFIG_IAVOZ_INVOKE_EVERY_SLICES, portMAX_DELAY);
+
+        TfLiteStatus feature_status = IAVoz_System_PopulateFeatures(sys, &window);
+        if (feature_status != kTfLiteOk) {
+            // The feature window may have been partially shifted.
+            is_window_broken = true;
+        } else if (window.new_slices > 0) {
+            if (is_window_broken) {window.new_slices = -1;}
+            is_window_broken = false;
+#if CONFIG_IAVOZ_VAD_GATE
+            if (!IAVoz_System_GateWindow(sys, &window)) {continue;}
+#endif
+
+            xSemaphoreTake(sys->input_free, portMAX_DELAY);
+            IAVoz_FeatureProvider_CopyWindow(sys->fp, sys->model_input_buffer);
+            sys->input = window;
+            xSemaphoreGive(sys->input_ready);
+        } else {
+            // Woken by samples the timestamp does not cover yet, let the producer catch up.
+            vTaskDelay(1);
         }
+    }
+    vTaskDelete(NULL);
+}
+
+void IAVoz_System_InferenceTask ( void * vParam ) {
+    IAVoz_System_t * sys = (IAVoz_System_t *) vParam;
+
+    for (;;) {
+        xSemaphoreTake(sys->input_ready, portMAX_DELAY);
+        IAVoz_System_Infer(sys, &sys->input);
+        xSemaphoreGive(sys->input_free);
+    }
+    vTaskDelete(NULL);
+}
+#else
+void IAVoz_System_Task ( void * vParam ) {
+    IAVoz_System_t * sys = (IAVoz_System_t *) vParam;
+    IAVoz_SystemWindow_t window;
+    int how_many_new_slices = 0;
+
+    // Warm up the feature window and the interpreter once before entering the loop.
+    IAVoz_System_PopulateFeatures(sys, &window);
+    sys->interpreter->Invoke();
 
-        // To check model execution time
-        // printf("invoke time: %lld, populate time: %lld, total time: %lld\n", invoke_time/1000, populate_time/1000, (esp_timer_get_time() - process_start)/1000);
+    for (;;) {
+        // Sleep until the audio provider has captured the next CONFIG_IAVOZ_INVOKE_EVERY_SLICES slices.
+        IAVoz_AudioProvider_WaitSlices(sys->ap, CONFIG_IAVOZ_INVOKE_EVERY_SLICES, portMAX_DELAY);
 
+        TfLiteStatus step_status = IAVoz_System_Step(sys, &how_many_new_slices);
+        if (step_status == kTfLiteOk && how_many_new_slices == 0) {
+            // Woken by samples the timestamp does not cover yet, let the producer catch up.
+            vTaskDelay(1);
+        }
     }
     vTaskDelete(NULL);
-}
\ No newline at end of file
+}
+#endif
@@ -2,6 +2,10 @@
 #define GES_IAVOZ_MAIN
 
 #include "esp_log.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "ges_iavoz.h"
 #include "ges_iavoz_audio_provider.h"
 #include "ges_iavoz_feature_provider.h"
@@ -16,14 +20,59 @@
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/streaming_micro_interpreter.h"
 #include "tensorflow/lite/micro/system_setup.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
+#define MAX_STP_SAMPLES 10
+
+#define IAVOZ_LATENCY_BUCKET_MS 10
+#define IAVOZ_LATENCY_BUCKETS   32
+
+// Time spent in each stage of the latest IAVoz_System_Step, in microseconds.
+typedef struct {
+    uint32_t populate_us;
+    uint32_t invoke_us;
+    uint32_t recognize_us;
+    uint32_t step_us;
+    bool invoked;
+} IAVoz_SystemTimings_t;
+
+// Detection latency, from the capture of the newest audio of a window to the end of its
+// recognition. Bucket i counts latencies in [i, i + 1) * IAVOZ_LATENCY_BUCKET_MS, the
+// last bucket everything longer.
+typedef struct {
+    uint32_t buckets[IAVOZ_LATENCY_BUCKETS];
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t max_us;
+} IAVoz_SystemLatency_t;
+
+// What the VAD gate did with the feature windows, see CONFIG_IAVOZ_VAD_GATE.
+typedef struct {
+    uint32_t windows;           // Windows that reached the gate.
+    uint32_t skipped_silence;   // Skipped for too few voiced slices.
+    uint32_t skipped_position;  // Skipped for voice only at the start or the end.
+    uint32_t hangover;          // Let through by the hangover after the gate closed.
+} IAVoz_SystemGateStats_t;
+
+// A feature window on its way from feature extraction to inference.
+typedef struct {
+    int32_t time;       // Audio timestamp of the newest slice, in ms.
+    int64_t audio_us;   // esp_timer time at which that audio was captured.
+    int new_slices;     // Slices since the previous window, -1 if not known.
+    int32_t STP;
+} IAVoz_SystemWindow_t;
+
 typedef struct {
     tflite::ErrorReporter * error_reporter;
     const tflite::Model * model;
     tflite::MicroMutableOpResolver<9> * micro_op_resolver;
+#if CONFIG_IAVOZ_STREAMING_INFERENCE
+    tflite::StreamingMicroInterpreter * interpreter;
+#else
     tflite::MicroInterpreter * interpreter;
+#endif
     RecognizeCommands * recognizer;
 
     IAVoz_AudioProvider_t * ap;
@@ -31,12 +80,30 @@ typedef struct {
     IAVoz_ModelSettings_t * ms;
 
     uint8_t * tensor_arena;
+    size_t tensor_arena_size;
     int8_t * model_input_buffer;
     TfLiteTensor * model_input;
 
     int32_t previous_time;
+    int32_t STP_buffer[MAX_STP_SAMPLES];   // Frontend output sums of the newest slice of the last steps.
+    uint8_t STP_position;
+    IAVoz_SystemTimings_t timings;
+    IAVOZ_KEY_t activation;     // Keyword the recognizer activated on in the latest inference, IAVOZ_KEY_NULL if none.
+    IAVoz_SystemLatency_t latency;
+    IAVoz_SystemGateStats_t gate;
+    int32_t gate_open_until;
+    int gate_skipped_slices;
+
     pIAVOZCallback_t cb;
     TaskHandle_t th;
+
+#if CONFIG_IAVOZ_PIPELINED
+    // Feature task (th) to inference task handoff of the model input tensor.
+    TaskHandle_t inference_th;
+    SemaphoreHandle_t input_free;
+    SemaphoreHandle_t input_ready;
+    IAVoz_SystemWindow_t input;
+#endif
     
     bool is_sys_started;
 } IAVoz_System_t;
@@ -44,7 +111,16 @@ typedef struct {
 
 bool IAVoz_System_Init ( IAVoz_System_t ** sysptr, IAVoz_ModelSettings_t * ms, pIAVOZCallback_t cb );
 bool IAVoz_System_DeInit ( IAVoz_System_t * sys );
-void IAVoz_System_Start ( IAVoz_System_t * sys );
+// Starts the system task pinned to core (negative for any core), or the feature and
+// inference tasks on their Kconfig cores when CONFIG_IAVOZ_PIPELINED is set.
+void IAVoz_System_Start ( IAVoz_System_t * sys, int core );
 void IAVoz_System_Stop ( IAVoz_System_t * sys );
+// Starts a stopped system over on a new stream: empties the audio, the feature window and
+// the recognizer, keeping the model, the arena and the statistics.
+bool IAVoz_System_Reset ( IAVoz_System_t * sys );
+
+// Runs one iteration of the system loop: pulls the newest audio into the feature window and,
+// when there are new slices, invokes the model and feeds the results to the recognizer.
+TfLiteStatus IAVoz_System_Step ( IAVoz_System_t * sys, int * how_many_new_slices );
 
 #endif
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "ges_iavoz_ringbuf.h"
+#include "sdkconfig.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char * TAG = "IAVOZ_RB";
+
+bool IAVoz_RingBuf_Init ( IAVoz_RingBuf_t ** rbptr, uint32_t capacity, uint32_t mirror ) {
+    IAVoz_RingBuf_t * rb = new (std::nothrow) IAVoz_RingBuf_t();
+    (*rbptr) = rb;
+    if (!rb) {
+        ESP_LOGE(TAG, "Error allocating Ring Buffer struct");
+        return false;
+    }
+
+    if (capacity < 2 || capacity > (1u << 30)) {
+        ESP_LOGE(TAG, "Invalid capacity %u", (unsigned) capacity);
+        return false;
+    }
+
+    rb->capacity = 1;
+    while (rb->capacity < capacity) {rb->capacity <<= 1;}
+    rb->mask = rb->capacity - 1;
+
+    if (mirror > rb->capacity) {
+        ESP_LOGE(TAG, "Mirror of %u samples larger than the buffer", (unsigned) mirror);
+        return false;
+    }
+    rb->mirror = mirror;
+
+#if (CONFIG_SPIRAM_SUPPORT && (CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC))
+    rb->buffer = (int16_t *) heap_caps_calloc(rb->capacity + rb->mirror, sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+    rb->buffer = (int16_t *) calloc(rb->capacity + rb->mirror, sizeof(int16_t));
+#endif
+    if (!rb->buffer) {
+        ESP_LOGE(TAG, "Error allocating %u samples", (unsigned) (rb->capacity + rb->mirror));
+        return false;
+    }
+
+    IAVoz_RingBuf_Reset(rb);
+    return true;
+}
+
+void IAVoz_RingBuf_DeInit ( IAVoz_RingBuf_t * rb ) {
+    if (!rb) {return;}
+    if (rb->buffer) {free(rb->buffer);}
+    delete rb;
+}
+
+void IAVoz_RingBuf_Reset ( IAVoz_RingBuf_t * rb ) {
+    rb->head.store(0);
+    rb->tail.store(0);
+    rb->waiting_reader.store(NULL);
+    rb->waiting_writer.store(NULL);
+}
+
+uint32_t IAVoz_RingBuf_Filled ( IAVoz_RingBuf_t * rb ) {
+    return rb->head.load(std::memory_order_acquire) - rb->tail.load(std::memory_order_acquire);
+}
+
+uint32_t IAVoz_RingBuf_Available ( IAVoz_RingBuf_t * rb ) {
+    return rb->capacity - IAVoz_RingBuf_Filled(rb);
+}
+
+// Gives the notification to the other side if it went to sleep. The index store
+// before it and this load are sequentially consistent, and IAVoz_RingBuf_Wait
+// re-checks the level behind a full fence after registering, so either the
+// waiter sees the new index or we see the waiter.
+static void IAVoz_RingBuf_Wake ( std::atomic<TaskHandle_t> * waiting ) {
+    if (!waiting->load()) {return;}
+    TaskHandle_t task = waiting->exchange(NULL);
+    if (task) {xTaskNotifyGive(task);}
+}
+
+uint32_t IAVoz_RingBuf_WriteSpan ( IAVoz_RingBuf_t * rb, int16_t ** span ) {
+    uint32_t head = rb->head.load(std::memory_order_relaxed);
+    uint32_t free_samples = rb->capacity - (head - rb->tail.load(std::memory_order_acquire));
+    uint32_t to_end = rb->capacity - (head & rb->mask);
+
+    *span = rb->buffer + (head & rb->mask);
+    return free_samples < to_end ? free_samples : to_end;
+}
+
+void IAVoz_RingBuf_Commit ( IAVoz_RingBuf_t * rb, uint32_t count ) {
+    uint32_t head = rb->head.load(std::memory_order_relaxed);
+
+    // Spans never wrap, so the committed samples are [begin, begin + count).
+    uint32_t begin = head & rb->mask;
+    if (begin < rb->mirror) {
+        uint32_t end = begin + count < rb->mirror ? begin + count : rb->mirror;
+        memcpy(rb->buffer + rb->capacity + begin, rb->buffer + begin, (end - begin) * sizeof(int16_t));
+    }
+
+    rb->head.store(head + count);
+    IAVoz_RingBuf_Wake(&rb->waiting_reader);
+}
+
+uint32_t IAVoz_RingBuf_ReadSpan ( IAVoz_RingBuf_t * rb, const int16_t ** span ) {
+    uint32_t tail = rb->tail.load(std::memory_order_relaxed);
+    uint32_t filled = rb->head.load(std::memory_order_acquire) - tail;
+    uint32_t to_end = rb->capacity + rb->mirror - (tail & rb->mask);
+
+    *span = rb->buffer + (tail & rb->mask);
+    return filled < to_end ? filled : to_end;
+}
+
+void IAVoz_RingBuf_Consume ( IAVoz_RingBuf_t * rb, uint32_t count ) {
+    rb->tail.store(rb->tail.load(std::memory_order_relaxed) + count);
+    IAVoz_RingBuf_Wake(&rb->waiting_writer);
+}
+
+static bool IAVoz_RingBuf_Wait ( IAVoz_RingBuf_t * rb, std::atomic<TaskHandle_t> * waiting, uint32_t (*level)(IAVoz_RingBuf_t *),
+                                 uint32_t count, TickType_t ticks_to_wait ) {
+    if (level(rb) >= count) {return true;}
+    if (count > rb->capacity || ticks_to_wait == 0) {return false;}
+
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    TickType_t start = xTaskGetTickCount();
+
+    for (;;) {
+        waiting->store(self);
+        // The level loads are only acquire, keep them from moving before the registration.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (level(rb) >= count) {break;}
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (ticks_to_wait != portMAX_DELAY && elapsed >= ticks_to_wait) {
+            waiting->store(NULL);
+            return level(rb) >= count;
+        }
+
+        // Wake-ups may be stale or for less than count, the loop checks again.
+        ulTaskNotifyTake(pdTRUE, ticks_to_wait == portMAX_DELAY ? portMAX_DELAY : ticks_to_wait - elapsed);
+    }
+
+    waiting->store(NULL);
+    return true;
+}
+
+bool IAVoz_RingBuf_WaitAvailable ( IAVoz_RingBuf_t * rb, uint32_t count, TickType_t ticks_to_wait ) {
+    return IAVoz_RingBuf_Wait(rb, &rb->waiting_writer, IAVoz_RingBuf_Available, count, ticks_to_wait);
+}
+
+bool IAVoz_RingBuf_WaitFilled ( IAVoz_RingBuf_t * rb, uint32_t count, TickType_t ticks_to_wait ) {
+    return IAVoz_RingBuf_Wait(rb, &rb->waiting_reader, IAVoz_RingBuf_Filled, count, ticks_to_wait);
+}
+
+int32_t IAVoz_RingBuf_Write ( IAVoz_RingBuf_t * rb, const int16_t * samples, uint32_t count, TickType_t ticks_to_wait ) {
+    if (count > rb->capacity) {count = rb->capacity;}
+    IAVoz_RingBuf_WaitAvailable(rb, count, ticks_to_wait);
+
+    uint32_t written = 0;
+    int16_t * span;
+    uint32_t span_size;
+    while (written < count && (span_size = IAVoz_RingBuf_WriteSpan(rb, &span)) > 0) {
+        if (span_size > count - written) {span_size = count - written;}
+        memcpy(span, samples + written, span_size * sizeof(int16_t));
+        IAVoz_RingBuf_Commit(rb, span_size);
+        written += span_size;
+    }
+    return written;
+}
+
+int32_t IAVoz_RingBuf_Read ( IAVoz_RingBuf_t * rb, int16_t * samples, uint32_t count, TickType_t ticks_to_wait ) {
+    if (count > rb->capacity) {count = rb->capacity;}
+    IAVoz_RingBuf_WaitFilled(rb, count, ticks_to_wait);
+
+    uint32_t read = 0;
+    const int16_t * span;
+    uint32_t span_size;
+    while (read < count && (span_size = IAVoz_RingBuf_ReadSpan(rb, &span)) > 0) {
+        if (span_size > count - read) {span_size = count - read;}
+        memcpy(samples + read, span, span_size * sizeof(int16_t));
+        IAVoz_RingBuf_Consume(rb, span_size);
+        read += span_size;
+    }
+    return read;
+}
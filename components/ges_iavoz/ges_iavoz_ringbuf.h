@@ -0,0 +1,67 @@
+#ifndef GES_IAVOZ_RINGBUF
+#define GES_IAVOZ_RINGBUF
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Lock-free single-producer/single-consumer ring buffer of audio samples.
+//
+// head and tail are free running sample counters, the buffer is indexed with
+// them masked by the power-of-two capacity. Only the producer stores head and
+// only the consumer stores tail, so no lock is needed. A side that has to
+// wait (buffer empty for the reader, full for the writer) registers its task
+// handle and sleeps on a task notification, which the other side gives after
+// its next commit.
+//
+// The first `mirror` samples are copied past the end of the buffer as they are
+// committed, so any run of up to mirror + 1 filled samples can be read in place
+// even when it wraps around.
+typedef struct {
+    int16_t * buffer;
+    uint32_t capacity;
+    uint32_t mask;
+    uint32_t mirror;
+
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+
+    std::atomic<TaskHandle_t> waiting_reader;
+    std::atomic<TaskHandle_t> waiting_writer;
+} IAVoz_RingBuf_t;
+
+// capacity is rounded up to a power of two, mirror may be 0.
+bool IAVoz_RingBuf_Init ( IAVoz_RingBuf_t ** rbptr, uint32_t capacity, uint32_t mirror );
+void IAVoz_RingBuf_DeInit ( IAVoz_RingBuf_t * rb );
+
+// Drops all the samples. Neither side may be using the buffer.
+void IAVoz_RingBuf_Reset ( IAVoz_RingBuf_t * rb );
+
+uint32_t IAVoz_RingBuf_Filled ( IAVoz_RingBuf_t * rb );
+uint32_t IAVoz_RingBuf_Available ( IAVoz_RingBuf_t * rb );
+
+// Producer side. WriteSpan points *span at the free samples up to the end of the
+// buffer and returns how many there are, Commit publishes the first count of them.
+uint32_t IAVoz_RingBuf_WriteSpan ( IAVoz_RingBuf_t * rb, int16_t ** span );
+void IAVoz_RingBuf_Commit ( IAVoz_RingBuf_t * rb, uint32_t count );
+
+// Consumer side. ReadSpan points *span at the filled samples up to the end of the
+// mirror and returns how many there are, Consume releases the first count of them.
+// The span stays valid until it is consumed.
+uint32_t IAVoz_RingBuf_ReadSpan ( IAVoz_RingBuf_t * rb, const int16_t ** span );
+void IAVoz_RingBuf_Consume ( IAVoz_RingBuf_t * rb, uint32_t count );
+
+// Blocks until count samples (free or filled) are there or ticks_to_wait expire.
+// Returns false on timeout.
+bool IAVoz_RingBuf_WaitAvailable ( IAVoz_RingBuf_t * rb, uint32_t count, TickType_t ticks_to_wait );
+bool IAVoz_RingBuf_WaitFilled ( IAVoz_RingBuf_t * rb, uint32_t count, TickType_t ticks_to_wait );
+
+// Copying API on top of the spans, waiting up to ticks_to_wait for the whole count.
+// Return the number of samples moved, which is less than count on timeout.
+int32_t IAVoz_RingBuf_Write ( IAVoz_RingBuf_t * rb, const int16_t * samples, uint32_t count, TickType_t ticks_to_wait );
+int32_t IAVoz_RingBuf_Read ( IAVoz_RingBuf_t * rb, int16_t * samples, uint32_t count, TickType_t ticks_to_wait );
+
+#endif // GES_IAVOZ_RINGBUF
@@ -13,13 +13,14 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/experimental/microfrontend/lib/fft.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend_kernels.h"
 #include "tensorflow/lite/experimental/microfrontend/lib/kiss_fft_int16.h"
 
 #include <string.h>
 
 
-void FftCompute(struct FftState* state, const int16_t* input,
-                int input_scale_shift) {
+void FftComputeReference(struct FftState* state, const int16_t* input,
+                         int input_scale_shift) {
   const size_t input_size = state->input_size;
   const size_t fft_size = state->fft_size;
 
@@ -42,6 +43,15 @@ void FftCompute(struct FftState* state, const int16_t* input,
     reinterpret_cast<kissfft_fixed16::kiss_fft_cpx*>(state->output));
 }
 
+void FftCompute(struct FftState* state, const int16_t* input,
+                int input_scale_shift) {
+#ifdef MICROFRONTEND_OPTIMIZED
+  FftComputeOptimized(state, input, input_scale_shift);
+#else
+  FftComputeReference(state, input, input_scale_shift);
+#endif
+}
+
 void FftInit(struct FftState* state) {
   // All the initialization is done in FftPopulateState()
 }
@@ -0,0 +1,274 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend_kernels.h"
+
+// A 512 point real FFT that gives the same bits as kiss_fftr built with
+// FIXED_POINT 16: the real input is read as 256 complex points, transformed by
+// four radix 4 stages and split into the 257 bins of the real spectrum. Every
+// butterfly rounds, divides and wraps exactly like kf_bfly4, only the
+// recursion, the runtime twiddle tables and the zero padded copy are gone. The
+// input is scaled and digit reversed straight into the output buffer, the
+// first stage skips the products of points past the end of the window, and
+// the split runs in place.
+
+#define kFftComplexSize 256
+
+// kiss twiddles for 256 points, floor(0.5 + 32767 * e^(-2 pi i k / 256)). The
+// radix 4 stages only use the first three quarters.
+static const struct complex_int16_t kFftTwiddles[192] = {
+    {32767, 0}, {32757, -804}, {32728, -1608}, {32678, -2410}, {32609, -3212},
+    {32521, -4011}, {32412, -4808}, {32285, -5602}, {32137, -6393},
+    {31971, -7179}, {31785, -7962}, {31580, -8739}, {31356, -9512},
+    {31113, -10278}, {30852, -11039}, {30571, -11793}, {30273, -12539},
+    {29956, -13279}, {29621, -14010}, {29268, -14732}, {28898, -15446},
+    {28510, -16151}, {28105, -16846}, {27683, -17530}, {27245, -18204},
+    {26790, -18868}, {26319, -19519}, {25832, -20159}, {25329, -20787},
+    {24811, -21403}, {24279, -22005}, {23731, -22594}, {23170, -23170},
+    {22594, -23731}, {22005, -24279}, {21403, -24811}, {20787, -25329},
+    {20159, -25832}, {19519, -26319}, {18868, -26790}, {18204, -27245},
+    {17530, -27683}, {16846, -28105}, {16151, -28510}, {15446, -28898},
+    {14732, -29268}, {14010, -29621}, {13279, -29956}, {12539, -30273},
+    {11793, -30571}, {11039, -30852}, {10278, -31113}, {9512, -31356},
+    {8739, -31580}, {7962, -31785}, {7179, -31971}, {6393, -32137},
+    {5602, -32285}, {4808, -32412}, {4011, -32521}, {3212, -32609},
+    {2410, -32678}, {1608, -32728}, {804, -32757}, {0, -32767}, {-804, -32757},
+    {-1608, -32728}, {-2410, -32678}, {-3212, -32609}, {-4011, -32521},
+    {-4808, -32412}, {-5602, -32285}, {-6393, -32137}, {-7179, -31971},
+    {-7962, -31785}, {-8739, -31580}, {-9512, -31356}, {-10278, -31113},
+    {-11039, -30852}, {-11793, -30571}, {-12539, -30273}, {-13279, -29956},
+    {-14010, -29621}, {-14732, -29268}, {-15446, -28898}, {-16151, -28510},
+    {-16846, -28105}, {-17530, -27683}, {-18204, -27245}, {-18868, -26790},
+    {-19519, -26319}, {-20159, -25832}, {-20787, -25329}, {-21403, -24811},
+    {-22005, -24279}, {-22594, -23731}, {-23170, -23170}, {-23731, -22594},
+    {-24279, -22005}, {-24811, -21403}, {-25329, -20787}, {-25832, -20159},
+    {-26319, -19519}, {-26790, -18868}, {-27245, -18204}, {-27683, -17530},
+    {-28105, -16846}, {-28510, -16151}, {-28898, -15446}, {-29268, -14732},
+    {-29621, -14010}, {-29956, -13279}, {-30273, -12539}, {-30571, -11793},
+    {-30852, -11039}, {-31113, -10278}, {-31356, -9512}, {-31580, -8739},
+    {-31785, -7962}, {-31971, -7179}, {-32137, -6393}, {-32285, -5602},
+    {-32412, -4808}, {-32521, -4011}, {-32609, -3212}, {-32678, -2410},
+    {-32728, -1608}, {-32757, -804}, {-32767, 0}, {-32757, 804}, {-32728, 1608},
+    {-32678, 2410}, {-32609, 3212}, {-32521, 4011}, {-32412, 4808},
+    {-32285, 5602}, {-32137, 6393}, {-31971, 7179}, {-31785, 7962},
+    {-31580, 8739}, {-31356, 9512}, {-31113, 10278}, {-30852, 11039},
+    {-30571, 11793}, {-30273, 12539}, {-29956, 13279}, {-29621, 14010},
+    {-29268, 14732}, {-28898, 15446}, {-28510, 16151}, {-28105, 16846},
+    {-27683, 17530}, {-27245, 18204}, {-26790, 18868}, {-26319, 19519},
+    {-25832, 20159}, {-25329, 20787}, {-24811, 21403}, {-24279, 22005},
+    {-23731, 22594}, {-23170, 23170}, {-22594, 23731}, {-22005, 24279},
+    {-21403, 24811}, {-20787, 25329}, {-20159, 25832}, {-19519, 26319},
+    {-18868, 26790}, {-18204, 27245}, {-17530, 27683}, {-16846, 28105},
+    {-16151, 28510}, {-15446, 28898}, {-14732, 29268}, {-14010, 29621},
+    {-13279, 29956}, {-12539, 30273}, {-11793, 30571}, {-11039, 30852},
+    {-10278, 31113}, {-9512, 31356}, {-8739, 31580}, {-7962, 31785},
+    {-7179, 31971}, {-6393, 32137}, {-5602, 32285}, {-4808, 32412},
+    {-4011, 32521}, {-3212, 32609}, {-2410, 32678}, {-1608, 32728},
+    {-804, 32757},
+};
+
+// kiss_fftr super twiddles, floor(0.5 + 32767 * e^(-i pi ((k + 1) / 256 + 0.5))).
+static const struct complex_int16_t kFftSuperTwiddles[128] = {
+    {-402, -32765}, {-804, -32757}, {-1206, -32745}, {-1608, -32728},
+    {-2009, -32705}, {-2410, -32678}, {-2811, -32646}, {-3212, -32609},
+    {-3612, -32567}, {-4011, -32521}, {-4410, -32469}, {-4808, -32412},
+    {-5205, -32351}, {-5602, -32285}, {-5998, -32213}, {-6393, -32137},
+    {-6786, -32057}, {-7179, -31971}, {-7571, -31880}, {-7962, -31785},
+    {-8351, -31685}, {-8739, -31580}, {-9126, -31470}, {-9512, -31356},
+    {-9896, -31237}, {-10278, -31113}, {-10659, -30985}, {-11039, -30852},
+    {-11417, -30714}, {-11793, -30571}, {-12167, -30424}, {-12539, -30273},
+    {-12910, -30117}, {-13279, -29956}, {-13645, -29791}, {-14010, -29621},
+    {-14372, -29447}, {-14732, -29268}, {-15090, -29085}, {-15446, -28898},
+    {-15800, -28706}, {-16151, -28510}, {-16499, -28310}, {-16846, -28105},
+    {-17189, -27896}, {-17530, -27683}, {-17869, -27466}, {-18204, -27245},
+    {-18537, -27019}, {-18868, -26790}, {-19195, -26556}, {-19519, -26319},
+    {-19841, -26077}, {-20159, -25832}, {-20475, -25582}, {-20787, -25329},
+    {-21096, -25072}, {-21403, -24811}, {-21705, -24547}, {-22005, -24279},
+    {-22301, -24007}, {-22594, -23731}, {-22884, -23452}, {-23170, -23170},
+    {-23452, -22884}, {-23731, -22594}, {-24007, -22301}, {-24279, -22005},
+    {-24547, -21705}, {-24811, -21403}, {-25072, -21096}, {-25329, -20787},
+    {-25582, -20475}, {-25832, -20159}, {-26077, -19841}, {-26319, -19519},
+    {-26556, -19195}, {-26790, -18868}, {-27019, -18537}, {-27245, -18204},
+    {-27466, -17869}, {-27683, -17530}, {-27896, -17189}, {-28105, -16846},
+    {-28310, -16499}, {-28510, -16151}, {-28706, -15800}, {-28898, -15446},
+    {-29085, -15090}, {-29268, -14732}, {-29447, -14372}, {-29621, -14010},
+    {-29791, -13645}, {-29956, -13279}, {-30117, -12910}, {-30273, -12539},
+    {-30424, -12167}, {-30571, -11793}, {-30714, -11417}, {-30852, -11039},
+    {-30985, -10659}, {-31113, -10278}, {-31237, -9896}, {-31356, -9512},
+    {-31470, -9126}, {-31580, -8739}, {-31685, -8351}, {-31785, -7962},
+    {-31880, -7571}, {-31971, -7179}, {-32057, -6786}, {-32137, -6393},
+    {-32213, -5998}, {-32285, -5602}, {-32351, -5205}, {-32412, -4808},
+    {-32469, -4410}, {-32521, -4011}, {-32567, -3612}, {-32609, -3212},
+    {-32646, -2811}, {-32678, -2410}, {-32705, -2009}, {-32728, -1608},
+    {-32745, -1206}, {-32757, -804}, {-32765, -402}, {-32767, 0},
+};
+
+static inline int16_t Round15(uint32_t x) {
+  return (int16_t)((int32_t)(x + (1u << 14)) >> 15);
+}
+
+// x * (32767 / divisor) rounded, the kiss C_FIXDIV.
+static inline struct complex_int16_t FixDiv(struct complex_int16_t x,
+                                            int32_t scale) {
+  struct complex_int16_t y;
+  y.real = Round15((uint32_t)(x.real * scale));
+  y.imag = Round15((uint32_t)(x.imag * scale));
+  return y;
+}
+
+static inline struct complex_int16_t Mul(struct complex_int16_t a,
+                                         struct complex_int16_t b) {
+  struct complex_int16_t y;
+  y.real = Round15((uint32_t)(a.real * b.real) - (uint32_t)(a.imag * b.imag));
+  y.imag = Round15((uint32_t)(a.real * b.imag) + (uint32_t)(a.imag * b.real));
+  return y;
+}
+
+// Mul by the first twiddle, 32767 + 0i.
+static inline struct complex_int16_t MulFirst(struct complex_int16_t a) {
+  struct complex_int16_t y;
+  y.real = Round15((uint32_t)(a.real * 32767));
+  y.imag = Round15((uint32_t)(a.imag * 32767));
+  return y;
+}
+
+static inline struct complex_int16_t Add(struct complex_int16_t a,
+                                         struct complex_int16_t b) {
+  struct complex_int16_t y;
+  y.real = (int16_t)(a.real + b.real);
+  y.imag = (int16_t)(a.imag + b.imag);
+  return y;
+}
+
+static inline struct complex_int16_t Sub(struct complex_int16_t a,
+                                         struct complex_int16_t b) {
+  struct complex_int16_t y;
+  y.real = (int16_t)(a.real - b.real);
+  y.imag = (int16_t)(a.imag - b.imag);
+  return y;
+}
+
+// The tail of kf_bfly4 once the inputs are divided and multiplied.
+static inline void Butterfly4(struct complex_int16_t* out, size_t m,
+                              struct complex_int16_t a0,
+                              struct complex_int16_t s0,
+                              struct complex_int16_t s1,
+                              struct complex_int16_t s2) {
+  const struct complex_int16_t s5 = Sub(a0, s1);
+  const struct complex_int16_t s3 = Add(s0, s2);
+  const struct complex_int16_t s4 = Sub(s0, s2);
+  a0 = Add(a0, s1);
+  out[2 * m] = Sub(a0, s3);
+  out[0] = Add(a0, s3);
+  out[m].real = (int16_t)(s5.real + s4.imag);
+  out[m].imag = (int16_t)(s5.imag - s4.real);
+  out[3 * m].real = (int16_t)(s5.real - s4.imag);
+  out[3 * m].imag = (int16_t)(s5.imag + s4.real);
+}
+
+// Complex point n of the scaled, zero padded input.
+static inline struct complex_int16_t LoadPoint(const int16_t* input,
+                                               size_t input_size, int shift,
+                                               size_t n) {
+  struct complex_int16_t x = {0, 0};
+  if (2 * n + 1 < input_size) {
+    x.real = (int16_t)((uint16_t)input[2 * n] << shift);
+    x.imag = (int16_t)((uint16_t)input[2 * n + 1] << shift);
+  } else if (2 * n < input_size) {
+    x.real = (int16_t)((uint16_t)input[2 * n] << shift);
+  }
+  return x;
+}
+
+// First stage: the four points of group q are n = rev(q) + 64 j, with rev
+// reversing the three base 4 digits of q. The only twiddle is the first one.
+static inline void FirstStage(struct complex_int16_t* out, const int16_t* input,
+                       size_t input_size, int shift) {
+  const size_t nonzero_points = (input_size + 1) / 2;
+  size_t q;
+  for (q = 0; q < kFftComplexSize / 4; ++q) {
+    const size_t n = ((q & 3) << 4) | (q & 12) | (q >> 4);
+    const struct complex_int16_t a0 =
+        FixDiv(LoadPoint(input, input_size, shift, n), 8191);
+    const struct complex_int16_t a1 =
+        FixDiv(LoadPoint(input, input_size, shift, n + 64), 8191);
+    const struct complex_int16_t a2 =
+        FixDiv(LoadPoint(input, input_size, shift, n + 128), 8191);
+    struct complex_int16_t s2 = {0, 0};
+    if (n + 192 < nonzero_points) {
+      s2 = MulFirst(FixDiv(LoadPoint(input, input_size, shift, n + 192), 8191));
+    }
+    Butterfly4(out + 4 * q, 1, a0, MulFirst(a1), MulFirst(a2), s2);
+  }
+}
+
+static inline void Stage(struct complex_int16_t* out, size_t m) {
+  const size_t fstride = kFftComplexSize / (4 * m);
+  size_t group, k;
+  for (group = 0; group < kFftComplexSize; group += 4 * m) {
+    struct complex_int16_t* f = out + group;
+    Butterfly4(f, m, FixDiv(f[0], 8191), MulFirst(FixDiv(f[m], 8191)),
+               MulFirst(FixDiv(f[2 * m], 8191)),
+               MulFirst(FixDiv(f[3 * m], 8191)));
+    for (k = 1; k < m; ++k) {
+      const struct complex_int16_t a0 = FixDiv(f[k], 8191);
+      const struct complex_int16_t s0 =
+          Mul(FixDiv(f[k + m], 8191), kFftTwiddles[k * fstride]);
+      const struct complex_int16_t s1 =
+          Mul(FixDiv(f[k + 2 * m], 8191), kFftTwiddles[2 * k * fstride]);
+      const struct complex_int16_t s2 =
+          Mul(FixDiv(f[k + 3 * m], 8191), kFftTwiddles[3 * k * fstride]);
+      Butterfly4(f + k, m, a0, s0, s1, s2);
+    }
+  }
+}
+
+// Splits the complex transform in out[0, 256) into the real spectrum in
+// out[0, 256], as kiss_fftr does from its tmpbuf. Bins k and 256 - k only
+// depend on each other, so it works in place.
+static void SplitReal(struct complex_int16_t* out) {
+  const struct complex_int16_t dc = FixDiv(out[0], 16383);
+  size_t k;
+  out[0].real = (int16_t)(dc.real + dc.imag);
+  out[0].imag = 0;
+  out[kFftComplexSize].real = (int16_t)(dc.real - dc.imag);
+  out[kFftComplexSize].imag = 0;
+
+  for (k = 1; k <= kFftComplexSize / 2; ++k) {
+    struct complex_int16_t fpnk = out[kFftComplexSize - k];
+    fpnk.imag = (int16_t)-fpnk.imag;
+    const struct complex_int16_t fpk = FixDiv(out[k], 16383);
+    fpnk = FixDiv(fpnk, 16383);
+    const struct complex_int16_t f1k = Add(fpk, fpnk);
+    const struct complex_int16_t tw =
+        Mul(Sub(fpk, fpnk), kFftSuperTwiddles[k - 1]);
+    out[k].real = (int16_t)((f1k.real + tw.real) >> 1);
+    out[k].imag = (int16_t)((f1k.imag + tw.imag) >> 1);
+    out[kFftComplexSize - k].real = (int16_t)((f1k.real - tw.real) >> 1);
+    out[kFftComplexSize - k].imag = (int16_t)((tw.imag - f1k.imag) >> 1);
+  }
+}
+
+void FftComputeOptimized(struct FftState* state, const int16_t* input,
+                         int input_scale_shift) {
+  if (state->fft_size != 2 * kFftComplexSize ||
+      state->input_size > state->fft_size) {
+    FftComputeReference(state, input, input_scale_shift);
+    return;
+  }
+  struct complex_int16_t* out = state->output;
+  FirstStage(out, input, state->input_size, input_scale_shift);
+  Stage(out, 4);
+  Stage(out, 16);
+  Stage(out, 64);
+  SplitReal(out);
+}
@@ -17,10 +17,12 @@ limitations under the License.
 #include <string.h>
 
 #include "tensorflow/lite/experimental/microfrontend/lib/bits.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend_kernels.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/sqrt_lut.h"
 
-void FilterbankConvertFftComplexToEnergy(struct FilterbankState* state,
-                                         struct complex_int16_t* fft_output,
-                                         int32_t* energy) {
+void FilterbankConvertFftComplexToEnergyReference(
+    struct FilterbankState* state, struct complex_int16_t* fft_output,
+    int32_t* energy) {
   const int end_index = state->end_index;
   int i;
   energy += state->start_index;
@@ -64,6 +66,52 @@ void FilterbankAccumulateChannels(struct FilterbankState* state,
   }
 }
 
+void FilterbankConvertFftComplexToEnergy(struct FilterbankState* state,
+                                         struct complex_int16_t* fft_output,
+                                         int32_t* energy) {
+#if defined(MICROFRONTEND_OPTIMIZED) && defined(FRONTEND_KERNELS_VECTORIZE)
+  FilterbankConvertFftComplexToEnergyOptimized(state, fft_output, energy);
+#else
+  FilterbankConvertFftComplexToEnergyReference(state, fft_output, energy);
+#endif
+}
+
+void FilterbankAccumulateSpectrum(struct FilterbankState* state,
+                                  const struct complex_int16_t* fft_output) {
+  const struct FilterbankTable* table = state->table;
+  const int16_t* channel_widths = table->channel_widths;
+  const int16_t* weights = table->weights;
+  uint64_t* work = state->work;
+  // The unweights of a table are 1 << kFilterbankBits minus its weights (see
+  // FilterbankPopulateState), so the unweighted sum of a channel is its plain
+  // energy sum shifted, less its weighted sum: one multiply per bin.
+  uint64_t previous_weighted = 0;
+  uint64_t previous_sum = 0;
+
+  fft_output += table->start_index;
+  int num_channels_plus_1 = state->num_channels + 1;
+  int i;
+  for (i = 0; i < num_channels_plus_1; ++i) {
+    const int width = *channel_widths++;
+    uint64_t weighted = 0;
+    uint64_t sum = 0;
+    int j;
+    for (j = 0; j < width; ++j) {
+      const int32_t real = fft_output->real;
+      const int32_t imag = fft_output->imag;
+      fft_output++;
+      // The int32_t energy of FilterbankConvertFftComplexToEnergy.
+      const int32_t energy = (int32_t)((uint32_t)(real * real) +
+                                       (uint32_t)(imag * imag));
+      weighted += (uint64_t)((int64_t)*weights++ * energy);
+      sum += (uint64_t)(int64_t)energy;
+    }
+    *work++ = weighted + (previous_sum << kFilterbankBits) - previous_weighted;
+    previous_weighted = weighted;
+    previous_sum = sum;
+  }
+}
+
 static uint16_t Sqrt32(uint32_t num) {
   if (num == 0) {
     return 0;
@@ -117,6 +165,32 @@ static uint32_t Sqrt64(uint64_t num) {
   return res;
 }
 
+// Square root from the table of the top 8 bits of the number normalized to a
+// 31 or 32 bit mantissa, interpolated over the next 16 bits. The relative
+// error of the interpolation is below 2^-17, the result is rounded.
+static uint32_t Sqrt64Lut(uint64_t num) {
+  if (num == 0) {
+    return 0;
+  }
+  // An even shift, so that it halves exactly in the root.
+  int shift = MostSignificantBit64(num) - 32;
+  shift += shift & 1;
+  const uint32_t mantissa =
+      shift >= 0 ? (uint32_t)(num >> shift) : (uint32_t)num << -shift;
+  const uint32_t index = mantissa >> 24;
+  const uint32_t fraction = (mantissa >> 8) & 0xFFFF;
+  const uint32_t c0 = kSqrtLut[index - kSqrtLutFirst];
+  const uint32_t c1 = kSqrtLut[index - kSqrtLutFirst + 1];
+  const uint32_t root = c0 + (((c1 - c0) * fraction) >> 16);
+
+  const int root_shift = shift / 2 - kSqrtLutFractionBits;
+  if (root_shift < 0) {
+    return (root + (1U << (-root_shift - 1))) >> -root_shift;
+  }
+  const uint64_t res = (uint64_t)root << root_shift;
+  return res > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (uint32_t)res;
+}
+
 uint32_t* FilterbankSqrt(struct FilterbankState* state, int scale_down_shift) {
   const int num_channels = state->num_channels;
   const uint64_t* work = state->work + 1;
@@ -124,8 +198,14 @@ uint32_t* FilterbankSqrt(struct FilterbankState* state, int scale_down_shift) {
   // the output.
   uint32_t* output = (uint32_t*)state->work;
   int i;
-  for (i = 0; i < num_channels; ++i) {
-    *output++ = Sqrt64(*work++) >> scale_down_shift;
+  if (state->lut_sqrt) {
+    for (i = 0; i < num_channels; ++i) {
+      *output++ = Sqrt64Lut(*work++) >> scale_down_shift;
+    }
+  } else {
+    for (i = 0; i < num_channels; ++i) {
+      *output++ = Sqrt64(*work++) >> scale_down_shift;
+    }
   }
   return (uint32_t*)state->work;
 }
@@ -26,6 +26,23 @@ limitations under the License.
 extern "C" {
 #endif
 
+// A filterbank computed ahead of time for one configuration. The channels
+// (num_channels + 1 of them, as in FilterbankState) cover the spectrum bins
+// [start_index, end_index) back to back: channel i takes the next
+// channel_widths[i] bins, and every bin has one weight and one unweight.
+struct FilterbankTable {
+  int sample_rate;
+  int spectrum_size;
+  int num_channels;
+  float lower_band_limit;
+  float upper_band_limit;
+  int start_index;
+  int end_index;
+  const int16_t* channel_widths;
+  const int16_t* weights;
+  const int16_t* unweights;
+};
+
 struct FilterbankState {
   int num_channels;
   int start_index;
@@ -36,6 +53,10 @@ struct FilterbankState {
   int16_t* weights;
   int16_t* unweights;
   uint64_t* work;
+  // Set when the state was built from a FilterbankTable, the per-channel
+  // arrays above are then NULL.
+  const struct FilterbankTable* table;
+  int lut_sqrt;
 };
 
 // Converts the relevant complex values of an FFT output into energy (the
@@ -49,6 +70,12 @@ void FilterbankConvertFftComplexToEnergy(struct FilterbankState* state,
 void FilterbankAccumulateChannels(struct FilterbankState* state,
                                   const int32_t* energy);
 
+// Same as FilterbankConvertFftComplexToEnergy followed by
+// FilterbankAccumulateChannels, in one pass over the bins, for a state built
+// from a table. Leaves fft_output untouched.
+void FilterbankAccumulateSpectrum(struct FilterbankState* state,
+                                  const struct complex_int16_t* fft_output);
+
 // Applies an integer square root to the 64 bit intermediate values of the
 // filterbank, and returns a pointer to them. Memory will be invalidated the
 // next time FilterbankAccumulateChannels is called.
@@ -26,6 +26,8 @@ void FilterbankFillConfigWithDefaults(struct FilterbankConfig* config) {
   config->lower_band_limit = 125.0f;
   config->upper_band_limit = 7500.0f;
   config->output_scale_shift = 7;
+  config->table = NULL;
+  config->lut_sqrt = 0;
 }
 
 static float FreqToMel(float freq) { return 1127.0 * log1p(freq / 700.0); }
@@ -53,10 +55,57 @@ static void QuantizeFilterbankWeights(const float float_weight, int16_t* weight,
   *unweight = floor((1.0 - float_weight) * (1 << kFilterbankBits) + 0.5);
 }
 
+static int FilterbankTableMatches(const struct FilterbankConfig* config,
+                                  const struct FilterbankTable* table,
+                                  int sample_rate, int spectrum_size) {
+  if (table->sample_rate != sample_rate ||
+      table->spectrum_size != spectrum_size ||
+      table->num_channels != config->num_channels ||
+      table->lower_band_limit != config->lower_band_limit ||
+      table->upper_band_limit != config->upper_band_limit) {
+    return 0;
+  }
+  // FilterbankAccumulateSpectrum relies on every unweight being the
+  // complement of its weight, as QuantizeFilterbankWeights rounds them.
+  const int num_weights = table->end_index - table->start_index;
+  int i;
+  for (i = 0; i < num_weights; ++i) {
+    if (table->weights[i] + table->unweights[i] != (1 << kFilterbankBits)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
 int FilterbankPopulateState(const struct FilterbankConfig* config,
                             struct FilterbankState* state, int sample_rate,
                             int spectrum_size) {
   state->num_channels = config->num_channels;
+  state->table = NULL;
+  state->lut_sqrt = config->lut_sqrt;
+
+  if (config->table != NULL) {
+    if (FilterbankTableMatches(config, config->table, sample_rate,
+                               spectrum_size)) {
+      // Only the accumulators are left to allocate.
+      state->table = config->table;
+      state->start_index = config->table->start_index;
+      state->end_index = config->table->end_index;
+      state->channel_frequency_starts = NULL;
+      state->channel_weight_starts = NULL;
+      state->channel_widths = NULL;
+      state->weights = NULL;
+      state->unweights = NULL;
+      state->work = malloc((config->num_channels + 1) * sizeof(*state->work));
+      if (state->work == NULL) {
+        fprintf(stderr, "Failed to allocate filterbank work buffer\n");
+        return 0;
+      }
+      return 1;
+    }
+    fprintf(stderr,
+            "Filterbank table does not match the config, computing it\n");
+  }
   const int num_channels_plus_1 = config->num_channels + 1;
 
   // How should we align things to index counts given the byte alignment?
@@ -30,6 +30,12 @@ struct FilterbankConfig {
   float lower_band_limit;
   // unused
   int output_scale_shift;
+  // Precomputed weights to use instead of computing them, when they were
+  // built for the same parameters. NULL to always compute them.
+  const struct FilterbankTable* table;
+  // set to true (1) for the lookup table square root in FilterbankSqrt, which
+  // is within 1 + x / 2^16 of the exact one (x its result before the shift)
+  int lut_sqrt;
 };
 
 // Fills the frontendConfig with "sane" defaults.
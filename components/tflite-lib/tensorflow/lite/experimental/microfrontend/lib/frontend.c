@@ -14,37 +14,38 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/experimental/microfrontend/lib/frontend.h"
 
-#include "tensorflow/lite/experimental/microfrontend/lib/bits.h"
+#include <string.h>
 
-struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
-                                             const int16_t* samples,
-                                             size_t num_samples,
-                                             size_t* num_samples_read) {
-  struct FrontendOutput output;
-  output.values = NULL;
-  output.size = 0;
-
-  // Try to apply the window - if it fails, return and wait for more data.
-  if (!WindowProcessSamples(&state->window, samples, num_samples,
-                            num_samples_read)) {
-    return output;
-  }
+#include "tensorflow/lite/experimental/microfrontend/lib/bits.h"
 
+// Runs the stages between the window and the log on state->window.output, and
+// returns the signal for the log stage along with its correction bits.
+static uint32_t* FrontendProcessSpectrum(struct FrontendState* state,
+                                         int* correction_bits) {
   // Apply the FFT to the window's output (and scale it so that the fixed point
   // FFT can have as much resolution as possible).
   int input_shift =
       15 - MostSignificantBit32(state->window.max_abs_output_value);
   FftCompute(&state->fft, state->window.output, input_shift);
 
-  // We can re-ruse the fft's output buffer to hold the energy.
-  int32_t* energy = (int32_t*)state->fft.output;
+  if (state->filterbank.table != NULL) {
+    FilterbankAccumulateSpectrum(&state->filterbank, state->fft.output);
+  } else {
+    // We can re-ruse the fft's output buffer to hold the energy.
+    int32_t* energy = (int32_t*)state->fft.output;
 
-  FilterbankConvertFftComplexToEnergy(&state->filterbank, state->fft.output,
-                                      energy);
+    FilterbankConvertFftComplexToEnergy(&state->filterbank, state->fft.output,
+                                        energy);
 
-  FilterbankAccumulateChannels(&state->filterbank, energy);
+    FilterbankAccumulateChannels(&state->filterbank, energy);
+  }
   uint32_t* scaled_filterbank = FilterbankSqrt(&state->filterbank, input_shift);
 
+  // Decide on voice against the noise estimate of the previous frames.
+  if (state->voice_activity.enable_vad) {
+    VoiceActivityApply(&state->voice_activity, scaled_filterbank);
+  }
+
   // Apply noise reduction.
   NoiseReductionApply(&state->noise_reduction, scaled_filterbank);
 
@@ -52,9 +53,21 @@ struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
     PcanGainControlApply(&state->pcan_gain_control, scaled_filterbank);
   }
 
-  // Apply the log and scale.
-  int correction_bits =
+  *correction_bits =
       MostSignificantBit32(state->fft.fft_size) - 1 - (kFilterbankBits / 2);
+  return scaled_filterbank;
+}
+
+// Runs the stages that follow the window on state->window.output.
+static struct FrontendOutput FrontendProcessWindow(
+    struct FrontendState* state) {
+  struct FrontendOutput output;
+
+  int correction_bits;
+  uint32_t* scaled_filterbank =
+      FrontendProcessSpectrum(state, &correction_bits);
+
+  // Apply the log and scale.
   uint16_t* logged_filterbank =
       LogScaleApply(&state->log_scale, scaled_filterbank,
                     state->filterbank.num_channels, correction_bits);
@@ -64,9 +77,68 @@ struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
   return output;
 }
 
+struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
+                                             const int16_t* samples,
+                                             size_t num_samples,
+                                             size_t* num_samples_read) {
+  struct FrontendOutput output;
+  output.values = NULL;
+  output.size = 0;
+
+  // Try to apply the window - if it fails, return and wait for more data.
+  if (!WindowProcessSamples(&state->window, samples, num_samples,
+                            num_samples_read)) {
+    return output;
+  }
+
+  return FrontendProcessWindow(state);
+}
+
+struct FrontendOutput FrontendProcessFrame(struct FrontendState* state,
+                                           const int16_t* frame) {
+  WindowProcessFrame(&state->window, frame);
+  return FrontendProcessWindow(state);
+}
+
+void FrontendProcessFrames(struct FrontendState* state, const int16_t* samples,
+                           size_t num_frames, uint16_t* output) {
+  const size_t step = state->window.step;
+  size_t i;
+  for (i = 0; i < num_frames; ++i) {
+    WindowProcessFrame(&state->window, samples + i * step);
+    const struct FrontendOutput frame_output = FrontendProcessWindow(state);
+    memcpy(output, frame_output.values,
+           frame_output.size * sizeof(*frame_output.values));
+    output += frame_output.size;
+  }
+}
+
+uint32_t FrontendProcessFramesInt8(struct FrontendState* state,
+                                   const int16_t* samples, size_t num_frames,
+                                   int8_t* output, uint8_t* voiced) {
+  const size_t step = state->window.step;
+  const int num_channels = state->filterbank.num_channels;
+  uint32_t sum = 0;
+  size_t i;
+  for (i = 0; i < num_frames; ++i) {
+    WindowProcessFrame(&state->window, samples + i * step);
+    int correction_bits;
+    uint32_t* scaled_filterbank =
+        FrontendProcessSpectrum(state, &correction_bits);
+    sum = LogScaleApplyInt8(&state->log_scale, scaled_filterbank, num_channels,
+                            correction_bits, output);
+    output += num_channels;
+    if (voiced != NULL) {
+      voiced[i] = (uint8_t)state->voice_activity.is_voiced;
+    }
+  }
+  return sum;
+}
+
 void FrontendReset(struct FrontendState* state) {
   WindowReset(&state->window);
   FftReset(&state->fft);
   FilterbankReset(&state->filterbank);
   NoiseReductionReset(&state->noise_reduction);
+  VoiceActivityReset(&state->voice_activity);
 }
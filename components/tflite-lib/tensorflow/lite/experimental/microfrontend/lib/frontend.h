@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/microfrontend/lib/log_scale.h"
 #include "tensorflow/lite/experimental/microfrontend/lib/noise_reduction.h"
 #include "tensorflow/lite/experimental/microfrontend/lib/pcan_gain_control.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/voice_activity.h"
 #include "tensorflow/lite/experimental/microfrontend/lib/window.h"
 
 #ifdef __cplusplus
@@ -36,6 +37,7 @@ struct FrontendState {
   struct NoiseReductionState noise_reduction;
   struct PcanGainControlState pcan_gain_control;
   struct LogScaleState log_scale;
+  struct VoiceActivityState voice_activity;
 };
 
 struct FrontendOutput {
@@ -55,6 +57,27 @@ struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
                                              size_t num_samples,
                                              size_t* num_samples_read);
 
+// Same as FrontendProcessSamples for a caller that already holds a whole
+// window of state->window.size samples, which are read in place. Frames are
+// expected to advance by the window step, do not mix both entry points.
+struct FrontendOutput FrontendProcessFrame(struct FrontendState* state,
+                                           const int16_t* frame);
+
+// Runs num_frames consecutive frames through FrontendProcessFrame in one call:
+// frame i starts at samples + i * state->window.step, so samples holds
+// (num_frames - 1) * step + size samples. The num_channels outputs of frame i
+// are copied to output + i * num_channels.
+void FrontendProcessFrames(struct FrontendState* state, const int16_t* samples,
+                           size_t num_frames, uint16_t* output);
+
+// Same as FrontendProcessFrames, with the outputs quantized to int8 by the log
+// stage (see LogScaleQuantize). Returns the sum of the 16 bit outputs of the
+// last frame. Unless it is NULL, voiced[i] receives the voice activity decision
+// of frame i (0 when the voice activity stage is disabled).
+uint32_t FrontendProcessFramesInt8(struct FrontendState* state,
+                                   const int16_t* samples, size_t num_frames,
+                                   int8_t* output, uint8_t* voiced);
+
 void FrontendReset(struct FrontendState* state);
 
 #ifdef __cplusplus
@@ -0,0 +1,64 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_FRONTEND_KERNELS_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_FRONTEND_KERNELS_H_
+
+#include <stdint.h>
+
+#include "tensorflow/lite/experimental/microfrontend/lib/fft.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/filterbank.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/window.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The per-stage kernels behind the frontend. The stage functions (the window
+// of WindowProcessSamples/WindowProcessFrame, FftCompute and
+// FilterbankConvertFftComplexToEnergy) run the Optimized kernels when the
+// library is built with MICROFRONTEND_OPTIMIZED and the Reference ones
+// otherwise. Both sets are always compiled so that they can be checked against
+// each other, and the optimized ones are bit-exact with the reference on any
+// state built by FrontendPopulateState.
+//
+// The optimized window and energy need a SIMD unit that GCC vector extensions
+// lower to (FRONTEND_KERNELS_VECTORIZE). Without one, as on the ESP32, the
+// stage functions keep the reference window and energy and
+// MICROFRONTEND_OPTIMIZED only changes the FFT.
+#if defined(__GNUC__) && (defined(__SSE2__) || defined(__ARM_NEON)) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define FRONTEND_KERNELS_VECTORIZE 1
+#endif
+
+void WindowApplyReference(struct WindowState* state, const int16_t* input);
+void WindowApplyOptimized(struct WindowState* state, const int16_t* input);
+
+void FftComputeReference(struct FftState* state, const int16_t* input,
+                         int input_scale_shift);
+// The 512 point transform only, other sizes go to the reference. Leaves
+// state->input untouched, the scaled input is read straight into the output.
+void FftComputeOptimized(struct FftState* state, const int16_t* input,
+                         int input_scale_shift);
+
+void FilterbankConvertFftComplexToEnergyReference(
+    struct FilterbankState* state, struct complex_int16_t* fft_output,
+    int32_t* energy);
+void FilterbankConvertFftComplexToEnergyOptimized(
+    struct FilterbankState* state, struct complex_int16_t* fft_output,
+    int32_t* energy);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_FRONTEND_KERNELS_H_
@@ -0,0 +1,162 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <stdint.h>
+#include <string.h>
+
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend_kernels.h"
+
+#ifdef FRONTEND_KERNELS_VECTORIZE
+// The window and energy run four or eight lanes at a time on the SIMD unit.
+// SSE2 has no 32 bit lane multiply, so there they are written with its 16 bit
+// multiplies instead of the GCC vector extensions.
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FRONTEND_KERNELS_SSE2 1
+#endif
+
+typedef int16_t fk_v8hi __attribute__((vector_size(16)));
+typedef uint16_t fk_v8hu __attribute__((vector_size(16)));
+typedef int32_t fk_v4si __attribute__((vector_size(16)));
+typedef uint32_t fk_v4su __attribute__((vector_size(16)));
+typedef int32_t fk_v8si __attribute__((vector_size(32)));
+
+// Unaligned loads and stores, the buffers are only guaranteed to be aligned to
+// their element type.
+static inline fk_v8hi LoadV8hi(const int16_t* p) {
+  fk_v8hi v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline fk_v4si LoadV4si(const void* p) {
+  fk_v4si v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void StoreV8hi(int16_t* p, fk_v8hi v) { memcpy(p, &v, sizeof(v)); }
+
+static inline void StoreV4su(void* p, fk_v4su v) { memcpy(p, &v, sizeof(v)); }
+
+void WindowApplyOptimized(struct WindowState* state, const int16_t* input) {
+  const int size = state->size;
+  const int16_t* coefficients = state->coefficients;
+  int16_t* output = state->output;
+  int16_t max_abs_output_value = 0;
+  int i = 0;
+#if defined(FRONTEND_KERNELS_SSE2)
+  __m128i max_abs = _mm_setzero_si128();
+  for (; i + 8 <= size; i += 8) {
+    const __m128i x = _mm_loadu_si128((const __m128i*)(input + i));
+    const __m128i c = _mm_loadu_si128((const __m128i*)(coefficients + i));
+    // Bits kFrontendWindowBits to kFrontendWindowBits + 15 of the 32 bit
+    // products, taken from their low and high halves.
+    const __m128i value = _mm_or_si128(
+        _mm_slli_epi16(_mm_mulhi_epi16(x, c), 16 - kFrontendWindowBits),
+        _mm_srli_epi16(_mm_mullo_epi16(x, c), kFrontendWindowBits));
+    _mm_storeu_si128((__m128i*)(output + i), value);
+    // The absolute value wraps like the int16_t negation of the reference, so
+    // -32768 stays negative and never becomes the maximum.
+    const __m128i sign = _mm_srai_epi16(value, 15);
+    max_abs = _mm_max_epi16(
+        max_abs, _mm_sub_epi16(_mm_xor_si128(value, sign), sign));
+  }
+  int16_t lanes[8];
+  _mm_storeu_si128((__m128i*)lanes, max_abs);
+  int lane;
+  for (lane = 0; lane < 8; ++lane) {
+    if (lanes[lane] > max_abs_output_value) {
+      max_abs_output_value = lanes[lane];
+    }
+  }
+#else
+  fk_v8hi max_abs = {0};
+  for (; i + 8 <= size; i += 8) {
+    const fk_v8si product =
+        __builtin_convertvector(LoadV8hi(input + i), fk_v8si) *
+        __builtin_convertvector(LoadV8hi(coefficients + i), fk_v8si);
+    const fk_v8hi value =
+        __builtin_convertvector(product >> kFrontendWindowBits, fk_v8hi);
+    StoreV8hi(output + i, value);
+    const fk_v8hu sign = (fk_v8hu)(value >> 15);
+    const fk_v8hi abs_value = (fk_v8hi)(((fk_v8hu)value ^ sign) - sign);
+    const fk_v8hi greater = abs_value > max_abs;
+    max_abs = (abs_value & greater) | (max_abs & ~greater);
+  }
+  int lane;
+  for (lane = 0; lane < 8; ++lane) {
+    if (max_abs[lane] > max_abs_output_value) {
+      max_abs_output_value = max_abs[lane];
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    int16_t new_value =
+        (((int32_t)input[i]) * coefficients[i]) >> kFrontendWindowBits;
+    output[i] = new_value;
+    if (new_value < 0) {
+      new_value = -new_value;
+    }
+    if (new_value > max_abs_output_value) {
+      max_abs_output_value = new_value;
+    }
+  }
+  state->max_abs_output_value = max_abs_output_value;
+}
+
+void FilterbankConvertFftComplexToEnergyOptimized(
+    struct FilterbankState* state, struct complex_int16_t* fft_output,
+    int32_t* energy) {
+  const int end_index = state->end_index;
+  int i = state->start_index;
+#if defined(FRONTEND_KERNELS_SSE2)
+  // real * real + imag * imag of four complex values at once. energy may be
+  // fft_output itself, every block is read before it is written.
+  for (; i + 4 <= end_index; i += 4) {
+    const __m128i packed = _mm_loadu_si128((const __m128i*)(fft_output + i));
+    _mm_storeu_si128((__m128i*)(energy + i), _mm_madd_epi16(packed, packed));
+  }
+#else
+  // Each 32 bit lane holds one complex value with the real part in its low
+  // half. energy may be fft_output itself, every block is read before it is
+  // written.
+  for (; i + 4 <= end_index; i += 4) {
+    const fk_v4si packed = LoadV4si(fft_output + i);
+    const fk_v4su real = (fk_v4su)((fk_v4si)((fk_v4su)packed << 16) >> 16);
+    const fk_v4su imag = (fk_v4su)(packed >> 16);
+    StoreV4su(energy + i, real * real + imag * imag);
+  }
+#endif
+  for (; i < end_index; ++i) {
+    const int32_t real = fft_output[i].real;
+    const int32_t imag = fft_output[i].imag;
+    const uint32_t mag_squared =
+        ((uint32_t)real * real) + ((uint32_t)imag * imag);
+    energy[i] = mag_squared;
+  }
+}
+
+#else
+// Without a SIMD unit (the Xtensa cores of the ESP32) there is nothing to gain
+// over the reference loops, and the stage functions call the reference kernels
+// directly; these only keep the bench linking.
+void WindowApplyOptimized(struct WindowState* state, const int16_t* input) {
+  WindowApplyReference(state, input);
+}
+
+void FilterbankConvertFftComplexToEnergyOptimized(
+    struct FilterbankState* state, struct complex_int16_t* fft_output,
+    int32_t* energy) {
+  FilterbankConvertFftComplexToEnergyReference(state, fft_output, energy);
+}
+#endif  // FRONTEND_KERNELS_VECTORIZE
@@ -25,6 +25,7 @@ void FrontendFillConfigWithDefaults(struct FrontendConfig* config) {
   NoiseReductionFillConfigWithDefaults(&config->noise_reduction);
   PcanGainControlFillConfigWithDefaults(&config->pcan_gain_control);
   LogScaleFillConfigWithDefaults(&config->log_scale);
+  VoiceActivityFillConfigWithDefaults(&config->voice_activity);
 }
 
 int FrontendPopulateState(const struct FrontendConfig* config,
@@ -70,6 +71,14 @@ int FrontendPopulateState(const struct FrontendConfig* config,
     return 0;
   }
 
+  if (!VoiceActivityPopulateState(
+          &config->voice_activity, &state->voice_activity,
+          state->noise_reduction.estimate, state->filterbank.num_channels,
+          state->noise_reduction.smoothing_bits)) {
+    fprintf(stderr, "Failed to populate voice activity state\n");
+    return 0;
+  }
+
   FrontendReset(state);
 
   // All good, return a true value.
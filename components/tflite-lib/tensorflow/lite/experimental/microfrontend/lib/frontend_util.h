@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/microfrontend/lib/log_scale_util.h"
 #include "tensorflow/lite/experimental/microfrontend/lib/noise_reduction_util.h"
 #include "tensorflow/lite/experimental/microfrontend/lib/pcan_gain_control_util.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/voice_activity_util.h"
 #include "tensorflow/lite/experimental/microfrontend/lib/window_util.h"
 
 #ifdef __cplusplus
@@ -33,6 +34,7 @@ struct FrontendConfig {
   struct NoiseReductionConfig noise_reduction;
   struct PcanGainControlConfig pcan_gain_control;
   struct LogScaleConfig log_scale;
+  struct VoiceActivityConfig voice_activity;
 };
 
 // Fills the frontendConfig with "sane" defaults.
@@ -28,3 +28,32 @@ const uint16_t kLogLut[]
        3759, 3668, 3575, 3481, 3384, 3286, 3186, 3084, 2981, 2875, 2768, 2659,
        2549, 2437, 2323, 2207, 2090, 1971, 1851, 1729, 1605, 1480, 1353, 1224,
        1094, 963,  830,  695,  559,  421,  282,  142,  0,    0};
+
+const uint16_t kLogFractionLut[]
+#ifndef _MSC_VER
+    __attribute__((aligned(4)))
+#endif  // _MSV_VER
+    = {0,     256,   510,   764,   1016,  1268,  1518,  1768,  2017,  2264,  2511,
+       2757,  3002,  3246,  3489,  3732,  3973,  4214,  4453,  4692,  4930,  5167,
+       5403,  5638,  5873,  6106,  6339,  6571,  6802,  7033,  7262,  7491,  7719,
+       7946,  8173,  8398,  8623,  8847,  9070,  9293,  9515,  9736,  9956,  10176,
+       10394, 10612, 10830, 11046, 11262, 11478, 11692, 11906, 12119, 12332, 12543,
+       12754, 12965, 13174, 13383, 13592, 13800, 14007, 14213, 14419, 14624, 14828,
+       15032, 15235, 15438, 15640, 15841, 16042, 16242, 16442, 16641, 16839, 17037,
+       17234, 17430, 17626, 17821, 18016, 18210, 18404, 18597, 18790, 18981, 19173,
+       19364, 19554, 19743, 19933, 20121, 20309, 20497, 20684, 20870, 21056, 21241,
+       21426, 21611, 21795, 21978, 22161, 22343, 22525, 22706, 22887, 23067, 23247,
+       23426, 23605, 23783, 23961, 24139, 24315, 24492, 24668, 24843, 25018, 25193,
+       25367, 25540, 25714, 25886, 26059, 26230, 26402, 26573, 26743, 26913, 27083,
+       27252, 27420, 27589, 27756, 27924, 28091, 28257, 28424, 28589, 28754, 28919,
+       29084, 29248, 29412, 29575, 29738, 29900, 30062, 30224, 30385, 30546, 30706,
+       30866, 31026, 31185, 31344, 31502, 31661, 31818, 31976, 32133, 32289, 32445,
+       32601, 32757, 32912, 33067, 33221, 33375, 33529, 33682, 33835, 33987, 34140,
+       34292, 34443, 34594, 34745, 34896, 35046, 35196, 35345, 35494, 35643, 35791,
+       35939, 36087, 36235, 36382, 36529, 36675, 36821, 36967, 37112, 37258, 37402,
+       37547, 37691, 37835, 37979, 38122, 38265, 38407, 38550, 38692, 38833, 38975,
+       39116, 39257, 39397, 39537, 39677, 39817, 39956, 40095, 40234, 40372, 40510,
+       40648, 40786, 40923, 41060, 41196, 41333, 41469, 41605, 41740, 41876, 42011,
+       42145, 42280, 42414, 42548, 42681, 42815, 42948, 43081, 43213, 43345, 43477,
+       43609, 43741, 43872, 44003, 44133, 44264, 44394, 44524, 44654, 44783, 44912,
+       45041, 45170, 45298, 45426};
@@ -33,6 +33,13 @@ extern "C" {
 
 extern const uint16_t kLogLut[];
 
+// Natural logarithm of the mantissa rounded to kLogFractionBits fractional
+// bits, in kLogScale units: kLogFractionLut[k] = round(ln(1 + k / 256) *
+// kLogScale) for k in [0, 256].
+#define kLogFractionBits 8
+
+extern const uint16_t kLogFractionLut[];
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
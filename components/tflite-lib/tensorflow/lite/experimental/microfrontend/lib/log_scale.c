@@ -57,8 +57,12 @@ static uint32_t Log(const uint32_t x, const uint32_t scale_shift) {
   return loge_scaled;
 }
 
-uint16_t* LogScaleApply(struct LogScaleState* state, uint32_t* signal,
-                        int signal_size, int correction_bits) {
+// Without int8_output the values are written over the signal as 16 bit, with
+// it they are quantized there and summed into sum instead.
+static uint16_t* LogScaleApplyExact(struct LogScaleState* state,
+                                    uint32_t* signal, int signal_size,
+                                    int correction_bits, int8_t* int8_output,
+                                    uint32_t* sum) {
   const int scale_shift = state->scale_shift;
   uint16_t* output = (uint16_t*)signal;
   uint16_t* ret = output;
@@ -77,7 +81,80 @@ uint16_t* LogScaleApply(struct LogScaleState* state, uint32_t* signal,
         value = 0;
       }
     }
-    *output++ = (value < kuint16max) ? value : kuint16max;
+    value = (value < kuint16max) ? value : kuint16max;
+    if (int8_output != NULL) {
+      *sum += value;
+      *int8_output++ = LogScaleQuantize(state, value);
+    } else {
+      *output++ = value;
+    }
+  }
+  return ret;
+}
+
+// Log with the mantissa rounded to kLogFractionBits and looked up, instead of
+// interpolated in log2 and converted. Rounding the mantissa moves the natural
+// log by at most 2^-9, an eighth of a unit of the default scale_shift of 6.
+static uint32_t LogLut(const uint32_t x, const uint32_t scale_shift) {
+  const uint32_t integer = MostSignificantBit32(x) - 1;
+  uint32_t mantissa;
+  if (integer > kLogFractionBits) {
+    mantissa = ((x >> (integer - kLogFractionBits - 1)) + 1) >> 1;
+  } else {
+    mantissa = x << (kLogFractionBits - integer);
+  }
+  const uint32_t fraction = mantissa - (1U << kLogFractionBits);
+  const uint32_t round = kLogScale / 2;
+  const uint32_t loge = integer * kLogCoeff + kLogFractionLut[fraction];
+  const uint32_t loge_scaled = ((loge << scale_shift) + round) >> kLogScaleLog2;
+  return loge_scaled;
+}
+
+static uint16_t* LogScaleApplyLut(struct LogScaleState* state, uint32_t* signal,
+                                  int signal_size, int correction_bits,
+                                  int8_t* int8_output, uint32_t* sum) {
+  const int scale_shift = state->scale_shift;
+  uint16_t* output = (uint16_t*)signal;
+  uint16_t* ret = output;
+  int i;
+  for (i = 0; i < signal_size; ++i) {
+    uint32_t value = *signal++;
+    if (correction_bits < 0) {
+      value >>= -correction_bits;
+    } else {
+      value <<= correction_bits;
+    }
+    value = value > 1 ? LogLut(value, scale_shift) : 0;
+    value = (value < kuint16max) ? value : kuint16max;
+    if (int8_output != NULL) {
+      *sum += value;
+      *int8_output++ = LogScaleQuantize(state, value);
+    } else {
+      *output++ = value;
+    }
   }
   return ret;
 }
+
+uint16_t* LogScaleApply(struct LogScaleState* state, uint32_t* signal,
+                        int signal_size, int correction_bits) {
+  if (state->enable_log && state->lut_log) {
+    return LogScaleApplyLut(state, signal, signal_size, correction_bits, NULL,
+                            NULL);
+  }
+  return LogScaleApplyExact(state, signal, signal_size, correction_bits, NULL,
+                            NULL);
+}
+
+uint32_t LogScaleApplyInt8(struct LogScaleState* state, uint32_t* signal,
+                           int signal_size, int correction_bits,
+                           int8_t* output) {
+  uint32_t sum = 0;
+  if (state->enable_log && state->lut_log) {
+    LogScaleApplyLut(state, signal, signal_size, correction_bits, output, &sum);
+  } else {
+    LogScaleApplyExact(state, signal, signal_size, correction_bits, output,
+                       &sum);
+  }
+  return sum;
+}
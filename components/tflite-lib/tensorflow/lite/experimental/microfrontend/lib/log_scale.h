@@ -25,13 +25,42 @@ extern "C" {
 struct LogScaleState {
   int enable_log;
   int scale_shift;
+  int lut_log;
+  // 1 / int8_step as int8_multiplier / 2^int8_shift.
+  uint32_t int8_multiplier;
+  int int8_shift;
+  int int8_zero_point;
 };
 
+// Quantizes a 16 bit output value to round(value / int8_step) + int8_zero_point,
+// clamped to int8, without a division.
+static inline int8_t LogScaleQuantize(const struct LogScaleState* state,
+                                      uint32_t value) {
+  const uint64_t round = ((uint64_t)1) << (state->int8_shift - 1);
+  uint64_t scaled =
+      (value * (uint64_t)state->int8_multiplier + round) >> state->int8_shift;
+  if (scaled > 255) {
+    scaled = 255;
+  }
+  int32_t quantized = (int32_t)scaled + state->int8_zero_point;
+  if (quantized > 127) {
+    quantized = 127;
+  }
+  return (int8_t)quantized;
+}
+
 // Applies a fixed point logarithm to the signal and converts it to 16 bit. Note
 // that the signal array will be modified.
 uint16_t* LogScaleApply(struct LogScaleState* state, uint32_t* signal,
                         int signal_size, int correction_bits);
 
+// Same as LogScaleApply, with each 16 bit value quantized by LogScaleQuantize
+// into output as it is computed, leaving the signal unchanged. Returns the sum
+// of the 16 bit values.
+uint32_t LogScaleApplyInt8(struct LogScaleState* state, uint32_t* signal,
+                           int signal_size, int correction_bits,
+                           int8_t* output);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -14,14 +14,45 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/experimental/microfrontend/lib/log_scale_util.h"
 
+#include <math.h>
+#include <stdio.h>
+
 void LogScaleFillConfigWithDefaults(struct LogScaleConfig* config) {
   config->enable_log = 1;
   config->scale_shift = 6;
+  config->lut_log = 0;
+  config->int8_step = 256.0;
+  config->int8_zero_point = -128;
 }
 
 int LogScalePopulateState(const struct LogScaleConfig* config,
                           struct LogScaleState* state) {
   state->enable_log = config->enable_log;
   state->scale_shift = config->scale_shift;
+  state->lut_log = config->lut_log;
+
+  if (!(config->int8_step > 0) || config->int8_zero_point < -128 ||
+      config->int8_zero_point > 127) {
+    fprintf(stderr, "Unsupported int8 step %g and zero point %d\n",
+            (double)config->int8_step, config->int8_zero_point);
+    return 0;
+  }
+  // 1 / int8_step = fraction * 2^exponent with fraction in [0.5, 1), keep 32
+  // bits of the fraction.
+  int exponent;
+  const double fraction = frexp(1.0 / (double)config->int8_step, &exponent);
+  uint64_t multiplier = (uint64_t)(fraction * 4294967296.0 + 0.5);
+  int shift = 32 - exponent;
+  if (multiplier == ((uint64_t)1) << 32) {
+    multiplier >>= 1;
+    --shift;
+  }
+  if (shift < 1 || shift > 63) {
+    fprintf(stderr, "int8 step %g out of range\n", (double)config->int8_step);
+    return 0;
+  }
+  state->int8_multiplier = (uint32_t)multiplier;
+  state->int8_shift = shift;
+  state->int8_zero_point = config->int8_zero_point;
   return 1;
 }
@@ -29,6 +29,13 @@ struct LogScaleConfig {
   int enable_log;
   // scale results by 2^(scale_shift)
   int scale_shift;
+  // set to true (1) for the lookup table logarithm, which is within 1 of the
+  // exact one
+  int lut_log;
+  // int8 output of LogScaleApplyInt8: round(value / int8_step) +
+  // int8_zero_point, clamped
+  float int8_step;
+  int int8_zero_point;
 };
 
 // Populates the LogScaleConfig with "sane" default values.
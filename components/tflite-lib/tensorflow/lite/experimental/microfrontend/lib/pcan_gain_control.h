@@ -18,6 +18,8 @@ limitations under the License.
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "tensorflow/lite/experimental/microfrontend/lib/bits.h"
+
 #define kPcanSnrBits 12
 #define kPcanOutputBits 6
 
@@ -34,9 +36,34 @@ struct PcanGainControlState {
   int32_t snr_shift;
 };
 
-int16_t WideDynamicFunction(const uint32_t x, const int16_t* lut);
+// Inline, PcanGainControlApply calls them per channel.
+static inline int16_t WideDynamicFunction(const uint32_t x, const int16_t* lut) {
+  if (x <= 2) {
+    return lut[x];
+  }
+
+  const int16_t interval = MostSignificantBit32(x);
+  lut += 4 * interval - 6;
+
+  const int16_t frac =
+      ((interval < 11) ? (x << (11 - interval)) : (x >> (interval - 11))) &
+      0x3FF;
+
+  int32_t result = ((int32_t)lut[2] * frac) >> 5;
+  result += (int32_t)((uint32_t)lut[1] << 5);
+  result *= frac;
+  result = (result + (1 << 14)) >> 15;
+  result += lut[0];
+  return (int16_t)result;
+}
 
-uint32_t PcanShrink(const uint32_t x);
+static inline uint32_t PcanShrink(const uint32_t x) {
+  if (x < (2 << kPcanSnrBits)) {
+    return (x * x) >> (2 + 2 * kPcanSnrBits - kPcanOutputBits);
+  } else {
+    return (x >> (kPcanSnrBits - kPcanOutputBits)) - (1 << kPcanOutputBits);
+  }
+}
 
 void PcanGainControlApply(struct PcanGainControlState* state, uint32_t* signal);
 
@@ -0,0 +1,39 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/microfrontend/lib/sqrt_lut.h"
+const uint32_t kSqrtLut[] = {
+    524288,  528368,  532417,  536435,  540424,  544383,  548314,  552216,
+    556091,  559940,  563762,  567558,  571330,  575076,  578798,  582497,
+    586172,  589824,  593454,  597061,  600647,  604212,  607756,  611279,
+    614782,  618265,  621729,  625174,  628599,  632006,  635395,  638766,
+    642119,  645455,  648773,  652075,  655360,  658629,  661881,  665118,
+    668339,  671544,  674734,  677910,  681070,  684216,  687347,  690465,
+    693568,  696657,  699733,  702795,  705844,  708880,  711903,  714913,
+    717911,  720896,  723869,  726829,  729778,  732715,  735640,  738553,
+    741455,  744346,  747225,  750094,  752951,  755798,  758634,  761460,
+    764275,  767079,  769874,  772658,  775432,  778197,  780952,  783697,
+    786432,  789158,  791875,  794582,  797280,  799969,  802649,  805320,
+    807982,  810636,  813280,  815917,  818544,  821164,  823775,  826378,
+    828972,  831559,  834137,  836708,  839270,  841825,  844372,  846912,
+    849444,  851968,  854485,  856994,  859497,  861991,  864479,  866960,
+    869433,  871900,  874359,  876812,  879258,  881697,  884129,  886555,
+    888974,  891386,  893792,  896191,  898584,  900971,  903351,  905726,
+    908093,  910455,  912811,  915160,  917504,  919842,  922173,  924499,
+    926819,  929133,  931442,  933744,  936041,  938333,  940619,  942899,
+    945174,  947443,  949707,  951965,  954219,  956466,  958709,  960946,
+    963179,  965406,  967627,  969844,  972056,  974263,  976464,  978661,
+    980853,  983040,  985222,  987399,  989572,  991740,  993903,  996061,
+    998215,  1000364, 1002508, 1004648, 1006783, 1008914, 1011040, 1013162,
+    1015279, 1017392, 1019501, 1021605, 1023705, 1025801, 1027892, 1029979,
+    1032062, 1034141, 1036215, 1038286, 1040352, 1042414, 1044472, 1046526,
+    1048576};
@@ -0,0 +1,34 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_SQRT_LUT_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_SQRT_LUT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Square roots of the normalized mantissas i * 2^24 for i in [64, 256], the
+// 8 top bits of a 31 or 32 bit mantissa, with kSqrtLutFractionBits fractional
+// bits: kSqrtLut[i - kSqrtLutFirst] = round(sqrt(i * 2^24) * 2^4).
+#define kSqrtLutFirst 64
+#define kSqrtLutFractionBits 4
+
+extern const uint32_t kSqrtLut[];
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_SQRT_LUT_H_
@@ -0,0 +1,55 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/microfrontend/lib/voice_activity.h"
+
+void VoiceActivityApply(struct VoiceActivityState* state,
+                        const uint32_t* signal) {
+  const int shift = state->smoothing_bits + kVoiceActivitySnrBits;
+  int voiced_channels = 0;
+  int i;
+  for (i = 0; i < state->num_channels; ++i) {
+    if (signal[i] < state->min_signal) {
+      continue;
+    }
+    // The estimate is scaled up by smoothing_bits like in NoiseReductionApply.
+    if (((uint64_t)signal[i] << shift) >
+        (uint64_t)state->noise_estimate[i] * state->snr_threshold) {
+      ++voiced_channels;
+    }
+  }
+
+  // The estimate starts from zero, every frame is above it until it has
+  // followed the noise for a while.
+  if (state->frame_count < state->warmup_frames) {
+    ++state->frame_count;
+    state->is_voiced = 0;
+    return;
+  }
+
+  if (voiced_channels >= state->min_voiced_channels) {
+    state->hangover = state->hangover_frames;
+    state->is_voiced = 1;
+  } else if (state->hangover > 0) {
+    // The estimate follows long words, keep them voiced to their end.
+    --state->hangover;
+    state->is_voiced = 1;
+  } else {
+    state->is_voiced = 0;
+  }
+}
+
+void VoiceActivityReset(struct VoiceActivityState* state) {
+  state->frame_count = 0;
+  state->hangover = 0;
+  state->is_voiced = 0;
+}
@@ -0,0 +1,58 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_VOICE_ACTIVITY_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_VOICE_ACTIVITY_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define kVoiceActivitySnrBits 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Voice activity decision from the filterbank energies and the noise estimate
+// of the noise reduction stage, so it costs no spectral analysis of its own.
+struct VoiceActivityState {
+  int enable_vad;
+  const uint32_t* noise_estimate;
+  int num_channels;
+  int smoothing_bits;
+  // channel over noise amplitude ratio, with kVoiceActivitySnrBits fractional
+  // bits
+  uint32_t snr_threshold;
+  uint32_t min_signal;
+  int min_voiced_channels;
+  int warmup_frames;
+  int hangover_frames;
+  // frames since the reset, up to warmup_frames
+  int frame_count;
+  // voiced frames still to report after the last voiced frame
+  int hangover;
+  // decision for the latest frame, 0 or 1
+  int is_voiced;
+};
+
+// Decides whether the frame holds voice. Runs on the filterbank output before
+// NoiseReductionApply, so the estimate only holds the noise of past frames.
+void VoiceActivityApply(struct VoiceActivityState* state,
+                        const uint32_t* signal);
+
+void VoiceActivityReset(struct VoiceActivityState* state);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_VOICE_ACTIVITY_H_
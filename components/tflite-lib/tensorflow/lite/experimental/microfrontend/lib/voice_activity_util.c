@@ -0,0 +1,59 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/microfrontend/lib/voice_activity_util.h"
+
+#include <math.h>
+#include <stdio.h>
+
+void VoiceActivityFillConfigWithDefaults(struct VoiceActivityConfig* config) {
+  config->enable_vad = 0;
+  config->snr_db = 6.0;
+  config->min_signal = 0.0;
+  config->min_voiced_channels = 0.25;
+  config->warmup_frames = 40;
+  config->hangover_frames = 20;
+}
+
+int VoiceActivityPopulateState(const struct VoiceActivityConfig* config,
+                               struct VoiceActivityState* state,
+                               const uint32_t* noise_estimate,
+                               int num_channels, int smoothing_bits) {
+  state->enable_vad = config->enable_vad;
+  if (!state->enable_vad) {
+    return 1;
+  }
+  if (config->snr_db < 0.0f || config->min_signal < 0.0f ||
+      config->min_voiced_channels < 0.0f ||
+      config->min_voiced_channels > 1.0f || config->warmup_frames < 0 ||
+      config->hangover_frames < 0) {
+    fprintf(stderr, "Invalid voice activity config\n");
+    return 0;
+  }
+  state->noise_estimate = noise_estimate;
+  state->num_channels = num_channels;
+  state->smoothing_bits = smoothing_bits;
+  // The filterbank output is an amplitude, the square root of the energy.
+  state->snr_threshold = (uint32_t)(powf(10.0f, config->snr_db / 20.0f) *
+                                        (1 << kVoiceActivitySnrBits) +
+                                    0.5f);
+  state->min_signal = (uint32_t)config->min_signal;
+  state->min_voiced_channels =
+      (int)ceilf(config->min_voiced_channels * num_channels);
+  if (state->min_voiced_channels < 1) {
+    state->min_voiced_channels = 1;
+  }
+  state->warmup_frames = config->warmup_frames;
+  state->hangover_frames = config->hangover_frames;
+  VoiceActivityReset(state);
+  return 1;
+}
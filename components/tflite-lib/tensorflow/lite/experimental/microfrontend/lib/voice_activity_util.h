@@ -0,0 +1,50 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_VOICE_ACTIVITY_UTIL_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_VOICE_ACTIVITY_UTIL_H_
+
+#include "tensorflow/lite/experimental/microfrontend/lib/voice_activity.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct VoiceActivityConfig {
+  // set to false (0) to disable this module
+  int enable_vad;
+  // a channel is voiced when it is this far above its noise estimate
+  float snr_db;
+  // channels below this filterbank output are never voiced
+  float min_signal;
+  // share of voiced channels (0 to 1) for the frame to be voiced
+  float min_voiced_channels;
+  // frames after a reset that are never voiced, while the noise estimate
+  // settles
+  int warmup_frames;
+  // frames still voiced after the last voiced one
+  int hangover_frames;
+};
+
+// Populates the VoiceActivityConfig with "sane" default values.
+void VoiceActivityFillConfigWithDefaults(struct VoiceActivityConfig* config);
+
+int VoiceActivityPopulateState(const struct VoiceActivityConfig* config,
+                               struct VoiceActivityState* state,
+                               const uint32_t* noise_estimate,
+                               int num_channels, int smoothing_bits);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_MICROFRONTEND_LIB_VOICE_ACTIVITY_UTIL_H_
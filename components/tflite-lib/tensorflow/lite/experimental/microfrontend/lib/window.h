@@ -40,6 +40,11 @@ struct WindowState {
 int WindowProcessSamples(struct WindowState* state, const int16_t* samples,
                          size_t num_samples, size_t* num_samples_read);
 
+// Applies the window to state->size samples read in place from frame, without
+// going through the input buffer. Successive frames are expected to be step
+// samples apart, do not mix with WindowProcessSamples.
+int WindowProcessFrame(struct WindowState* state, const int16_t* frame);
+
 void WindowReset(struct WindowState* state);
 
 #ifdef __cplusplus
@@ -30,9 +30,27 @@ limitations under the License.
 namespace tflite {
 namespace {
 
+ConvFusedPadding* FusedPadding(void* user_data) {
+  return &static_cast<OpDataConv*>(user_data)->fused_padding;
+}
+
+bool* PackedWeights(void* user_data) {
+  return &static_cast<OpDataConv*>(user_data)->packed_weights;
+}
+
+const OperatorHooks kOperatorHooks = {
+    FusedPadding, /*accepts_fused_padding=*/nullptr, PackedWeights};
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context, sizeof(OpDataConv));
+  OpDataConv* data = static_cast<OpDataConv*>(
+      context->AllocatePersistentBuffer(context, sizeof(OpDataConv)));
+  if (data != nullptr) {
+    data->fused_padding = {};
+    data->packed_weights = false;
+    GetMicroContext(context)->SetOperatorHooks(&kOperatorHooks);
+  }
+  return data;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
@@ -112,6 +130,10 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       break;
     }
     case kTfLiteInt8: {
+      if (data.packed_weights) {
+        EvalPackedConvPerChannel(params, data, input, filter, bias, output);
+        break;
+      }
       reference_integer_ops::ConvPerChannel(
           ConvParamsQuantized(params, data), data.per_channel_output_multiplier,
           data.per_channel_output_shift, tflite::micro::GetTensorShape(input),
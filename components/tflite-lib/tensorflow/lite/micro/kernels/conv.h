@@ -24,8 +24,23 @@ limitations under the License.
 
 namespace tflite {
 
+// Explicit padding of a PAD operator that MicroInterpreter::AllocateTensors()
+// fused into the convolution reading it, whose input is then the unpadded
+// tensor. All zero otherwise.
+struct ConvFusedPadding {
+  int top;
+  int bottom;
+  int left;
+  int right;
+};
+
 struct OpDataConv {
   TfLitePaddingValues padding;
+  ConvFusedPadding fused_padding;
+  // Set by MicroInterpreter::AllocateTensors() when the model lists the
+  // operator in its kPackedWeightsMetadata: the filter and bias are in the
+  // layout of packed_weights.h.
+  bool packed_weights;
 
   // Cached tensor zero point values for quantized operations.
   int32_t input_zero_point;
@@ -72,6 +87,14 @@ TfLiteStatus CalculateOpDataConv(TfLiteContext* context, TfLiteNode* node,
 
 TfLiteStatus ConvPrepare(TfLiteContext* context, TfLiteNode* node);
 
+// Int8 convolution of an operator whose data.packed_weights is set.
+void EvalPackedConvPerChannel(const TfLiteConvParams& params,
+                              const OpDataConv& data,
+                              const TfLiteEvalTensor* input,
+                              const TfLiteEvalTensor* filter,
+                              const TfLiteEvalTensor* bias,
+                              TfLiteEvalTensor* output);
+
 // This is the most generic TfLiteRegistration. The actual supported types may
 // still be target dependent. The only requirement is that every implementation
 // (reference or optimized) must define this function.
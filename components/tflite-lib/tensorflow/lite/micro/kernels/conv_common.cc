@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/padding.h"
 #include "tensorflow/lite/micro/kernels/conv.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
 
 namespace tflite {
 
@@ -86,12 +87,18 @@ TfLiteStatus CalculateOpDataConv(TfLiteContext* context, TfLiteNode* node,
   TF_LITE_ENSURE(context, has_bias || node->inputs->size == 2);
   TF_LITE_ENSURE_EQ(context, node->outputs->size, 1);
 
-  // Matching GetWindowedOutputSize in TensorFlow.
+  // Matching GetWindowedOutputSize in TensorFlow, over the input as the fused
+  // PAD would have padded it. Its bottom and right rows need no padding
+  // values, the kernels skip the taps past the end of the input.
+  const ConvFusedPadding& fused = data->fused_padding;
   auto padding = params.padding;
   data->padding = ComputePaddingHeightWidth(
       params.stride_height, params.stride_width, params.dilation_height_factor,
-      params.dilation_width_factor, height, width, filter_height, filter_width,
-      padding, &out_height, &out_width);
+      params.dilation_width_factor, height + fused.top + fused.bottom,
+      width + fused.left + fused.right, filter_height, filter_width, padding,
+      &out_height, &out_width);
+  data->padding.height += fused.top;
+  data->padding.width += fused.left;
 
   MicroContext* micro_context = GetMicroContext(context);
 
@@ -124,6 +131,22 @@ TfLiteStatus CalculateOpDataConv(TfLiteContext* context, TfLiteNode* node,
   data->filter_zero_point = filter->params.zero_point;
   data->output_zero_point = output->params.zero_point;
 
+  // The packed kernel folds the input offset into the bias and needs
+  // symmetric filters.
+  if (data->packed_weights) {
+    TF_LITE_ENSURE_EQ(context, data_type, kTfLiteInt8);
+    TF_LITE_ENSURE(context, has_bias && bias != nullptr);
+    TF_LITE_ENSURE(context, params.dilation_width_factor == 1 &&
+                                params.dilation_height_factor == 1);
+    const auto* affine_quantization =
+        static_cast<TfLiteAffineQuantization*>(filter->quantization.params);
+    TF_LITE_ENSURE(context, affine_quantization != nullptr &&
+                                affine_quantization->zero_point != nullptr);
+    for (int i = 0; i < affine_quantization->zero_point->size; ++i) {
+      TF_LITE_ENSURE_EQ(context, affine_quantization->zero_point->data[i], 0);
+    }
+  }
+
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(filter);
   micro_context->DeallocateTempTfLiteTensor(output);
@@ -194,4 +217,50 @@ TfLiteStatus ConvPrepare(TfLiteContext* context, TfLiteNode* node) {
 
   return kTfLiteOk;
 }
+void EvalPackedConvPerChannel(const TfLiteConvParams& params,
+                              const OpDataConv& data,
+                              const TfLiteEvalTensor* input,
+                              const TfLiteEvalTensor* filter,
+                              const TfLiteEvalTensor* bias,
+                              TfLiteEvalTensor* output) {
+  const RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+  const RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+  const RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+
+  PackedConvParams packed_params;
+  packed_params.input_height = input_shape.Dims(1);
+  packed_params.input_width = input_shape.Dims(2);
+  packed_params.input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  packed_params.filter_height = filter_shape.Dims(1);
+  packed_params.filter_width = filter_shape.Dims(2);
+  packed_params.output_height = output_shape.Dims(1);
+  packed_params.output_width = output_shape.Dims(2);
+  packed_params.output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  packed_params.stride_height = params.stride_height;
+  packed_params.stride_width = params.stride_width;
+  packed_params.pad_height = data.padding.height;
+  packed_params.pad_width = data.padding.width;
+  packed_params.input_offset = -data.input_zero_point;
+  packed_params.output_offset = data.output_zero_point;
+  packed_params.output_activation_min = data.output_activation_min;
+  packed_params.output_activation_max = data.output_activation_max;
+  packed_params.output_multiplier = data.per_channel_output_multiplier;
+  packed_params.output_shift = data.per_channel_output_shift;
+
+  const int input_size = packed_params.input_height *
+                         packed_params.input_width * packed_params.input_depth;
+  const int output_size = packed_params.output_height *
+                          packed_params.output_width *
+                          packed_params.output_depth;
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  for (int b = 0; b < batches; ++b) {
+    PackedConvPerChannel(packed_params, input_data + b * input_size,
+                         tflite::micro::GetTensorData<int8_t>(filter),
+                         tflite::micro::GetTensorData<int32_t>(bias),
+                         output_data + b * output_size);
+  }
+}
+
 }  // namespace tflite
@@ -29,9 +29,23 @@ limitations under the License.
 namespace tflite {
 namespace {
 
+ConvFusedPadding* FusedPadding(void* user_data) {
+  return &static_cast<OpDataConv*>(user_data)->fused_padding;
+}
+
+const OperatorHooks kOperatorHooks = {FusedPadding,
+                                      /*accepts_fused_padding=*/nullptr,
+                                      /*packed_weights=*/nullptr};
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context, sizeof(OpDataConv));
+  OpDataConv* data = static_cast<OpDataConv*>(
+      context->AllocatePersistentBuffer(context, sizeof(OpDataConv)));
+  if (data != nullptr) {
+    data->fused_padding = {};
+    GetMicroContext(context)->SetOperatorHooks(&kOperatorHooks);
+  }
+  return data;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
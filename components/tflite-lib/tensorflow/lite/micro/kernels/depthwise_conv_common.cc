@@ -87,12 +87,18 @@ TfLiteStatus CalculateOpDataDepthwiseConv(
   TF_LITE_ENSURE(context, has_bias || node->inputs->size == 2);
   TF_LITE_ENSURE_EQ(context, node->outputs->size, 1);
 
-  // Matching GetWindowedOutputSize in TensorFlow.
+  // Matching GetWindowedOutputSize in TensorFlow, over the input as the fused
+  // PAD would have padded it. Its bottom and right rows need no padding
+  // values, the kernels skip the taps past the end of the input.
+  const ConvFusedPadding& fused = data->fused_padding;
   auto padding = params.padding;
   data->padding = ComputePaddingHeightWidth(
       params.stride_height, params.stride_width, params.dilation_height_factor,
-      params.dilation_width_factor, height, width, filter_height, filter_width,
-      padding, &out_height, &out_width);
+      params.dilation_width_factor, height + fused.top + fused.bottom,
+      width + fused.left + fused.right, filter_height, filter_width, padding,
+      &out_height, &out_width);
+  data->padding.height += fused.top;
+  data->padding.width += fused.left;
 
   MicroContext* micro_context = GetMicroContext(context);
 
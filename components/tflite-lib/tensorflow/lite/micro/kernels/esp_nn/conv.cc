@@ -46,9 +46,39 @@ struct NodeData {
 #endif
 };
 
+ConvFusedPadding* FusedPadding(void* user_data) {
+  return &static_cast<NodeData*>(user_data)->op_data.fused_padding;
+}
+
+bool* PackedWeights(void* user_data) {
+  return &static_cast<NodeData*>(user_data)->op_data.packed_weights;
+}
+
+#if ESP_NN
+// esp-nn takes a single padding per dimension, a larger bottom or right one
+// was never checked on the device.
+bool AcceptsFusedPadding(const TfLiteNode& node, const TfLiteEvalTensor& filter,
+                         const ConvFusedPadding& padding) {
+  return padding.bottom <= padding.top && padding.right <= padding.left;
+}
+
+const OperatorHooks kOperatorHooks = {FusedPadding, AcceptsFusedPadding,
+                                      PackedWeights};
+#else
+const OperatorHooks kOperatorHooks = {
+    FusedPadding, /*accepts_fused_padding=*/nullptr, PackedWeights};
+#endif
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context, sizeof(NodeData));
+  NodeData* data = static_cast<NodeData*>(
+      context->AllocatePersistentBuffer(context, sizeof(NodeData)));
+  if (data != nullptr) {
+    data->op_data.fused_padding = {};
+    data->op_data.packed_weights = false;
+    GetMicroContext(context)->SetOperatorHooks(&kOperatorHooks);
+  }
+  return data;
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
@@ -111,7 +141,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       filter_height, output_width, output_height, input->type, &data->op_data));
 
 #if ESP_NN
-  if (input->type == kTfLiteInt8) {
+  // The packed kernel needs no scratch.
+  if (input->type == kTfLiteInt8 && !data->op_data.packed_weights) {
     data_dims_t input_dims =  {
                                 .width = input_width, .height = input_height,
                                 .channels = input->dims->data[3], 1
@@ -153,6 +184,14 @@ inline void EvalQuantizedPerChannel(
     const NodeData& data, const TfLiteEvalTensor* input,
     const TfLiteEvalTensor* filter, const TfLiteEvalTensor* bias,
     TfLiteEvalTensor* output) {
+  // The packed weights cannot go through esp-nn, they run the portable
+  // kernels of packed_weights.cc instead, scalar on the device.
+  if (data.op_data.packed_weights) {
+    EvalPackedConvPerChannel(params, data.op_data, input, filter, bias,
+                             output);
+    return;
+  }
+
   const int dilation_width_factor = params.dilation_width_factor;
   const int dilation_height_factor = params.dilation_height_factor;
 
@@ -294,6 +333,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       EvalQuantizedPerChannel(context, node, params, data, input, filter,
                               bias, output);
 #else
+      if (data.op_data.packed_weights) {
+        EvalPackedConvPerChannel(params, data.op_data, input, filter, bias,
+                                 output);
+        break;
+      }
       reference_integer_ops::ConvPerChannel(
           ConvParamsQuantized(params, data.op_data),
           data.op_data.per_channel_output_multiplier,
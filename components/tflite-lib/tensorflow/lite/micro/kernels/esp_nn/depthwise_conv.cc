@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/depthwise_conv_specialized.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 
 #include "freertos/FreeRTOS.h"
@@ -43,12 +44,65 @@ struct NodeData {
   OpDataConv op_data;
 #if ESP_NN
   int buffer_idx;
+  // Kernel compiled for the shape of this layer, nullptr for esp-nn.
+  DepthwiseConvSpecializedFn specialized;
 #endif
 };
 
+ConvFusedPadding* FusedPadding(void* user_data) {
+  return &static_cast<NodeData*>(user_data)->op_data.fused_padding;
+}
+
+#if ESP_NN
+// The int8 kernel compiled for the filter and parameters of the layer, nullptr
+// to use esp-nn. Only with ESP_NN_DEPTHWISE_SPECIALIZED: the kernels
+// were only timed against the portable esp-nn of the host build, not against
+// the esp-nn S3 one.
+DepthwiseConvSpecializedFn SelectSpecialized(
+    const TfLiteDepthwiseConvParams& params, int filter_height,
+    int filter_width) {
+#if ESP_NN_DEPTHWISE_SPECIALIZED
+  if (params.dilation_width_factor != 1 || params.dilation_height_factor != 1) {
+    return nullptr;
+  }
+  return GetDepthwiseConvSpecialized(filter_height, filter_width,
+                                     params.stride_height, params.stride_width,
+                                     params.depth_multiplier);
+#else
+  return nullptr;
+#endif
+}
+
+// Same limit as AcceptsFusedPadding() in conv.cc, except for the specialized
+// kernels, which compute any padding like the reference one.
+bool AcceptsFusedPadding(const TfLiteNode& node, const TfLiteEvalTensor& filter,
+                         const ConvFusedPadding& padding) {
+  const TfLiteDepthwiseConvParams& params =
+      *(static_cast<const TfLiteDepthwiseConvParams*>(node.builtin_data));
+  if (SelectSpecialized(params, filter.dims->data[1], filter.dims->data[2]) !=
+      nullptr) {
+    return true;
+  }
+  return padding.bottom <= padding.top && padding.right <= padding.left;
+}
+
+const OperatorHooks kOperatorHooks = {FusedPadding, AcceptsFusedPadding,
+                                      /*packed_weights=*/nullptr};
+#else
+const OperatorHooks kOperatorHooks = {FusedPadding,
+                                      /*accepts_fused_padding=*/nullptr,
+                                      /*packed_weights=*/nullptr};
+#endif
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context, sizeof(NodeData));
+  NodeData* data = static_cast<NodeData*>(
+      context->AllocatePersistentBuffer(context, sizeof(NodeData)));
+  if (data != nullptr) {
+    data->op_data.fused_padding = {};
+    GetMicroContext(context)->SetOperatorHooks(&kOperatorHooks);
+  }
+  return data;
 }
 
 #if ESP_NN
@@ -113,6 +167,21 @@ inline void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
       scratch_buf = context->GetScratchBuffer(context, data.buffer_idx);
     }
 
+    if (data.specialized != nullptr) {
+      DepthwiseConvSpecializedParams specialized_params = {
+          input_height, input_width, input_depth, output_height, output_width,
+          pad_height, pad_width, input_offset, output_offset, activation_min,
+          activation_max, data.op_data.per_channel_output_multiplier,
+          data.op_data.per_channel_output_shift, scratch_buf};
+      for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+        data.specialized(specialized_params, input_data + i_batch * input_size,
+                         tflite::micro::GetTensorData<int8_t>(filter),
+                         tflite::micro::GetTensorData<int32_t>(bias),
+                         output_data + i_batch * output_size);
+      }
+      return;
+    }
+
     esp_nn_set_depthwise_conv_scratch_buf(scratch_buf);
 
     data_dims_t input_dims =  {
@@ -223,7 +292,16 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       filter_height, output_width, output_height, input->type, &data->op_data));
 
 #if ESP_NN
+  data->specialized = nullptr;
   if (input->type == kTfLiteInt8) {
+    data->specialized = SelectSpecialized(params, filter_height, filter_width);
+  }
+  if (data->specialized != nullptr) {
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context,
+        DepthwiseConvSpecializedScratchSize(input->dims->data[3]),
+        &data->buffer_idx));
+  } else if (input->type == kTfLiteInt8) {
     data_dims_t input_dims =  {
                                 .width = input_width, .height = input_height,
                                 .channels = input->dims->data[3], 1
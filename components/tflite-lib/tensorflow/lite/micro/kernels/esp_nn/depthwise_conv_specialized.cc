@@ -0,0 +1,164 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/esp_nn/depthwise_conv_specialized.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/lite/micro/kernels/requantize.h"
+
+namespace tflite {
+namespace {
+
+// Output channels computed at a time, sized for the accumulators to stay in
+// registers where the compiler vectorizes the block.
+constexpr int kChannelBlock = 16;
+
+// Computes output channels [channel, channel + kBlock) of one output. The taps
+// outside of the input read a row of input zero points, whose contribution is
+// zero, so every output goes through the same unrolled tap loop. With
+// |x + input_offset| <= 255 and |w| <= 128 each product fits in 16 bits, which
+// keeps the multiplies narrow where the block is vectorized.
+template <int kTaps, int kDepthMultiplier, int kBlock>
+inline void ConvBlock(const DepthwiseConvSpecializedParams& params,
+                      const int8_t* const* taps, const int8_t* filter_data,
+                      const int32_t* bias_data, int output_depth, int channel,
+                      int8_t* out) {
+  const int16_t input_offset = static_cast<int16_t>(params.input_offset);
+  const int8_t* filter = filter_data + channel;
+  int32_t acc[kBlock];
+  for (int i = 0; i < kBlock; ++i) {
+    acc[i] = bias_data ? bias_data[channel + i] : 0;
+  }
+  for (int i = 0; i < kBlock; ++i) {
+    const int input_channel = (channel + i) / kDepthMultiplier;
+    int32_t sum = acc[i];
+    for (int t = 0; t < kTaps; ++t) {
+      const int16_t input =
+          static_cast<int16_t>(taps[t][input_channel] + input_offset);
+      sum += static_cast<int16_t>(
+          input * static_cast<int16_t>(filter[t * output_depth + i]));
+    }
+    acc[i] = sum;
+  }
+  for (int i = 0; i < kBlock; ++i) {
+    int32_t value = RequantizeNonNegative(
+        acc[i], params.output_multiplier[channel + i],
+        params.output_shift[channel + i]);
+    value += params.output_offset;
+    value = std::max(value, params.output_activation_min);
+    value = std::min(value, params.output_activation_max);
+    out[channel + i] = static_cast<int8_t>(value);
+  }
+}
+
+template <int kFilterHeight, int kFilterWidth, int kStride,
+          int kDepthMultiplier>
+void DepthwiseConvSpecialized(const DepthwiseConvSpecializedParams& params,
+                              const int8_t* input_data,
+                              const int8_t* filter_data,
+                              const int32_t* bias_data, int8_t* output_data) {
+  constexpr int kTaps = kFilterHeight * kFilterWidth;
+  const int input_height = params.input_height;
+  const int input_width = params.input_width;
+  const int input_depth = params.input_depth;
+  const int output_depth = input_depth * kDepthMultiplier;
+  const int input_row_size = input_width * input_depth;
+
+  int8_t* zero_point_row = static_cast<int8_t*>(params.scratch);
+  memset(zero_point_row, static_cast<int8_t>(-params.input_offset),
+         input_depth);
+
+  for (int out_y = 0; out_y < params.output_height; ++out_y) {
+    const int in_y_origin = out_y * kStride - params.pad_height;
+    const int8_t* rows[kFilterHeight];
+    for (int fy = 0; fy < kFilterHeight; ++fy) {
+      const int in_y = in_y_origin + fy;
+      rows[fy] = (in_y >= 0 && in_y < input_height)
+                     ? input_data + in_y * input_row_size
+                     : nullptr;
+    }
+
+    for (int out_x = 0; out_x < params.output_width; ++out_x) {
+      const int in_x_origin = out_x * kStride - params.pad_width;
+      const int8_t* taps[kTaps];
+      for (int fy = 0; fy < kFilterHeight; ++fy) {
+        for (int fx = 0; fx < kFilterWidth; ++fx) {
+          const int in_x = in_x_origin + fx;
+          taps[fy * kFilterWidth + fx] =
+              (rows[fy] != nullptr && in_x >= 0 && in_x < input_width)
+                  ? rows[fy] + in_x * input_depth
+                  : zero_point_row;
+        }
+      }
+
+      int8_t* out =
+          output_data + (out_y * params.output_width + out_x) * output_depth;
+      int channel = 0;
+      for (; channel + kChannelBlock <= output_depth;
+           channel += kChannelBlock) {
+        ConvBlock<kTaps, kDepthMultiplier, kChannelBlock>(
+            params, taps, filter_data, bias_data, output_depth, channel, out);
+      }
+      for (; channel < output_depth; ++channel) {
+        ConvBlock<kTaps, kDepthMultiplier, 1>(
+            params, taps, filter_data, bias_data, output_depth, channel, out);
+      }
+    }
+  }
+}
+
+struct SpecializedKernel {
+  int filter_height;
+  int filter_width;
+  int stride;
+  int depth_multiplier;
+  DepthwiseConvSpecializedFn kernel;
+};
+
+// The depthwise layers of MobileNet-like keyword models.
+const SpecializedKernel kSpecializedKernels[] = {
+    {3, 3, 1, 1, DepthwiseConvSpecialized<3, 3, 1, 1>},
+    {3, 3, 2, 1, DepthwiseConvSpecialized<3, 3, 2, 1>},
+    {3, 3, 1, 2, DepthwiseConvSpecialized<3, 3, 1, 2>},
+    {3, 3, 2, 2, DepthwiseConvSpecialized<3, 3, 2, 2>},
+};
+
+}  // namespace
+
+DepthwiseConvSpecializedFn GetDepthwiseConvSpecialized(int filter_height,
+                                                       int filter_width,
+                                                       int stride_height,
+                                                       int stride_width,
+                                                       int depth_multiplier) {
+  if (stride_height != stride_width) {
+    return nullptr;
+  }
+  for (const SpecializedKernel& specialized : kSpecializedKernels) {
+    if (specialized.filter_height == filter_height &&
+        specialized.filter_width == filter_width &&
+        specialized.stride == stride_height &&
+        specialized.depth_multiplier == depth_multiplier) {
+      return specialized.kernel;
+    }
+  }
+  return nullptr;
+}
+
+int DepthwiseConvSpecializedScratchSize(int input_depth) {
+  // A row of input zero points.
+  return input_depth;
+}
+
+}  // namespace tflite
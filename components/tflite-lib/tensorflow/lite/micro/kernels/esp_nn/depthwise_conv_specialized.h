@@ -0,0 +1,59 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_DEPTHWISE_CONV_SPECIALIZED_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_DEPTHWISE_CONV_SPECIALIZED_H_
+
+#include <cstdint>
+
+namespace tflite {
+
+// One batch of an int8 NHWC depthwise convolution with per channel
+// quantization and no dilation. Filter size, stride and depth multiplier are
+// those of the kernel GetDepthwiseConvSpecialized() returned.
+struct DepthwiseConvSpecializedParams {
+  int input_height;
+  int input_width;
+  int input_depth;
+  int output_height;
+  int output_width;
+  int pad_height;
+  int pad_width;
+  int32_t input_offset;
+  int32_t output_offset;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+  const int32_t* output_multiplier;
+  const int32_t* output_shift;
+  // DepthwiseConvSpecializedScratchSize() bytes.
+  void* scratch;
+};
+
+typedef void (*DepthwiseConvSpecializedFn)(
+    const DepthwiseConvSpecializedParams& params, const int8_t* input_data,
+    const int8_t* filter_data, const int32_t* bias_data, int8_t* output_data);
+
+// Returns the kernel compiled for this filter size, stride and depth
+// multiplier, nullptr if there is none. Bit-exact with
+// reference_integer_ops::DepthwiseConvPerChannel.
+DepthwiseConvSpecializedFn GetDepthwiseConvSpecialized(int filter_height,
+                                                       int filter_width,
+                                                       int stride_height,
+                                                       int stride_width,
+                                                       int depth_multiplier);
+
+int DepthwiseConvSpecializedScratchSize(int input_depth);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_DEPTHWISE_CONV_SPECIALIZED_H_
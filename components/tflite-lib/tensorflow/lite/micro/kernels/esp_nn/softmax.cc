@@ -187,6 +187,7 @@ static TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     const int32_t input_height = input->dims->data[2];
     int scratch_buf_size = esp_nn_get_softmax_scratch_size(input_width,
                                                            input_height);
+    data->buffer_idx = -1;
     if (scratch_buf_size > 0) {
       TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
         context, scratch_buf_size, &data->buffer_idx));
@@ -28,10 +28,24 @@ limitations under the License.
 namespace tflite {
 namespace {
 
+bool* PackedWeights(void* user_data) {
+  return &static_cast<OpDataFullyConnected*>(user_data)->packed_weights;
+}
+
+const OperatorHooks kOperatorHooks = {/*fused_padding=*/nullptr,
+                                      /*accepts_fused_padding=*/nullptr,
+                                      PackedWeights};
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context,
-                                           sizeof(OpDataFullyConnected));
+  auto* data = static_cast<OpDataFullyConnected*>(
+      context->AllocatePersistentBuffer(context,
+                                        sizeof(OpDataFullyConnected)));
+  if (data != nullptr) {
+    data->packed_weights = false;
+    GetMicroContext(context)->SetOperatorHooks(&kOperatorHooks);
+  }
+  return data;
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
@@ -107,6 +121,10 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     }
 
     case kTfLiteInt8: {
+      if (data.packed_weights) {
+        EvalPackedFullyConnected(data, input, filter, bias, output);
+        break;
+      }
       const int32_t* bias_data =
           nullptr != bias ? tflite::micro::GetTensorData<int32_t>(bias)
                           : nullptr;
@@ -38,6 +38,10 @@ struct OpDataFullyConnected {
   int32_t input_zero_point;
   int32_t filter_zero_point;
   int32_t output_zero_point;
+  // Set by MicroInterpreter::AllocateTensors() when the model lists the
+  // operator in its kPackedWeightsMetadata: the filter and bias are in the
+  // layout of packed_weights.h.
+  bool packed_weights;
 };
 
 extern const int kFullyConnectedInputTensor;
@@ -60,6 +64,13 @@ TfLiteStatus CalculateOpDataFullyConnected(
     TfLiteType data_type, const TfLiteTensor* input, const TfLiteTensor* filter,
     const TfLiteTensor* bias, TfLiteTensor* output, OpDataFullyConnected* data);
 
+// Int8 fully connected of an operator whose data.packed_weights is set.
+void EvalPackedFullyConnected(const OpDataFullyConnected& data,
+                              const TfLiteEvalTensor* input,
+                              const TfLiteEvalTensor* filter,
+                              const TfLiteEvalTensor* bias,
+                              TfLiteEvalTensor* output);
+
 // This is the most generic TfLiteRegistration. The actual supported types may
 // still be target dependent. The only requirement is that every implementation
 // (reference or optimized) must define this function.
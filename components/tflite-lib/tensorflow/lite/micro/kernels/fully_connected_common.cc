@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/fully_connected.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
 
 namespace tflite {
 
@@ -57,6 +58,14 @@ TfLiteStatus CalculateOpDataFullyConnected(
     TfLiteType data_type, const TfLiteTensor* input, const TfLiteTensor* filter,
     const TfLiteTensor* bias, TfLiteTensor* output,
     OpDataFullyConnected* data) {
+  // The packed kernel folds the input offset into the bias and needs
+  // symmetric filters.
+  if (data->packed_weights) {
+    TF_LITE_ENSURE_EQ(context, data_type, kTfLiteInt8);
+    TF_LITE_ENSURE(context, bias != nullptr);
+    TF_LITE_ENSURE_EQ(context, filter->params.zero_point, 0);
+  }
+
   if (data_type != kTfLiteFloat32) {
     double real_multiplier = 0.0;
     TF_LITE_ENSURE_STATUS(GetQuantizedConvolutionMultipler(
@@ -80,4 +89,36 @@ TfLiteStatus CalculateOpDataFullyConnected(
   return kTfLiteOk;
 }
 
+void EvalPackedFullyConnected(const OpDataFullyConnected& data,
+                              const TfLiteEvalTensor* input,
+                              const TfLiteEvalTensor* filter,
+                              const TfLiteEvalTensor* bias,
+                              TfLiteEvalTensor* output) {
+  const RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+  const RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int output_dim_count = output_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+
+  PackedFullyConnectedParams packed_params;
+  packed_params.accum_depth = filter_shape.Dims(filter_dim_count - 1);
+  packed_params.output_depth = MatchingDim(
+      filter_shape, filter_dim_count - 2, output_shape, output_dim_count - 1);
+  packed_params.output_offset = data.output_zero_point;
+  packed_params.output_multiplier = data.output_multiplier;
+  packed_params.output_shift = data.output_shift;
+  packed_params.output_activation_min = data.output_activation_min;
+  packed_params.output_activation_max = data.output_activation_max;
+
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  for (int b = 0; b < batches; ++b) {
+    PackedFullyConnected(packed_params,
+                         input_data + b * packed_params.accum_depth,
+                         tflite::micro::GetTensorData<int8_t>(filter),
+                         tflite::micro::GetTensorData<int32_t>(bias),
+                         output_data + b * packed_params.output_depth);
+  }
+}
+
 }  // namespace tflite
@@ -0,0 +1,306 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "tensorflow/lite/micro/kernels/requantize.h"
+
+namespace tflite {
+namespace {
+
+// Quantization of the outputs, per channel or of the whole tensor.
+struct OutputStage {
+  const int32_t* multiplier;
+  const int32_t* shift;
+  int32_t offset;
+  int32_t activation_min;
+  int32_t activation_max;
+};
+
+// acc[i] += x[d] * filter[d][i] over `depth` rows of a block, the input
+// read every `x_step` values so the taps in the padding can pass a single
+// value. Both products of a pair of rows fit in 16 bits and their sum in 32,
+// the pmaddwd of SSE2 and the dual multiply-accumulates of DSP extensions.
+template <int kBlock>
+inline void Accumulate(const int8_t* x, int x_step, int depth,
+                       const int8_t* filter, int32_t* acc) {
+  int d = 0;
+#if defined(__SSE2__)
+  if (kBlock % 4 == 0) {
+    __m128i sums[kBlock / 4 > 0 ? kBlock / 4 : 1];
+    for (int j = 0; j < kBlock / 4; ++j) {
+      sums[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + 4 * j));
+    }
+    for (; d + 2 <= depth; d += 2) {
+      const __m128i pair = _mm_set1_epi32(static_cast<int32_t>(
+          static_cast<uint16_t>(x[d * x_step]) |
+          (static_cast<uint32_t>(static_cast<uint16_t>(x[(d + 1) * x_step]))
+           << 16)));
+      const int8_t* pairs = filter + d * kBlock;
+      if (kBlock == 4) {
+        const __m128i w =
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pairs));
+        // Sign extends the bytes to 16 bits.
+        const __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+        sums[0] = _mm_add_epi32(sums[0], _mm_madd_epi16(lo, pair));
+      }
+      for (int j = 0; j + 2 <= kBlock / 4; j += 2) {
+        const __m128i w =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(pairs + 8 * j));
+        const __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+        const __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+        sums[j] = _mm_add_epi32(sums[j], _mm_madd_epi16(lo, pair));
+        sums[j + 1] = _mm_add_epi32(sums[j + 1], _mm_madd_epi16(hi, pair));
+      }
+    }
+    if (d < depth && kBlock >= 8) {
+      // The odd last row, against (w, 0) pairs.
+      const __m128i pair = _mm_set1_epi32(
+          static_cast<int32_t>(static_cast<uint16_t>(x[d * x_step])));
+      const __m128i zero = _mm_setzero_si128();
+      for (int j = 0; j + 2 <= kBlock / 4; j += 2) {
+        const __m128i w = _mm_loadl_epi64(
+            reinterpret_cast<const __m128i*>(filter + d * kBlock + 4 * j));
+        const __m128i w16 = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+        sums[j] = _mm_add_epi32(
+            sums[j], _mm_madd_epi16(_mm_unpacklo_epi16(w16, zero), pair));
+        sums[j + 1] = _mm_add_epi32(
+            sums[j + 1], _mm_madd_epi16(_mm_unpackhi_epi16(w16, zero), pair));
+      }
+      d = depth;
+    }
+    for (int j = 0; j < kBlock / 4; ++j) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 4 * j), sums[j]);
+    }
+  }
+#endif
+  for (; d + 2 <= depth; d += 2) {
+    const int16_t x0 = x[d * x_step];
+    const int16_t x1 = x[(d + 1) * x_step];
+    const int8_t* pairs = filter + d * kBlock;
+    for (int i = 0; i < kBlock; ++i) {
+      acc[i] += static_cast<int16_t>(x0 * pairs[2 * i]) +
+                static_cast<int16_t>(x1 * pairs[2 * i + 1]);
+    }
+  }
+  if (d < depth) {
+    const int16_t x0 = x[d * x_step];
+    const int8_t* row = filter + d * kBlock;
+    for (int i = 0; i < kBlock; ++i) {
+      acc[i] += static_cast<int16_t>(x0 * row[i]);
+    }
+  }
+}
+
+template <int kBlock, bool kPerChannel>
+inline void Store(const int32_t* acc, const OutputStage& stage, int channel,
+                  int8_t* out) {
+  for (int i = 0; i < kBlock; ++i) {
+    const int index = kPerChannel ? channel + i : 0;
+    int32_t value =
+        RequantizeNonNegative(acc[i], stage.multiplier[index],
+                              static_cast<int>(stage.shift[index]));
+    value += stage.offset;
+    value = std::max(value, stage.activation_min);
+    value = std::min(value, stage.activation_max);
+    out[channel + i] = static_cast<int8_t>(value);
+  }
+}
+
+// Output channels [channel, channel + kBlock) of one convolution output. The
+// taps in the padding read the input zero point, -input_offset, as the folded
+// bias counts input_offset times every weight.
+template <int kBlock>
+void ConvBlock(const PackedConvParams& params, const OutputStage& stage,
+               const int8_t* input_data, int in_y_origin, int in_x_origin,
+               const int8_t* filter, const int32_t* bias_data, int channel,
+               int8_t* out) {
+  const int depth = params.input_depth;
+  const int8_t pad_value = static_cast<int8_t>(-params.input_offset);
+  int32_t acc[kBlock];
+  for (int i = 0; i < kBlock; ++i) {
+    acc[i] = bias_data[channel + i];
+  }
+  for (int fy = 0; fy < params.filter_height; ++fy) {
+    const int in_y = in_y_origin + fy;
+    for (int fx = 0; fx < params.filter_width; ++fx) {
+      const int in_x = in_x_origin + fx;
+      const int8_t* tap_filter =
+          filter + (fy * params.filter_width + fx) * depth * kBlock;
+      if (in_y >= 0 && in_y < params.input_height && in_x >= 0 &&
+          in_x < params.input_width) {
+        Accumulate<kBlock>(
+            input_data + (in_y * params.input_width + in_x) * depth, 1, depth,
+            tap_filter, acc);
+      } else {
+        Accumulate<kBlock>(&pad_value, 0, depth, tap_filter, acc);
+      }
+    }
+  }
+  Store<kBlock, true>(acc, stage, channel, out);
+}
+
+template <int kBlock>
+void FullyConnectedBlock(const OutputStage& stage, const int8_t* input_data,
+                         int accum_depth, const int8_t* filter,
+                         const int32_t* bias_data, int channel, int8_t* out) {
+  int32_t acc[kBlock];
+  for (int i = 0; i < kBlock; ++i) {
+    acc[i] = bias_data[channel + i];
+  }
+  Accumulate<kBlock>(input_data, 1, accum_depth, filter, acc);
+  Store<kBlock, false>(acc, stage, channel, out);
+}
+
+}  // namespace
+
+void PackWeightsFilter(const int8_t* filter, int output_depth, int taps,
+                       int tap_depth, int8_t* packed) {
+  const int depth = taps * tap_depth;
+  for (int channel = 0; channel < output_depth;) {
+    const int width = PackedWeightsBlockWidth(output_depth, channel);
+    for (int tap = 0; tap < taps; ++tap) {
+      const int8_t* rows = filter + channel * depth + tap * tap_depth;
+      int d = 0;
+      for (; d + 2 <= tap_depth; d += 2) {
+        for (int i = 0; i < width; ++i) {
+          *packed++ = rows[i * depth + d];
+          *packed++ = rows[i * depth + d + 1];
+        }
+      }
+      if (d < tap_depth) {
+        for (int i = 0; i < width; ++i) {
+          *packed++ = rows[i * depth + d];
+        }
+      }
+    }
+    channel += width;
+  }
+}
+
+bool PackWeightsBias(const int8_t* filter, const int32_t* bias,
+                     int output_depth, int depth, int32_t input_offset,
+                     int32_t* packed_bias) {
+  for (int channel = 0; channel < output_depth; ++channel) {
+    int64_t sum = 0;
+    for (int d = 0; d < depth; ++d) {
+      sum += filter[channel * depth + d];
+    }
+    const int64_t value =
+        (bias != nullptr ? bias[channel] : 0) + sum * input_offset;
+    if (value < std::numeric_limits<int32_t>::min() ||
+        value > std::numeric_limits<int32_t>::max()) {
+      return false;
+    }
+    packed_bias[channel] = static_cast<int32_t>(value);
+  }
+  return true;
+}
+
+void PackedConvPerChannel(const PackedConvParams& params,
+                          const int8_t* input_data, const int8_t* filter_data,
+                          const int32_t* bias_data, int8_t* output_data) {
+  const OutputStage stage = {params.output_multiplier, params.output_shift,
+                             params.output_offset,
+                             params.output_activation_min,
+                             params.output_activation_max};
+  const int depth =
+      params.filter_height * params.filter_width * params.input_depth;
+
+  for (int out_y = 0; out_y < params.output_height; ++out_y) {
+    const int in_y_origin = out_y * params.stride_height - params.pad_height;
+    for (int out_x = 0; out_x < params.output_width; ++out_x) {
+      const int in_x_origin = out_x * params.stride_width - params.pad_width;
+      int8_t* out = output_data + (out_y * params.output_width + out_x) *
+                                      params.output_depth;
+      const int8_t* filter = filter_data;
+      for (int channel = 0; channel < params.output_depth;) {
+        const int width =
+            PackedWeightsBlockWidth(params.output_depth, channel);
+        switch (width) {
+          case 16:
+            ConvBlock<16>(params, stage, input_data, in_y_origin, in_x_origin,
+                          filter, bias_data, channel, out);
+            break;
+          case 8:
+            ConvBlock<8>(params, stage, input_data, in_y_origin, in_x_origin,
+                         filter, bias_data, channel, out);
+            break;
+          case 4:
+            ConvBlock<4>(params, stage, input_data, in_y_origin, in_x_origin,
+                         filter, bias_data, channel, out);
+            break;
+          case 2:
+            ConvBlock<2>(params, stage, input_data, in_y_origin, in_x_origin,
+                         filter, bias_data, channel, out);
+            break;
+          default:
+            ConvBlock<1>(params, stage, input_data, in_y_origin, in_x_origin,
+                         filter, bias_data, channel, out);
+            break;
+        }
+        filter += width * depth;
+        channel += width;
+      }
+    }
+  }
+}
+
+void PackedFullyConnected(const PackedFullyConnectedParams& params,
+                          const int8_t* input_data, const int8_t* filter_data,
+                          const int32_t* bias_data, int8_t* output_data) {
+  const int32_t multiplier = params.output_multiplier;
+  const int32_t shift = params.output_shift;
+  const OutputStage stage = {&multiplier, &shift, params.output_offset,
+                             params.output_activation_min,
+                             params.output_activation_max};
+  const int depth = params.accum_depth;
+
+  const int8_t* filter = filter_data;
+  for (int channel = 0; channel < params.output_depth;) {
+    const int width = PackedWeightsBlockWidth(params.output_depth, channel);
+    switch (width) {
+      case 16:
+        FullyConnectedBlock<16>(stage, input_data, depth, filter, bias_data,
+                                channel, output_data);
+        break;
+      case 8:
+        FullyConnectedBlock<8>(stage, input_data, depth, filter, bias_data,
+                               channel, output_data);
+        break;
+      case 4:
+        FullyConnectedBlock<4>(stage, input_data, depth, filter, bias_data,
+                               channel, output_data);
+        break;
+      case 2:
+        FullyConnectedBlock<2>(stage, input_data, depth, filter, bias_data,
+                               channel, output_data);
+        break;
+      default:
+        FullyConnectedBlock<1>(stage, input_data, depth, filter, bias_data,
+                               channel, output_data);
+        break;
+    }
+    filter += width * depth;
+    channel += width;
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,106 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_PACKED_WEIGHTS_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_PACKED_WEIGHTS_H_
+
+#include <cstdint>
+
+namespace tflite {
+
+// Int8 CONV_2D and FULLY_CONNECTED weights re-laid offline for the kernels
+// below. The filter keeps its tensor shape, but its output channels are split
+// in blocks of kPackedWeightsChannelBlock, the remainder in blocks of 8, 4, 2
+// and 1. A block of width w holds the taps of the filter one after the other,
+// each [tap_depth / 2][w][2]: the weights of every channel for two
+// consecutive input channels, then an odd last input channel as [w]. Each
+// pair of input values thus meets 2 * w consecutive weights. The bias holds
+// bias + input_offset * sum(filter) of each output channel, which only leaves
+// the plain products of the input and the filter to the kernels.
+
+// Name of the model metadata listing the packed operators. Its buffer is an
+// int32 array: kPackedWeightsVersion, kPackedWeightsChannelBlock, the number
+// of operators, then the subgraph and operator index of each one.
+constexpr char kPackedWeightsMetadata[] = "PackedWeights";
+constexpr int kPackedWeightsVersion = 1;
+constexpr int kPackedWeightsChannelBlock = 16;
+
+// Width of the block starting at `channel`, blocks are laid from channel 0.
+inline int PackedWeightsBlockWidth(int output_depth, int channel) {
+  int width = kPackedWeightsChannelBlock;
+  while (width > output_depth - channel) {
+    width /= 2;
+  }
+  return width;
+}
+
+// Packs an [output_depth][taps][tap_depth] filter, the filter height times
+// width and the input depth of a CONV_2D, 1 and the accumulation depth of a
+// FULLY_CONNECTED. `packed` has the same size.
+void PackWeightsFilter(const int8_t* filter, int output_depth, int taps,
+                       int tap_depth, int8_t* packed);
+
+// The folded bias of PackWeightsFilter(), depth being taps * tap_depth.
+// `bias` can be nullptr. Returns false
+// if a value does not fit in int32.
+bool PackWeightsBias(const int8_t* filter, const int32_t* bias,
+                     int output_depth, int depth, int32_t input_offset,
+                     int32_t* packed_bias);
+
+// One batch of an int8 NHWC convolution with per channel quantization and no
+// dilation. Bit-exact with reference_integer_ops::ConvPerChannel over the
+// unpacked weights.
+struct PackedConvParams {
+  int input_height;
+  int input_width;
+  int input_depth;
+  int filter_height;
+  int filter_width;
+  int output_height;
+  int output_width;
+  int output_depth;
+  int stride_height;
+  int stride_width;
+  int pad_height;
+  int pad_width;
+  int32_t input_offset;
+  int32_t output_offset;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+  const int32_t* output_multiplier;
+  const int32_t* output_shift;
+};
+
+void PackedConvPerChannel(const PackedConvParams& params,
+                          const int8_t* input_data, const int8_t* filter_data,
+                          const int32_t* bias_data, int8_t* output_data);
+
+// One batch of an int8 FULLY_CONNECTED. Bit-exact with
+// reference_integer_ops::FullyConnected over the unpacked weights.
+struct PackedFullyConnectedParams {
+  int accum_depth;
+  int output_depth;
+  int32_t output_offset;
+  int32_t output_multiplier;
+  int output_shift;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+};
+
+void PackedFullyConnected(const PackedFullyConnectedParams& params,
+                          const int8_t* input_data, const int8_t* filter_data,
+                          const int32_t* bias_data, int8_t* output_data);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_PACKED_WEIGHTS_H_
@@ -39,6 +39,41 @@ struct OpDataReduce {
   int num_output_elements;
 };
 
+// How MeanInt8OverHeightWidth() turns the sum of each channel into its
+// output, one per reference path of EvalMeanHelper().
+enum class MeanOutputStage {
+  // reference_ops::Mean(): sum / count, as input and output share their
+  // quantization.
+  kSameQuantization,
+  // reference_integer_ops::Mean(): the multiplier of PrepareMeanOrSumHelper(),
+  // with keep_dims.
+  kMultiplier,
+  // reference_ops::QuantizedMeanOrSum(): the mean scaled in float.
+  kFloat,
+};
+
+struct MeanInt8Params {
+  int batches;
+  int height;
+  int width;
+  int depth;
+  MeanOutputStage stage;
+  int32_t input_zero_point;
+  int32_t output_zero_point;
+  int32_t multiplier;
+  int shift;
+  float input_scale;
+  float output_scale;
+};
+
+// Int8 MEAN of an NHWC tensor over its height and width. Sums every channel
+// in int32 over the rows of the input, then requantizes each channel as the
+// reference path of `stage` does, with the same results. `sums` holds depth
+// values.
+void MeanInt8OverHeightWidth(const MeanInt8Params& params,
+                             const int8_t* input_data, int32_t* sums,
+                             int8_t* output_data);
+
 TfLiteStatus PrepareMaxHelper(TfLiteContext* context, TfLiteNode* node,
                               OpDataReduce* op_data);
 
@@ -13,8 +13,14 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/cppmath.h"
+#include "tensorflow/lite/kernels/internal/max.h"
+#include "tensorflow/lite/kernels/internal/min.h"
 #include "tensorflow/lite/kernels/internal/quantization_util.h"
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/mean.h"
 #include "tensorflow/lite/kernels/internal/reference/reduce.h"
@@ -132,6 +138,58 @@ void ResolveAxis(const int* axis_data, int axis_count,
   op_params->axis_count = axis_count;
 }
 
+void MeanInt8OverHeightWidth(const MeanInt8Params& params,
+                             const int8_t* input_data, int32_t* sums,
+                             int8_t* output_data) {
+  const int depth = params.depth;
+  const int num_elements = params.height * params.width;
+  const float scale = params.input_scale / params.output_scale;
+  const float bias = -params.input_zero_point * scale;
+  for (int batch = 0; batch < params.batches; ++batch) {
+    for (int channel = 0; channel < depth; ++channel) {
+      sums[channel] = 0;
+    }
+    const int8_t* row = input_data + batch * num_elements * depth;
+    for (int i = 0; i < num_elements; ++i, row += depth) {
+      for (int channel = 0; channel < depth; ++channel) {
+        sums[channel] += row[channel];
+      }
+    }
+
+    int8_t* out = output_data + batch * depth;
+    switch (params.stage) {
+      case MeanOutputStage::kSameQuantization:
+        for (int channel = 0; channel < depth; ++channel) {
+          out[channel] = static_cast<int8_t>(sums[channel] / num_elements);
+        }
+        break;
+      case MeanOutputStage::kMultiplier:
+        for (int channel = 0; channel < depth; ++channel) {
+          int32_t acc = MultiplyByQuantizedMultiplier(
+              sums[channel] - num_elements * params.input_zero_point,
+              params.multiplier, params.shift);
+          acc = acc > 0 ? (acc + num_elements / 2) / num_elements
+                        : (acc - num_elements / 2) / num_elements;
+          acc += params.output_zero_point;
+          acc = std::min(std::max(acc, int32_t{-128}), int32_t{127});
+          out[channel] = static_cast<int8_t>(acc);
+        }
+        break;
+      case MeanOutputStage::kFloat:
+        for (int channel = 0; channel < depth; ++channel) {
+          const float float_mean = static_cast<float>(sums[channel]) /
+                                   static_cast<float>(num_elements);
+          float result = TfLiteMin(
+              TfLiteRound(float_mean * scale + bias) + params.output_zero_point,
+              127.0f);
+          result = TfLiteMax(result, -128.0f);
+          out[channel] = static_cast<int8_t>(result);
+        }
+        break;
+    }
+  }
+}
+
 TfLiteStatus EvalMeanHelper(TfLiteContext* context, TfLiteNode* node,
                             OpDataReduce* op_data) {
   const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
@@ -174,8 +232,35 @@ TfLiteStatus EvalMeanHelper(TfLiteContext* context, TfLiteNode* node,
       }
     } break;
     case kTfLiteInt8: {
-      // Defer to specialized implementation for 4D Mean across axes 1 & 2.
-      if (params->keep_dims && special_case_4d_axes_1_and_2) {
+      // 4D Mean across axes 1 & 2, with or without keep_dims, sums the input
+      // rows in int32 and then requantizes as the paths below would.
+      if (special_case_4d_axes_1_and_2 && input->dims->data[1] > 0 &&
+          input->dims->data[2] > 0) {
+        MeanInt8Params mean_params;
+        mean_params.batches = input->dims->data[0];
+        mean_params.height = input->dims->data[1];
+        mean_params.width = input->dims->data[2];
+        mean_params.depth = input->dims->data[3];
+        if (params->keep_dims) {
+          mean_params.stage = MeanOutputStage::kMultiplier;
+        } else if (op_data->input_zp == op_data->output_zp &&
+                   op_data->input_scale == op_data->output_scale) {
+          mean_params.stage = MeanOutputStage::kSameQuantization;
+        } else {
+          mean_params.stage = MeanOutputStage::kFloat;
+        }
+        mean_params.input_zero_point = op_data->input_zp;
+        mean_params.output_zero_point = op_data->output_zp;
+        mean_params.multiplier = op_data->multiplier;
+        mean_params.shift = op_data->shift;
+        mean_params.input_scale = op_data->input_scale;
+        mean_params.output_scale = op_data->output_scale;
+        MeanInt8OverHeightWidth(
+            mean_params, tflite::micro::GetTensorData<int8_t>(input),
+            static_cast<int32_t*>(
+                context->GetScratchBuffer(context, op_data->temp_buffer_idx)),
+            tflite::micro::GetTensorData<int8_t>(output));
+      } else if (params->keep_dims && special_case_4d_axes_1_and_2) {
         reference_integer_ops::Mean(
             op_params, op_data->multiplier, op_data->shift,
             tflite::micro::GetTensorShape(input),
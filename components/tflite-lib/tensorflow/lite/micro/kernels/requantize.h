@@ -0,0 +1,49 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_REQUANTIZE_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_REQUANTIZE_H_
+
+#include <cstdint>
+
+namespace tflite {
+
+// MultiplyByQuantizedMultiplier() for the non-negative multipliers that
+// QuantizeMultiplier() gives, on the magnitude of x so the 64 bit product is
+// unsigned. Gives the same bits: the doubling high multiply rounds positive
+// ties away from zero but negative ones toward zero, so the rounding nudge of
+// a negative x is one less.
+inline int32_t RequantizeNonNegative(int32_t x, int32_t multiplier,
+                                     int shift) {
+  const int left_shift = shift > 0 ? shift : 0;
+  const int right_shift = shift > 0 ? 0 : -shift;
+  x = static_cast<int32_t>(static_cast<uint32_t>(x) << left_shift);
+  const uint32_t negative = x < 0 ? 1 : 0;
+  const uint32_t magnitude =
+      negative ? 0u - static_cast<uint32_t>(x) : static_cast<uint32_t>(x);
+  const uint64_t product =
+      static_cast<uint64_t>(magnitude) * static_cast<uint32_t>(multiplier);
+  const uint32_t high =
+      static_cast<uint32_t>((product + (1u << 30) - negative) >> 31);
+  const int32_t scaled =
+      negative ? -static_cast<int32_t>(high) : static_cast<int32_t>(high);
+  // RoundingDivideByPOT().
+  const int32_t mask = static_cast<int32_t>((int64_t{1} << right_shift) - 1);
+  const int32_t remainder = scaled & mask;
+  const int32_t threshold = (mask >> 1) + (scaled < 0 ? 1 : 0);
+  return (scaled >> right_shift) + (remainder > threshold ? 1 : 0);
+}
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_REQUANTIZE_H_
@@ -246,10 +246,13 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
     // Each operator has a new allocation scope.
     allocation_scope_count_++;
     const auto* op = subgraph->operators()->Get(i);
+    // The node tensors rather than the flatbuffer ones, as operators fused by
+    // MicroInterpreter::AllocateTensors() read and write different tensors.
+    const TfLiteNode& node =
+        allocations[subgraph_idx].node_and_registrations[i].node;
     // Figure out when the first creation and use of each tensor is.
-    for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
-         ++n) {
-      const int tensor_index = op->outputs()->Get(n);
+    for (int n = 0; n < node.outputs->size; ++n) {
+      const int tensor_index = node.outputs->data[n];
       AllocationInfo* current = &subgraph_allocation_info[tensor_index];
       UpdateFirstCreated(current, allocation_scope_count_);
     }
@@ -264,9 +267,8 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
                                      scratch_buffer_handles, allocations);
 
     // Figure out when the last use of each tensor is.
-    for (size_t n = 0; op->inputs() != nullptr && n < op->inputs()->size();
-         ++n) {
-      const int tensor_index = op->inputs()->Get(n);
+    for (int n = 0; n < node.inputs->size; ++n) {
+      const int tensor_index = node.inputs->data[n];
       // Optional bias tensors can have an index of -1 when they are omitted.
       if (tensor_index >= 0) {
         AllocationInfo* current = &subgraph_allocation_info[tensor_index];
@@ -276,9 +278,8 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
         UpdateLastUsed(current, allocation_scope_count_);
       }
     }
-    for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
-         ++n) {
-      const int tensor_index = op->outputs()->Get(n);
+    for (int n = 0; n < node.outputs->size; ++n) {
+      const int tensor_index = node.outputs->data[n];
       AllocationInfo* current = &subgraph_allocation_info[tensor_index];
       UpdateLastUsed(current, allocation_scope_count_);
     }
@@ -313,6 +314,14 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
     AllocationInfo* current = &subgraph_allocation_info[tensor_index];
     UpdateLastUsed(current, allocation_scope_count_);
   }
+
+  // Tensors no operator writes any more, e.g. the output of a fused PAD.
+  for (size_t i = 0; i < subgraph->tensors()->size(); ++i) {
+    AllocationInfo* current = &subgraph_allocation_info[i];
+    if (current->first_created == kUninitializedLifetime) {
+      current->needs_allocating = false;
+    }
+  }
   return kTfLiteOk;
 }
 
@@ -67,9 +67,33 @@ typedef struct {
 
 }  // namespace internal
 
+struct ConvFusedPadding;
+
+// Lets the graph rewrites of MicroInterpreter::AllocateTensors() reach into
+// the operator data of a kernel, which registers them from its Init through
+// MicroContext::SetOperatorHooks(). An operator without hooks is never
+// rewritten.
+struct OperatorHooks {
+  // Returns the ConvFusedPadding in user_data that receives the padding of a
+  // PAD fused into the input, see MicroInterpreter::FusePadOperators(). Null
+  // to opt out.
+  ConvFusedPadding* (*fused_padding)(void* user_data);
+  // Whether the kernel computes this padding for the node and its filter,
+  // before Prepare. Null if it computes any padding.
+  bool (*accepts_fused_padding)(const TfLiteNode& node,
+                                const TfLiteEvalTensor& filter,
+                                const ConvFusedPadding& padding);
+  // Returns the flag in user_data that tells the kernel its weights were
+  // packed offline, see MicroInterpreter::MarkPackedWeights(). Null for a
+  // kernel without a packed path.
+  bool* (*packed_weights)(void* user_data);
+};
+
 typedef struct {
   TfLiteNode node;
   const TfLiteRegistration* registration;
+  // Registered by the kernel Init, null otherwise.
+  const OperatorHooks* hooks;
 } NodeAndRegistration;
 
 // Holds a pointer to a buffer for a scratch buffer requested by a kernel during
@@ -118,6 +118,10 @@ TfLiteStatus MicroContext::set_external_context(
   return kTfLiteOk;
 }
 
+void MicroContext::SetOperatorHooks(const OperatorHooks* hooks) {
+  graph_.SetOperatorHooks(hooks);
+}
+
 void MicroContextReportOpError(struct TfLiteContext* context,
                                const char* format, ...) {
   va_list args;
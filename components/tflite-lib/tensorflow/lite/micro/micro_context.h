@@ -97,6 +97,12 @@ class MicroContext {
 
   MicroGraph& graph() { return graph_; }
 
+  // Attaches hooks to the operator, which lets
+  // MicroInterpreter::AllocateTensors() rewrite it, see OperatorHooks. This
+  // method is only available in Init stage, and the hooks must live as long
+  // as the interpreter.
+  void SetOperatorHooks(const OperatorHooks* hooks);
+
   // Sets the pointer to a list of ScratchBufferHandle instances.
   // Not API between TFLM and kernels. Primarily used by the framework for
   // housekeeping in MicroContext.
@@ -60,12 +60,11 @@ TfLiteStatus MicroGraph::InitSubgraphs() {
     current_subgraph_index_ = subgraph_idx;
     uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
     for (size_t i = 0; i < operators_size; ++i) {
-      TfLiteNode* node =
-          &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
+      NodeAndRegistration* node_and_registration =
+          &subgraph_allocations_[subgraph_idx].node_and_registrations[i];
+      TfLiteNode* node = &node_and_registration->node;
       const TfLiteRegistration* registration =
-          subgraph_allocations_[subgraph_idx]
-              .node_and_registrations[i]
-              .registration;
+          node_and_registration->registration;
       size_t init_data_size;
       const char* init_data;
       if (registration->builtin_code == BuiltinOperator_CUSTOM) {
@@ -76,8 +75,10 @@ TfLiteStatus MicroGraph::InitSubgraphs() {
         init_data_size = 0;
       }
       if (registration->init) {
+        initializing_node_ = node_and_registration;
         node->user_data =
             registration->init(context_, init_data, init_data_size);
+        initializing_node_ = nullptr;
       }
     }
   }
@@ -143,6 +144,18 @@ TfLiteStatus MicroGraph::FreeSubgraphs() {
 }
 
 TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
+  if (static_cast<size_t>(subgraph_idx) >= subgraphs_->size()) {
+    MicroPrintf("Accessing subgraph %d but only %d subgraphs found",
+                subgraph_idx, subgraphs_->size());
+    return kTfLiteError;
+  }
+  return InvokeSubgraphOperators(subgraph_idx, 0,
+                                 NumSubgraphOperators(model_, subgraph_idx));
+}
+
+TfLiteStatus MicroGraph::InvokeSubgraphOperators(int subgraph_idx,
+                                                 size_t first_operator,
+                                                 size_t end_operator) {
   int previous_subgraph_idx = current_subgraph_index_;
   current_subgraph_index_ = subgraph_idx;
 
@@ -152,7 +165,10 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
     return kTfLiteError;
   }
   uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
-  for (size_t i = 0; i < operators_size; ++i) {
+  if (end_operator > operators_size) {
+    end_operator = operators_size;
+  }
+  for (size_t i = first_operator; i < end_operator; ++i) {
     TfLiteNode* node =
         &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
     const TfLiteRegistration* registration = subgraph_allocations_[subgraph_idx]
@@ -223,6 +239,12 @@ void MicroGraph::SetSubgraphAllocations(
   subgraph_allocations_ = subgraph_allocations;
 }
 
+void MicroGraph::SetOperatorHooks(const OperatorHooks* hooks) {
+  if (initializing_node_ != nullptr) {
+    initializing_node_->hooks = hooks;
+  }
+}
+
 size_t MicroGraph::NumSubgraphInputs(int subgraph_idx) {
   return model_->subgraphs()->Get(subgraph_idx)->inputs()->size();
 }
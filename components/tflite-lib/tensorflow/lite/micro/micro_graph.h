@@ -54,6 +54,13 @@ class MicroGraph {
   // the model.
   virtual TfLiteStatus InvokeSubgraph(int subgraph_idx);
 
+  // Calls TfLiteRegistration->Invoke for the operators [first_operator,
+  // end_operator) of a single subgraph. The tensors read by first_operator
+  // must already hold valid data.
+  virtual TfLiteStatus InvokeSubgraphOperators(int subgraph_idx,
+                                               size_t first_operator,
+                                               size_t end_operator);
+
   // Zeros out all variable tensors in all subgraphs in the model.
   virtual TfLiteStatus ResetVariableTensors();
 
@@ -87,12 +94,17 @@ class MicroGraph {
   // Get the resource variables for this TFLM graph.
   MicroResourceVariables* GetResourceVariables() { return resource_variables_; }
 
+  // Attaches hooks to the operator being initialized by InitSubgraphs(). Does
+  // nothing outside of it.
+  void SetOperatorHooks(const OperatorHooks* hooks);
+
  private:
   TfLiteContext* context_;
   const Model* model_;
   MicroAllocator* allocator_;
   SubgraphAllocations* subgraph_allocations_ = nullptr;
   int current_subgraph_index_;
+  NodeAndRegistration* initializing_node_ = nullptr;
   MicroResourceVariables* resource_variables_;
   const flatbuffers::Vector<flatbuffers::Offset<SubGraph>>* subgraphs_;
 
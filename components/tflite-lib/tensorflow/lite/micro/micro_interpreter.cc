@@ -17,6 +17,7 @@ limitations under the License.
 #include <cstdarg>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "flatbuffers/flatbuffers.h"  // from @flatbuffers
 #include "tensorflow/lite/c/c_api_types.h"
@@ -24,6 +25,8 @@ limitations under the License.
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
@@ -33,6 +36,53 @@ limitations under the License.
 #include "tensorflow/lite/schema/schema_utils.h"
 
 namespace tflite {
+namespace {
+
+TfLiteStatus FusedOperatorInvoke(TfLiteContext* context, TfLiteNode* node) {
+  return kTfLiteOk;
+}
+
+const TfLiteRegistration kFusedOperatorRegistration = {
+    /*init=*/nullptr,
+    /*free=*/nullptr,
+    /*prepare=*/nullptr,
+    /*invoke=*/FusedOperatorInvoke,
+    /*profiling_string=*/nullptr,
+    /*builtin_code=*/BuiltinOperator_CUSTOM,
+    /*custom_name=*/"FUSED",
+    /*version=*/0,
+    /*registration_external=*/nullptr};
+
+bool IsConstantTensor(const Model* model, const SubGraph* subgraph,
+                      int tensor_index) {
+  const Buffer* buffer =
+      model->buffers()->Get(subgraph->tensors()->Get(tensor_index)->buffer());
+  return buffer != nullptr && buffer->data() != nullptr &&
+         buffer->data()->size() > 0;
+}
+
+bool SameQuantization(const Tensor* a, const Tensor* b) {
+  const QuantizationParameters* qa = a->quantization();
+  const QuantizationParameters* qb = b->quantization();
+  if (qa == nullptr || qb == nullptr || qa->scale() == nullptr ||
+      qb->scale() == nullptr || qa->zero_point() == nullptr ||
+      qb->zero_point() == nullptr || qa->scale()->size() != 1 ||
+      qb->scale()->size() != 1 || qa->zero_point()->size() != 1 ||
+      qb->zero_point()->size() != 1) {
+    return false;
+  }
+  return qa->scale()->Get(0) == qb->scale()->Get(0) &&
+         qa->zero_point()->Get(0) == qb->zero_point()->Get(0);
+}
+
+int GetPadding(const TfLiteEvalTensor& paddings, int dimension, int side) {
+  if (paddings.type == kTfLiteInt64) {
+    return static_cast<int>(paddings.data.i64[dimension * 2 + side]);
+  }
+  return paddings.data.i32[dimension * 2 + side];
+}
+
+}  // namespace
 
 MicroInterpreter::MicroInterpreter(const Model* model,
                                    const MicroOpResolver& op_resolver,
@@ -167,8 +217,10 @@ TfLiteStatus MicroInterpreter::PrepareNodeAndRegistrationDataFromFlatbuffer() {
       TfLiteIntArray* outputs_array =
           FlatBufferVectorToTfLiteTypeArray(op->outputs());
 
-      TfLiteNode* node = &(
-          graph_.GetAllocations()[subgraph_idx].node_and_registrations[i].node);
+      NodeAndRegistration& node_and_registration =
+          graph_.GetAllocations()[subgraph_idx].node_and_registrations[i];
+      node_and_registration.hooks = nullptr;
+      TfLiteNode* node = &node_and_registration.node;
       *node = {};
       node->inputs = inputs_array;
       node->outputs = outputs_array;
@@ -185,6 +237,164 @@ TfLiteStatus MicroInterpreter::PrepareNodeAndRegistrationDataFromFlatbuffer() {
   return kTfLiteOk;
 }
 
+bool MicroInterpreter::IsFusedOperator(
+    const NodeAndRegistration& node_and_registration) {
+  return node_and_registration.registration == &kFusedOperatorRegistration;
+}
+
+// The padded cells hold the zero point, which is what the convolutions add for
+// the taps outside of their input. Only the convolutions that registered a
+// ConvFusedPadding in their OperatorHooks take part.
+TfLiteStatus MicroInterpreter::FusePadOperators() {
+  TfLiteIntArray* no_tensors = nullptr;
+
+  for (int subgraph_idx = 0; subgraph_idx < graph_.NumSubgraphs();
+       subgraph_idx++) {
+    const SubGraph* subgraph = model_->subgraphs()->Get(subgraph_idx);
+    SubgraphAllocations& allocations = graph_.GetAllocations()[subgraph_idx];
+    const uint32_t operators_size = NumSubgraphOperators(subgraph);
+
+    for (size_t i = 0; i < operators_size; ++i) {
+      NodeAndRegistration& pad = allocations.node_and_registrations[i];
+      if (pad.registration->builtin_code != BuiltinOperator_PAD ||
+          pad.node.inputs->size != 2 || pad.node.outputs->size != 1) {
+        continue;
+      }
+      const int input_index = pad.node.inputs->data[0];
+      const int paddings_index = pad.node.inputs->data[1];
+      const int output_index = pad.node.outputs->data[0];
+      const TfLiteEvalTensor& paddings = allocations.tensors[paddings_index];
+      if (allocations.tensors[input_index].type != kTfLiteInt8 ||
+          allocations.tensors[input_index].dims->size != 4 ||
+          !IsConstantTensor(model_, subgraph, paddings_index) ||
+          !SameQuantization(subgraph->tensors()->Get(input_index),
+                            subgraph->tensors()->Get(output_index))) {
+        continue;
+      }
+      if (GetPadding(paddings, 0, 0) != 0 || GetPadding(paddings, 0, 1) != 0 ||
+          GetPadding(paddings, 3, 0) != 0 || GetPadding(paddings, 3, 1) != 0 ||
+          GetPadding(paddings, 1, 0) < 0 || GetPadding(paddings, 1, 1) < 0 ||
+          GetPadding(paddings, 2, 0) < 0 || GetPadding(paddings, 2, 1) < 0) {
+        continue;
+      }
+
+      bool is_output = false;
+      for (size_t n = 0; n < subgraph->outputs()->size(); ++n) {
+        is_output |= subgraph->outputs()->Get(n) == output_index;
+      }
+
+      // The padded tensor must be read once, as the input of a convolution.
+      NodeAndRegistration* conv = nullptr;
+      int reads = 0;
+      for (size_t j = 0; j < operators_size; ++j) {
+        const TfLiteIntArray* inputs =
+            allocations.node_and_registrations[j].node.inputs;
+        for (int n = 0; n < inputs->size; ++n) {
+          if (inputs->data[n] == output_index) {
+            reads++;
+            if (n == kConvInputTensor) {
+              conv = &allocations.node_and_registrations[j];
+            }
+          }
+        }
+      }
+      if (is_output || reads != 1 || conv == nullptr ||
+          (conv->registration->builtin_code != BuiltinOperator_CONV_2D &&
+           conv->registration->builtin_code !=
+               BuiltinOperator_DEPTHWISE_CONV_2D) ||
+          conv->hooks == nullptr || conv->hooks->fused_padding == nullptr) {
+        continue;
+      }
+      const ConvFusedPadding padding = {
+          GetPadding(paddings, 1, 0), GetPadding(paddings, 1, 1),
+          GetPadding(paddings, 2, 0), GetPadding(paddings, 2, 1)};
+      if (conv->hooks->accepts_fused_padding != nullptr &&
+          !conv->hooks->accepts_fused_padding(
+              conv->node,
+              allocations.tensors[conv->node.inputs->data[kConvWeightsTensor]],
+              padding)) {
+        continue;
+      }
+
+      // The node inputs point into the flatbuffer, the convolution gets a copy.
+      TfLiteIntArray* conv_inputs =
+          reinterpret_cast<TfLiteIntArray*>(allocator_.AllocatePersistentBuffer(
+              TfLiteIntArrayGetSizeInBytes(conv->node.inputs->size)));
+      if (no_tensors == nullptr) {
+        no_tensors = reinterpret_cast<TfLiteIntArray*>(
+            allocator_.AllocatePersistentBuffer(
+                TfLiteIntArrayGetSizeInBytes(0)));
+      }
+      if (conv_inputs == nullptr || no_tensors == nullptr) {
+        MicroPrintf("Failed to allocate the inputs of a fused operator");
+        return kTfLiteError;
+      }
+      conv_inputs->size = conv->node.inputs->size;
+      for (int n = 0; n < conv_inputs->size; ++n) {
+        conv_inputs->data[n] = conv->node.inputs->data[n];
+      }
+      conv_inputs->data[kConvInputTensor] = input_index;
+      conv->node.inputs = conv_inputs;
+
+      *conv->hooks->fused_padding(conv->node.user_data) = padding;
+
+      no_tensors->size = 0;
+      pad.node.inputs = no_tensors;
+      pad.node.outputs = no_tensors;
+      pad.registration = &kFusedOperatorRegistration;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::MarkPackedWeights() {
+  if (model_->metadata() == nullptr) {
+    return kTfLiteOk;
+  }
+  for (size_t i = 0; i < model_->metadata()->size(); ++i) {
+    const Metadata* metadata = model_->metadata()->Get(i);
+    if (metadata->name() == nullptr ||
+        strcmp(metadata->name()->c_str(), kPackedWeightsMetadata) != 0) {
+      continue;
+    }
+    const Buffer* buffer = model_->buffers()->Get(metadata->buffer());
+    const size_t size =
+        buffer->data() != nullptr ? buffer->data()->size() / sizeof(int32_t)
+                                  : 0;
+    const int32_t* values =
+        size > 0 ? reinterpret_cast<const int32_t*>(buffer->data()->data())
+                 : nullptr;
+    if (size < 3 || values[0] != kPackedWeightsVersion ||
+        values[1] != kPackedWeightsChannelBlock ||
+        size != 3 + 2 * static_cast<size_t>(values[2])) {
+      MicroPrintf("Weights packed for another kernel, repack the model");
+      return kTfLiteError;
+    }
+
+    for (int n = 0; n < values[2]; ++n) {
+      const int subgraph_idx = values[3 + 2 * n];
+      const int operator_idx = values[4 + 2 * n];
+      if (subgraph_idx < 0 || subgraph_idx >= graph_.NumSubgraphs() ||
+          operator_idx < 0 ||
+          static_cast<uint32_t>(operator_idx) >=
+              NumSubgraphOperators(model_, subgraph_idx)) {
+        MicroPrintf("Packed weights of a missing operator");
+        return kTfLiteError;
+      }
+      NodeAndRegistration& node_and_registration =
+          graph_.GetAllocations()[subgraph_idx]
+              .node_and_registrations[operator_idx];
+      const OperatorHooks* hooks = node_and_registration.hooks;
+      if (hooks == nullptr || hooks->packed_weights == nullptr) {
+        MicroPrintf("Packed weights of an unsupported operator");
+        return kTfLiteError;
+      }
+      *hooks->packed_weights(node_and_registration.node.user_data) = true;
+    }
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroInterpreter::AllocateTensors() {
   SubgraphAllocations* allocations = allocator_.StartModelAllocation(model_);
 
@@ -206,6 +416,9 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
   context_.GetExternalContext = nullptr;
   TF_LITE_ENSURE_STATUS(graph_.InitSubgraphs());
 
+  TF_LITE_ENSURE_STATUS(FusePadOperators());
+  TF_LITE_ENSURE_STATUS(MarkPackedWeights());
+
   // Both AllocatePersistentBuffer and RequestScratchBufferInArena is
   // available in Prepare stage.
   context_.RequestScratchBufferInArena =
@@ -127,6 +127,11 @@ class MicroInterpreter {
   // arena.
   TfLiteStatus PrepareNodeAndRegistrationDataFromFlatbuffer();
 
+  // True for an operator that AllocateTensors() folded into the one reading its
+  // output, see FusePadOperators(). Its node has no inputs or outputs and
+  // invoking it does nothing.
+  static bool IsFusedOperator(const NodeAndRegistration& node_and_registration);
+
   // For debugging only.
   // Returns the actual used arena in bytes. This method gives the optimal arena
   // size. It's only available after `AllocateTensors` has been called.
@@ -139,6 +144,10 @@ class MicroInterpreter {
   const MicroAllocator& allocator() const { return allocator_; }
   const TfLiteContext& context() const { return context_; }
 
+  // Mutable access for subclasses that schedule the operators themselves.
+  MicroAllocator& mutable_allocator() { return allocator_; }
+  MicroGraph& graph() { return graph_; }
+
  private:
   // TODO(b/158263161): Consider switching to Create() function to enable better
   // error reporting during initialization.
@@ -147,6 +156,20 @@ class MicroInterpreter {
   // Gets the current subgraph index used from within context methods.
   int get_subgraph_index() { return graph_.GetCurrentSubgraphIndex(); }
 
+  // Folds every int8 PAD of the height and width whose only reader is the
+  // input of a CONV_2D or DEPTHWISE_CONV_2D into the ConvFusedPadding that
+  // operator registered in its OperatorHooks, and the operator then reads the
+  // unpadded tensor. Runs between the Init and
+  // the Prepare of the operators, so the convolutions compute their padding
+  // and scratch buffers with it and the memory plan never holds the padded
+  // tensor.
+  TfLiteStatus FusePadOperators();
+
+  // Sets the packed_weights flag of the operators that the
+  // kPackedWeightsMetadata of the model lists, before their Prepare. Fails
+  // for an operator whose kernel did not register it in its OperatorHooks.
+  TfLiteStatus MarkPackedWeights();
+
   const Model* model_;
   const MicroOpResolver& op_resolver_;
   ErrorReporter* error_reporter_;
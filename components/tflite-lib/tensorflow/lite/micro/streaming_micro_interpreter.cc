@@ -0,0 +1,540 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/streaming_micro_interpreter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/pooling.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+namespace {
+
+constexpr int kTimeDimension = 1;
+
+bool IsWindowOp(int32_t builtin_code) {
+  return builtin_code == BuiltinOperator_CONV_2D ||
+         builtin_code == BuiltinOperator_DEPTHWISE_CONV_2D ||
+         builtin_code == BuiltinOperator_MAX_POOL_2D ||
+         builtin_code == BuiltinOperator_AVERAGE_POOL_2D;
+}
+
+// Geometry of a windowed operator along the time axis.
+struct TimeWindow {
+  int stride;
+  int extent;
+  TfLitePaddingValues* padding;
+};
+
+// Both the reference and the ESP-NN kernels keep their OpDataConv or
+// OpDataPooling at the start of node->user_data.
+TimeWindow GetTimeWindow(const NodeAndRegistration& node_and_registration,
+                         const TfLiteEvalTensor* tensors) {
+  const TfLiteNode& node = node_and_registration.node;
+  TimeWindow window;
+
+  switch (node_and_registration.registration->builtin_code) {
+    case BuiltinOperator_CONV_2D: {
+      const auto* params =
+          static_cast<const TfLiteConvParams*>(node.builtin_data);
+      const int filter_height = tensors[node.inputs->data[1]].dims->data[1];
+      window.stride = params->stride_height;
+      window.extent = (filter_height - 1) * params->dilation_height_factor + 1;
+      window.padding = &static_cast<OpDataConv*>(node.user_data)->padding;
+      break;
+    }
+    case BuiltinOperator_DEPTHWISE_CONV_2D: {
+      const auto* params =
+          static_cast<const TfLiteDepthwiseConvParams*>(node.builtin_data);
+      const int filter_height = tensors[node.inputs->data[1]].dims->data[1];
+      window.stride = params->stride_height;
+      window.extent = (filter_height - 1) * params->dilation_height_factor + 1;
+      window.padding = &static_cast<OpDataConv*>(node.user_data)->padding;
+      break;
+    }
+    default: {
+      const auto* params =
+          static_cast<const TfLitePoolParams*>(node.builtin_data);
+      window.stride = params->stride_height;
+      window.extent = params->filter_height;
+      window.padding = &static_cast<OpDataPooling*>(node.user_data)->padding;
+      break;
+    }
+  }
+  return window;
+}
+
+int GetPadding(const TfLiteEvalTensor& paddings, int dimension, int side) {
+  if (paddings.type == kTfLiteInt64) {
+    return static_cast<int>(paddings.data.i64[dimension * 2 + side]);
+  }
+  return paddings.data.i32[dimension * 2 + side];
+}
+
+// Points `tensor` at `rows` rows starting at `data`, keeping the other dims.
+void SetRowView(TfLiteEvalTensor* tensor, TfLiteIntArray* view_dims,
+                int8_t* data, int rows) {
+  view_dims->size = tensor->dims->size;
+  for (int i = 0; i < tensor->dims->size; ++i) {
+    view_dims->data[i] = tensor->dims->data[i];
+  }
+  view_dims->data[kTimeDimension] = rows;
+  tensor->data.int8 = data;
+  tensor->dims = view_dims;
+}
+
+}  // namespace
+
+StreamingMicroInterpreter::StreamingMicroInterpreter(
+    const Model* model, const MicroOpResolver& op_resolver,
+    uint8_t* tensor_arena, size_t tensor_arena_size,
+    ErrorReporter* error_reporter, MicroResourceVariables* resource_variables,
+    MicroProfiler* profiler)
+    : MicroInterpreter(model, op_resolver, tensor_arena, tensor_arena_size,
+                       error_reporter, resource_variables, profiler),
+      model_(model) {}
+
+bool StreamingMicroInterpreter::IsConstantTensor(int tensor_index) const {
+  const Tensor* tensor =
+      model_->subgraphs()->Get(0)->tensors()->Get(tensor_index);
+  const Buffer* buffer = model_->buffers()->Get(tensor->buffer());
+  return buffer != nullptr && buffer->data() != nullptr &&
+         buffer->data()->size() > 0;
+}
+
+bool StreamingMicroInterpreter::IsStreamable(size_t operator_index) {
+  SubgraphAllocations* allocations = graph().GetAllocations();
+  const NodeAndRegistration& node_and_registration =
+      allocations[0].node_and_registrations[operator_index];
+  const TfLiteNode& node = node_and_registration.node;
+  const int32_t builtin_code = node_and_registration.registration->builtin_code;
+  const TfLiteEvalTensor* tensors = allocations[0].tensors;
+
+  // A PAD fused into its convolution has nothing left to stream.
+  if (IsFusedOperator(node_and_registration)) {
+    return true;
+  }
+  if (node.outputs->size != 1 || node.inputs->size < 1) {
+    return false;
+  }
+  const int output_index = node.outputs->data[0];
+  const TfLiteEvalTensor& output = tensors[output_index];
+  if (output.type != kTfLiteInt8 || output.dims->size != 4 ||
+      output.dims->data[0] != 1) {
+    return false;
+  }
+
+  const int input_index = node.inputs->data[0];
+  const StreamingTensor& input = tensors_[input_index];
+  int stride = 0;
+
+  if (builtin_code == BuiltinOperator_RESHAPE) {
+    // Only the reshape that turns the model input into the time x feature map.
+    if (input_index != model_->subgraphs()->Get(0)->inputs()->Get(0) ||
+        tensors[input_index].type != kTfLiteInt8) {
+      return false;
+    }
+    stride = 1;
+  } else if (IsWindowOp(builtin_code)) {
+    if (input.stride == 0) {
+      return false;
+    }
+    for (int i = 1; i < node.inputs->size; ++i) {
+      const int operand = node.inputs->data[i];
+      if (operand >= 0 && !IsConstantTensor(operand)) {
+        return false;
+      }
+    }
+    stride =
+        input.stride * GetTimeWindow(node_and_registration, tensors).stride;
+  } else if (builtin_code == BuiltinOperator_PAD) {
+    if (input.stride == 0 || node.inputs->size != 2 ||
+        !IsConstantTensor(node.inputs->data[1])) {
+      return false;
+    }
+    const TfLiteEvalTensor& paddings = tensors[node.inputs->data[1]];
+    if (GetPadding(paddings, 0, 0) != 0 || GetPadding(paddings, 0, 1) != 0 ||
+        GetPadding(paddings, 3, 0) != 0 || GetPadding(paddings, 3, 1) != 0) {
+      return false;
+    }
+    stride = input.stride;
+  } else if (builtin_code == BuiltinOperator_ADD) {
+    if (node.inputs->size != 2) {
+      return false;
+    }
+    const int other_index = node.inputs->data[1];
+    if (input.stride == 0 || tensors_[other_index].stride != input.stride ||
+        !TfLiteIntArrayEqual(tensors[input_index].dims, output.dims) ||
+        !TfLiteIntArrayEqual(tensors[other_index].dims, output.dims)) {
+      return false;
+    }
+    stride = input.stride;
+  } else {
+    return false;
+  }
+
+  StreamingTensor& streamed = tensors_[output_index];
+  streamed.data = nullptr;
+  streamed.height = output.dims->data[kTimeDimension];
+  streamed.row_bytes = output.dims->data[2] * output.dims->data[3];
+  streamed.stride = stride;
+  streamed.shift = -1;
+  streamed.clean_begin = 0;
+  streamed.clean_end = 0;
+  return true;
+}
+
+bool StreamingMicroInterpreter::IsBoundaryTensor(int tensor_index) {
+  const SubGraph* subgraph = model_->subgraphs()->Get(0);
+  for (size_t i = 0; i < subgraph->outputs()->size(); ++i) {
+    if (subgraph->outputs()->Get(i) == tensor_index) {
+      return true;
+    }
+  }
+
+  const NodeAndRegistration* node_and_registrations =
+      graph().GetAllocations()[0].node_and_registrations;
+  for (size_t i = num_streaming_operators_; i < subgraph->operators()->size();
+       ++i) {
+    const TfLiteIntArray* inputs = node_and_registrations[i].node.inputs;
+    for (int j = 0; j < inputs->size; ++j) {
+      if (inputs->data[j] == tensor_index) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+TfLiteStatus StreamingMicroInterpreter::AllocateStreamingState() {
+  if (state_allocated_) {
+    return kTfLiteOk;
+  }
+
+  SubgraphAllocations* allocations = graph().GetAllocations();
+  if (allocations == nullptr) {
+    MicroPrintf("AllocateTensors() must be called before streaming");
+    return kTfLiteError;
+  }
+
+  const SubGraph* subgraph = model_->subgraphs()->Get(0);
+  const size_t num_tensors = subgraph->tensors()->size();
+  const size_t num_operators = subgraph->operators()->size();
+  MicroAllocator& allocator = mutable_allocator();
+
+  tensors_ = static_cast<StreamingTensor*>(
+      allocator.AllocatePersistentBuffer(sizeof(StreamingTensor) *
+                                         num_tensors));
+  if (tensors_ == nullptr) {
+    MicroPrintf("Failed to allocate streaming state for %d tensors",
+                num_tensors);
+    return kTfLiteError;
+  }
+  memset(tensors_, 0, sizeof(StreamingTensor) * num_tensors);
+
+  for (TfLiteIntArray*& view_dims : view_dims_) {
+    view_dims = static_cast<TfLiteIntArray*>(
+        allocator.AllocatePersistentBuffer(TfLiteIntArrayGetSizeInBytes(4)));
+    if (view_dims == nullptr) {
+      MicroPrintf("Failed to allocate streaming views");
+      return kTfLiteError;
+    }
+  }
+
+  num_streaming_operators_ = 0;
+  while (num_streaming_operators_ < num_operators &&
+         IsStreamable(num_streaming_operators_)) {
+    num_streaming_operators_++;
+  }
+
+  // Every streamed tensor gets its own cache, since the arena buffers are
+  // reused by the memory planner within an invocation. That includes the
+  // reshaped input: the model input is dead after the reshape as far as the
+  // planner knows, so the scratch buffers of the next kernels may overlap it.
+  streaming_bytes_ = 0;
+  for (size_t i = 0; i < num_streaming_operators_; ++i) {
+    const NodeAndRegistration& node_and_registration =
+        allocations[0].node_and_registrations[i];
+    if (IsFusedOperator(node_and_registration)) {
+      continue;
+    }
+    StreamingTensor& tensor =
+        tensors_[node_and_registration.node.outputs->data[0]];
+    const size_t bytes = tensor.height * tensor.row_bytes;
+    tensor.data =
+        static_cast<int8_t*>(allocator.AllocatePersistentBuffer(bytes));
+    if (tensor.data == nullptr) {
+      MicroPrintf("Failed to allocate %d bytes of streaming cache", bytes);
+      return kTfLiteError;
+    }
+    streaming_bytes_ += bytes;
+  }
+
+  // Streamed tensors read by the remaining operators are copied back to the
+  // arena before those run.
+  num_boundary_tensors_ = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (size_t i = 0; i < num_tensors; ++i) {
+      if (tensors_[i].stride > 0 && IsBoundaryTensor(i)) {
+        if (pass == 1) {
+          boundary_tensors_[num_boundary_tensors_] = i;
+        }
+        num_boundary_tensors_++;
+      }
+    }
+    if (pass == 0) {
+      boundary_tensors_ = static_cast<int*>(allocator.AllocatePersistentBuffer(
+          sizeof(int) * std::max(num_boundary_tensors_, 1)));
+      if (boundary_tensors_ == nullptr) {
+        MicroPrintf("Failed to allocate streaming boundary");
+        return kTfLiteError;
+      }
+      num_boundary_tensors_ = 0;
+    }
+  }
+
+  state_allocated_ = true;
+  state_valid_ = false;
+  return kTfLiteOk;
+}
+
+TfLiteStatus StreamingMicroInterpreter::EvalRows(size_t operator_index,
+                                                 int begin, int end) {
+  SubgraphAllocations* allocations = graph().GetAllocations();
+  const NodeAndRegistration& node_and_registration =
+      allocations[0].node_and_registrations[operator_index];
+  const TfLiteNode& node = node_and_registration.node;
+  const int32_t builtin_code = node_and_registration.registration->builtin_code;
+  TfLiteEvalTensor* tensors = allocations[0].tensors;
+
+  last_recomputed_bytes_ +=
+      (end - begin) * tensors_[node.outputs->data[0]].row_bytes;
+
+  if (builtin_code == BuiltinOperator_PAD) {
+    EvalPadRows(operator_index, begin, end);
+    return kTfLiteOk;
+  }
+
+  // Point the kernel at the rows to compute within the caches, then restore
+  // the arena tensors for the regular Invoke().
+  const int num_views = builtin_code == BuiltinOperator_ADD ? 2 : 1;
+  TfLiteEvalTensor* views[3];
+  TfLiteEvalTensor saved[3];
+  for (int i = 0; i < num_views; ++i) {
+    views[i] = &tensors[node.inputs->data[i]];
+  }
+  views[num_views] = &tensors[node.outputs->data[0]];
+  for (int i = 0; i <= num_views; ++i) {
+    saved[i] = *views[i];
+  }
+
+  TfLitePaddingValues* padding = nullptr;
+  int saved_padding_height = 0;
+
+  if (builtin_code == BuiltinOperator_ADD) {
+    for (int i = 0; i < num_views; ++i) {
+      const StreamingTensor& input = tensors_[node.inputs->data[i]];
+      SetRowView(views[i], view_dims_[i], input.data + begin * input.row_bytes,
+                 end - begin);
+    }
+  } else {
+    // The first output row becomes row `begin`, so the top padding shrinks
+    // accordingly and once it is used up the input view starts further down.
+    const TimeWindow window = GetTimeWindow(node_and_registration, tensors);
+    const StreamingTensor& input = tensors_[node.inputs->data[0]];
+    padding = window.padding;
+    saved_padding_height = padding->height;
+
+    int padding_height = saved_padding_height - begin * window.stride;
+    int input_offset = 0;
+    if (padding_height < 0) {
+      input_offset = std::min(-padding_height, input.height);
+      padding_height = 0;
+    }
+    padding->height = padding_height;
+    SetRowView(views[0], view_dims_[0],
+               input.data + input_offset * input.row_bytes,
+               input.height - input_offset);
+  }
+
+  const StreamingTensor& output = tensors_[node.outputs->data[0]];
+  SetRowView(views[num_views], view_dims_[2],
+             output.data + begin * output.row_bytes, end - begin);
+
+  TfLiteStatus status = graph().InvokeSubgraphOperators(0, operator_index,
+                                                        operator_index + 1);
+
+  for (int i = 0; i <= num_views; ++i) {
+    *views[i] = saved[i];
+  }
+  if (padding != nullptr) {
+    padding->height = saved_padding_height;
+  }
+  return status;
+}
+
+void StreamingMicroInterpreter::EvalPadRows(size_t operator_index, int begin,
+                                            int end) {
+  SubgraphAllocations* allocations = graph().GetAllocations();
+  const TfLiteNode& node =
+      allocations[0].node_and_registrations[operator_index].node;
+  const TfLiteEvalTensor& paddings =
+      allocations[0].tensors[node.inputs->data[1]];
+  const StreamingTensor& input = tensors_[node.inputs->data[0]];
+  const StreamingTensor& output = tensors_[node.outputs->data[0]];
+
+  // PAD fills with the output zero point, as the kernel does.
+  const Tensor* output_tensor =
+      model_->subgraphs()->Get(0)->tensors()->Get(node.outputs->data[0]);
+  int8_t pad_value = 0;
+  if (output_tensor->quantization() != nullptr &&
+      output_tensor->quantization()->zero_point() != nullptr &&
+      output_tensor->quantization()->zero_point()->size() > 0) {
+    pad_value =
+        static_cast<int8_t>(
+            output_tensor->quantization()->zero_point()->Get(0));
+  }
+
+  const int top = GetPadding(paddings, kTimeDimension, 0);
+  const int channels =
+      allocations[0].tensors[node.outputs->data[0]].dims->data[3];
+  const int left_bytes = GetPadding(paddings, 2, 0) * channels;
+  const int right_bytes = output.row_bytes - left_bytes - input.row_bytes;
+
+  for (int row = begin; row < end; ++row) {
+    int8_t* output_row = output.data + row * output.row_bytes;
+    const int input_row = row - top;
+    if (input_row < 0 || input_row >= input.height) {
+      memset(output_row, pad_value, output.row_bytes);
+      continue;
+    }
+    memset(output_row, pad_value, left_bytes);
+    memcpy(output_row + left_bytes, input.data + input_row * input.row_bytes,
+           input.row_bytes);
+    memset(output_row + left_bytes + input.row_bytes, pad_value, right_bytes);
+  }
+}
+
+TfLiteStatus StreamingMicroInterpreter::InvokeStreaming(int shift) {
+  TF_LITE_ENSURE_STATUS(AllocateStreamingState());
+
+  SubgraphAllocations* allocations = graph().GetAllocations();
+  TfLiteEvalTensor* tensors = allocations[0].tensors;
+  const bool recompute_all = !state_valid_ || shift < 0;
+  last_recomputed_bytes_ = 0;
+  state_valid_ = false;
+
+  for (size_t i = 0; i < num_streaming_operators_; ++i) {
+    const NodeAndRegistration& node_and_registration =
+        allocations[0].node_and_registrations[i];
+    if (IsFusedOperator(node_and_registration)) {
+      continue;
+    }
+    const TfLiteNode& node = node_and_registration.node;
+    const int32_t builtin_code =
+        node_and_registration.registration->builtin_code;
+    StreamingTensor& output = tensors_[node.outputs->data[0]];
+
+    if (builtin_code == BuiltinOperator_RESHAPE) {
+      memcpy(output.data, tensors[node.inputs->data[0]].data.int8,
+             output.height * output.row_bytes);
+      output.shift = recompute_all ? -1 : shift;
+      output.clean_begin = 0;
+      output.clean_end =
+          (output.shift >= 0 && output.shift < output.height)
+              ? output.height - output.shift
+              : 0;
+      continue;
+    }
+
+    const StreamingTensor& input = tensors_[node.inputs->data[0]];
+    const int stride = output.stride / input.stride;
+    int begin = 0;
+    int end = 0;
+
+    // Output rows whose whole receptive field is made of clean input rows are
+    // the same as the row `shift` places further down in the last invocation.
+    if (IsWindowOp(builtin_code)) {
+      const TimeWindow window = GetTimeWindow(node_and_registration, tensors);
+      const int last_window_start =
+          input.clean_end + window.padding->height - window.extent;
+      begin =
+          (input.clean_begin + window.padding->height + stride - 1) / stride;
+      end = last_window_start < 0 ? 0 : last_window_start / stride + 1;
+    } else if (builtin_code == BuiltinOperator_PAD) {
+      const int top =
+          GetPadding(tensors[node.inputs->data[1]], kTimeDimension, 0);
+      begin = input.clean_begin + top;
+      end = input.clean_end + top;
+    } else {
+      const StreamingTensor& other = tensors_[node.inputs->data[1]];
+      begin = std::max(input.clean_begin, other.clean_begin);
+      end = std::min(input.clean_end, other.clean_end);
+    }
+
+    output.shift =
+        (input.shift >= 0 && input.shift % stride == 0) ? input.shift / stride
+                                                        : -1;
+    if (output.shift >= 0) {
+      end = std::min(end, output.height - output.shift);
+    }
+    if (output.shift < 0 || end <= begin) {
+      begin = 0;
+      end = 0;
+    }
+
+    if (end > begin && output.shift > 0) {
+      memmove(output.data + begin * output.row_bytes,
+              output.data + (begin + output.shift) * output.row_bytes,
+              (end - begin) * output.row_bytes);
+    }
+    output.clean_begin = begin;
+    output.clean_end = end;
+
+    if (end <= begin) {
+      TF_LITE_ENSURE_STATUS(EvalRows(i, 0, output.height));
+    } else {
+      if (begin > 0) {
+        TF_LITE_ENSURE_STATUS(EvalRows(i, 0, begin));
+      }
+      if (end < output.height) {
+        TF_LITE_ENSURE_STATUS(EvalRows(i, end, output.height));
+      }
+    }
+  }
+  state_valid_ = true;
+
+  for (int i = 0; i < num_boundary_tensors_; ++i) {
+    const int tensor_index = boundary_tensors_[i];
+    const StreamingTensor& streamed = tensors_[tensor_index];
+    if (tensors[tensor_index].data.int8 != streamed.data) {
+      memcpy(tensors[tensor_index].data.int8, streamed.data,
+             streamed.height * streamed.row_bytes);
+    }
+  }
+
+  return graph().InvokeSubgraphOperators(
+      0, num_streaming_operators_,
+      model_->subgraphs()->Get(0)->operators()->size());
+}
+
+}  // namespace tflite
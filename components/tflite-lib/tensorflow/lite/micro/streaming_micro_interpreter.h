@@ -0,0 +1,104 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_STREAMING_MICRO_INTERPRETER_H_
+#define TENSORFLOW_LITE_MICRO_STREAMING_MICRO_INTERPRETER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/micro/micro_interpreter.h"
+
+namespace tflite {
+
+// Interpreter for models that slide over a spectrogram-like input whose second
+// dimension is time: between two invocations the input moves up by a few rows
+// and only the newest rows are new.
+//
+// The leading run of operators that are local along the time axis (RESHAPE of
+// the input, CONV_2D, DEPTHWISE_CONV_2D, MAX_POOL_2D, AVERAGE_POOL_2D, PAD and
+// ADD on int8 NHWC tensors) keeps a copy of its outputs in the arena tail.
+// InvokeStreaming() shifts those caches by the same amount as the input and
+// only evaluates the rows whose receptive field changed, the remaining
+// operators run as usual.
+//
+// A tensor can only reuse rows when the shift is a multiple of its cumulative
+// stride along time, e.g. a model with five stride-2 layers reuses all of its
+// prefix only when invoked every 32 rows. Layers where this does not hold are
+// simply recomputed in full, so results are always identical to Invoke().
+class StreamingMicroInterpreter : public MicroInterpreter {
+ public:
+  StreamingMicroInterpreter(
+      const Model* model, const MicroOpResolver& op_resolver,
+      uint8_t* tensor_arena, size_t tensor_arena_size,
+      ErrorReporter* error_reporter,
+      MicroResourceVariables* resource_variables = nullptr,
+      MicroProfiler* profiler = nullptr);
+
+  // Finds the streamable operators and allocates their caches from the arena.
+  // Must be called after AllocateTensors(), InvokeStreaming() calls it lazily.
+  TfLiteStatus AllocateStreamingState();
+
+  // Runs the model on an input that equals the previous one moved up by
+  // `shift` rows along time, with only the last `shift` rows being new. Any
+  // negative shift, or the first call, recomputes every row.
+  TfLiteStatus InvokeStreaming(int shift);
+
+  // Drops the cached activations, the next InvokeStreaming() recomputes all.
+  void ResetStreamingState() { state_valid_ = false; }
+
+  // Number of leading operators evaluated incrementally.
+  size_t streaming_operators() const { return num_streaming_operators_; }
+
+  // Arena bytes used by the activation caches.
+  size_t streaming_bytes() const { return streaming_bytes_; }
+
+  // Output bytes the streamed operators recomputed in the last invocation, out
+  // of streaming_bytes().
+  size_t last_recomputed_bytes() const { return last_recomputed_bytes_; }
+
+ private:
+  struct StreamingTensor {
+    int8_t* data;
+    int height;
+    int row_bytes;
+    // Input rows per row of this tensor, 0 if the tensor is not streamed.
+    int stride;
+    // Rows this tensor moved up in the current invocation, -1 if unaligned.
+    int shift;
+    // Rows [clean_begin, clean_end) are still valid after the shift.
+    int clean_begin;
+    int clean_end;
+  };
+
+  bool IsConstantTensor(int tensor_index) const;
+  bool IsStreamable(size_t operator_index);
+  bool IsBoundaryTensor(int tensor_index);
+  TfLiteStatus EvalRows(size_t operator_index, int begin, int end);
+  void EvalPadRows(size_t operator_index, int begin, int end);
+
+  const Model* model_;
+  StreamingTensor* tensors_ = nullptr;
+  int* boundary_tensors_ = nullptr;
+  int num_boundary_tensors_ = 0;
+  TfLiteIntArray* view_dims_[3] = {};
+  size_t num_streaming_operators_ = 0;
+  size_t streaming_bytes_ = 0;
+  size_t last_recomputed_bytes_ = 0;
+  bool state_allocated_ = false;
+  bool state_valid_ = false;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_STREAMING_MICRO_INTERPRETER_H_
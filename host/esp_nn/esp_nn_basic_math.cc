@@ -0,0 +1,37 @@
+/********************************************************************************************
+* Portable esp-nn elementwise add and mul.
+***********************************************************************************************/
+
+#include "esp_nn.h"
+#include "esp_nn_common.h"
+
+void esp_nn_add_elementwise_s8 ( const int8_t *input1_data, const int8_t *input2_data,
+                                 const int32_t input1_offset, const int32_t input2_offset,
+                                 const int32_t input1_mult, const int32_t input2_mult,
+                                 const int32_t input1_shift, const int32_t input2_shift,
+                                 const int32_t left_shift, int8_t *output,
+                                 const int32_t out_offset, const int32_t out_mult, const int32_t out_shift,
+                                 const int32_t activation_min, const int32_t activation_max,
+                                 const int32_t size ) {
+    for (int i = 0; i < size; i++) {
+        const int32_t shifted1 = (input1_offset + input1_data[i]) * (1 << left_shift);
+        const int32_t shifted2 = (input2_offset + input2_data[i]) * (1 << left_shift);
+        const int32_t scaled1 = esp_nn_multiply_by_quantized_mult(shifted1, input1_mult, input1_shift);
+        const int32_t scaled2 = esp_nn_multiply_by_quantized_mult(shifted2, input2_mult, input2_shift);
+        const int32_t sum = esp_nn_multiply_by_quantized_mult(scaled1 + scaled2, out_mult, out_shift);
+        output[i] = esp_nn_clamp_s8(sum + out_offset, activation_min, activation_max);
+    }
+}
+
+void esp_nn_mul_elementwise_s8 ( const int8_t *input1_data, const int8_t *input2_data,
+                                 const int32_t input1_offset, const int32_t input2_offset,
+                                 int8_t *output, const int32_t out_offset,
+                                 const int32_t out_mult, const int32_t out_shift,
+                                 const int32_t activation_min, const int32_t activation_max,
+                                 const int32_t size ) {
+    for (int i = 0; i < size; i++) {
+        const int32_t product = (input1_offset + input1_data[i]) * (input2_offset + input2_data[i]);
+        const int32_t scaled = esp_nn_multiply_by_quantized_mult(product, out_mult, out_shift);
+        output[i] = esp_nn_clamp_s8(scaled + out_offset, activation_min, activation_max);
+    }
+}
@@ -0,0 +1,135 @@
+/********************************************************************************************
+* Helpers shared by the portable esp-nn kernels.
+***********************************************************************************************/
+
+#ifndef _ESP_NN_COMMON_H
+#define _ESP_NN_COMMON_H
+
+#include <stdint.h>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+// gemmlowp::SaturatingRoundingDoublingHighMul.
+static inline int32_t esp_nn_sat_round_doubling_high_mul ( int32_t a, int32_t b ) {
+    if (a == INT32_MIN && b == INT32_MIN) {return INT32_MAX;}
+    const int64_t ab = (int64_t) a * b;
+    const int32_t nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30));
+    return (int32_t) ((ab + nudge) / ((int64_t) 1 << 31));
+}
+
+// gemmlowp::RoundingDivideByPOT.
+static inline int32_t esp_nn_div_by_power_of_two ( int32_t x, int exponent ) {
+    const int32_t mask = (int32_t) (((int64_t) 1 << exponent) - 1);
+    const int32_t remainder = x & mask;
+    const int32_t threshold = (mask >> 1) + (x < 0);
+    return (x >> exponent) + (remainder > threshold);
+}
+
+// tflite::MultiplyByQuantizedMultiplier, without TFLITE_SINGLE_ROUNDING like the rest of the tree.
+static inline int32_t esp_nn_multiply_by_quantized_mult ( int32_t x, int32_t mult, int32_t shift ) {
+    const int left_shift = shift > 0 ? shift : 0;
+    const int right_shift = shift > 0 ? 0 : -shift;
+    return esp_nn_div_by_power_of_two(esp_nn_sat_round_doubling_high_mul(x * (1 << left_shift), mult),
+                                      right_shift);
+}
+
+static inline int8_t esp_nn_clamp_s8 ( int32_t x, int32_t activation_min, int32_t activation_max ) {
+    x = x < activation_min ? activation_min : x;
+    x = x > activation_max ? activation_max : x;
+    return (int8_t) x;
+}
+
+// Sum of a[i] * b[i] for filters[0..3], sharing the loads of a.
+static inline void esp_nn_dot_s8_x4 ( const int8_t *a, const int8_t *const *filters, int len, int32_t *sums ) {
+    int i = 0;
+    int32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+#if defined(__AVX2__)
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+    for (; i + 16 <= len; i += 16) {
+        const __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (a + i)));
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(va, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (filters[0] + i)))));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(va, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (filters[1] + i)))));
+        acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(va, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (filters[2] + i)))));
+        acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(va, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (filters[3] + i)))));
+    }
+    // Horizontal sums of the four accumulators at once.
+    const __m256i h01 = _mm256_hadd_epi32(acc0, acc1);
+    const __m256i h23 = _mm256_hadd_epi32(acc2, acc3);
+    const __m256i h = _mm256_hadd_epi32(h01, h23);
+    const __m128i r = _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+    s0 = _mm_extract_epi32(r, 0);
+    s1 = _mm_extract_epi32(r, 1);
+    s2 = _mm_extract_epi32(r, 2);
+    s3 = _mm_extract_epi32(r, 3);
+#elif defined(__SSE4_1__)
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    __m128i acc2 = _mm_setzero_si128(), acc3 = _mm_setzero_si128();
+    for (; i + 8 <= len; i += 8) {
+        const __m128i va = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (a + i)));
+        acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(va, _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (filters[0] + i)))));
+        acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(va, _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (filters[1] + i)))));
+        acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(va, _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (filters[2] + i)))));
+        acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(va, _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (filters[3] + i)))));
+    }
+    const __m128i r = _mm_hadd_epi32(_mm_hadd_epi32(acc0, acc1), _mm_hadd_epi32(acc2, acc3));
+    s0 = _mm_extract_epi32(r, 0);
+    s1 = _mm_extract_epi32(r, 1);
+    s2 = _mm_extract_epi32(r, 2);
+    s3 = _mm_extract_epi32(r, 3);
+#endif
+    for (; i < len; i++) {
+        const int32_t va = a[i];
+        s0 += va * filters[0][i];
+        s1 += va * filters[1][i];
+        s2 += va * filters[2][i];
+        s3 += va * filters[3][i];
+    }
+    sums[0] = s0;
+    sums[1] = s1;
+    sums[2] = s2;
+    sums[3] = s3;
+}
+
+// Sum of a[i] * b[i].
+static inline int32_t esp_nn_dot_s8 ( const int8_t *a, const int8_t *b, int len ) {
+    int i = 0;
+    int32_t sum = 0;
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 16 <= len; i += 16) {
+        const __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (a + i)));
+        const __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+    }
+    __m128i r = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    r = _mm_hadd_epi32(r, r);
+    r = _mm_hadd_epi32(r, r);
+    sum = _mm_cvtsi128_si32(r);
+#elif defined(__SSE4_1__)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 8 <= len; i += 8) {
+        const __m128i va = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (a + i)));
+        const __m128i vb = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (b + i)));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+    }
+    acc = _mm_hadd_epi32(acc, acc);
+    acc = _mm_hadd_epi32(acc, acc);
+    sum = _mm_cvtsi128_si32(acc);
+#endif
+    for (; i < len; i++) {
+        sum += (int32_t) a[i] * b[i];
+    }
+    return sum;
+}
+
+// Sum of a[i].
+static inline int32_t esp_nn_sum_s8 ( const int8_t *a, int len ) {
+    int32_t sum = 0;
+    for (int i = 0; i < len; i++) {sum += a[i];}
+    return sum;
+}
+
+#endif // _ESP_NN_COMMON_H
@@ -0,0 +1,227 @@
+/********************************************************************************************
+* Portable esp-nn convolutions.
+*
+* CONV_2D gathers the receptive field of each output pixel once (im2col of one pixel, padded
+* with the input zero point so padding adds nothing) and runs it against four filters at a
+* time. The input offset is folded into a per channel constant, sum(filter) * in_offset plus
+* the bias, so the inner loop is a plain int8 dot product. DEPTHWISE_CONV_2D accumulates
+* whole pixels of channels per filter tap into an int32 row.
+***********************************************************************************************/
+
+#include "esp_nn.h"
+#include "esp_nn_common.h"
+
+#include <string.h>
+
+// The scratch buffers are set right before each call, per thread so that several
+// interpreters can run side by side on the host.
+static thread_local void * conv_scratch = NULL;
+static thread_local void * depthwise_scratch = NULL;
+
+static inline int align16 ( int size ) {
+    return (size + 15) & ~15;
+}
+
+int esp_nn_get_conv_scratch_size ( const data_dims_t *input_dims, const data_dims_t *filter_dims,
+                                   const data_dims_t *output_dims, const conv_params_t *conv_params ) {
+    const int col_len = filter_dims->width * filter_dims->height * input_dims->channels;
+    return align16(output_dims->channels * (int) sizeof(int32_t)) + align16(col_len);
+}
+
+void esp_nn_set_conv_scratch_buf ( void *buf ) {
+    conv_scratch = buf;
+}
+
+void esp_nn_conv_s8 ( const data_dims_t *input_dims, const int8_t *input_data,
+                      const data_dims_t *filter_dims, const int8_t *filter_data,
+                      const int32_t *bias, const data_dims_t *output_dims, int8_t *out_data,
+                      const conv_params_t *conv_params, const quant_data_t *quant_data ) {
+    const int input_wd = input_dims->width;
+    const int input_ht = input_dims->height;
+    const int in_ch = input_dims->channels;
+    const int filter_wd = filter_dims->width;
+    const int filter_ht = filter_dims->height;
+    const int output_wd = output_dims->width;
+    const int output_ht = output_dims->height;
+    const int out_ch = output_dims->channels;
+    const int stride_wd = conv_params->stride.width;
+    const int stride_ht = conv_params->stride.height;
+    const int pad_wd = conv_params->padding.width;
+    const int pad_ht = conv_params->padding.height;
+    const int32_t in_offset = conv_params->in_offset;
+    const int32_t out_offset = conv_params->out_offset;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+
+    const int row_len = filter_wd * in_ch;
+    const int col_len = filter_ht * row_len;
+    int32_t * channel_offset = (int32_t *) conv_scratch;
+    int8_t * col = (int8_t *) conv_scratch + align16(out_ch * (int) sizeof(int32_t));
+    // (x + in_offset) is 0 for padding when x is the input zero point.
+    const int8_t pad_value = (int8_t) -in_offset;
+
+    for (int oc = 0; oc < out_ch; oc++) {
+        channel_offset[oc] = esp_nn_sum_s8(filter_data + oc * col_len, col_len) * in_offset + (bias ? bias[oc] : 0);
+    }
+
+    for (int out_y = 0; out_y < output_ht; out_y++) {
+        const int in_y0 = out_y * stride_ht - pad_ht;
+        for (int out_x = 0; out_x < output_wd; out_x++) {
+            const int in_x0 = out_x * stride_wd - pad_wd;
+            const bool inside = in_y0 >= 0 && in_x0 >= 0 &&
+                                in_y0 + filter_ht <= input_ht && in_x0 + filter_wd <= input_wd;
+
+            const int8_t * src;
+            if (inside && filter_ht == 1) {
+                // One contiguous row, read in place.
+                src = input_data + (in_y0 * input_wd + in_x0) * in_ch;
+            } else if (inside) {
+                for (int fy = 0; fy < filter_ht; fy++) {
+                    memcpy(col + fy * row_len, input_data + ((in_y0 + fy) * input_wd + in_x0) * in_ch, row_len);
+                }
+                src = col;
+            } else {
+                for (int fy = 0; fy < filter_ht; fy++) {
+                    const int in_y = in_y0 + fy;
+                    for (int fx = 0; fx < filter_wd; fx++) {
+                        const int in_x = in_x0 + fx;
+                        int8_t * dst = col + fy * row_len + fx * in_ch;
+                        if (in_y < 0 || in_y >= input_ht || in_x < 0 || in_x >= input_wd) {
+                            memset(dst, pad_value, in_ch);
+                        } else {
+                            memcpy(dst, input_data + (in_y * input_wd + in_x) * in_ch, in_ch);
+                        }
+                    }
+                }
+                src = col;
+            }
+
+            int8_t * out = out_data + (out_y * output_wd + out_x) * out_ch;
+            int oc = 0;
+            for (; oc + 4 <= out_ch; oc += 4) {
+                const int8_t * filters[4] = {
+                    filter_data + oc * col_len, filter_data + (oc + 1) * col_len,
+                    filter_data + (oc + 2) * col_len, filter_data + (oc + 3) * col_len
+                };
+                int32_t sums[4];
+                esp_nn_dot_s8_x4(src, filters, col_len, sums);
+                for (int k = 0; k < 4; k++) {
+                    int32_t acc = sums[k] + channel_offset[oc + k];
+                    acc = esp_nn_multiply_by_quantized_mult(acc, quant_data->mult[oc + k], quant_data->shift[oc + k]);
+                    out[oc + k] = esp_nn_clamp_s8(acc + out_offset, activation_min, activation_max);
+                }
+            }
+            for (; oc < out_ch; oc++) {
+                int32_t acc = esp_nn_dot_s8(src, filter_data + oc * col_len, col_len) + channel_offset[oc];
+                acc = esp_nn_multiply_by_quantized_mult(acc, quant_data->mult[oc], quant_data->shift[oc]);
+                out[oc] = esp_nn_clamp_s8(acc + out_offset, activation_min, activation_max);
+            }
+        }
+    }
+}
+
+int esp_nn_get_depthwise_conv_scratch_size ( const data_dims_t *input_dims, const data_dims_t *filter_dims,
+                                             const data_dims_t *output_dims,
+                                             const dw_conv_params_t *conv_params ) {
+    return output_dims->channels * (int) sizeof(int32_t);
+}
+
+void esp_nn_set_depthwise_conv_scratch_buf ( void *buf ) {
+    depthwise_scratch = buf;
+}
+
+// acc[c] += (in[c] + in_offset) * filter[c]
+static inline void depthwise_accumulate ( int32_t *acc, const int8_t *in, const int8_t *filter,
+                                          int32_t in_offset, int channels ) {
+    int c = 0;
+#if defined(__AVX2__)
+    // |x + in_offset| <= 255 and |filter| <= 128, the product fits in 16 bits.
+    const __m256i offset = _mm256_set1_epi16((int16_t) in_offset);
+    for (; c + 16 <= channels; c += 16) {
+        const __m256i x = _mm256_add_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (in + c))), offset);
+        const __m256i w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (filter + c)));
+        const __m256i p = _mm256_mullo_epi16(x, w);
+        __m256i * a = (__m256i *) (acc + c);
+        _mm256_storeu_si256(a, _mm256_add_epi32(_mm256_loadu_si256(a), _mm256_cvtepi16_epi32(_mm256_castsi256_si128(p))));
+        _mm256_storeu_si256(a + 1, _mm256_add_epi32(_mm256_loadu_si256(a + 1), _mm256_cvtepi16_epi32(_mm256_extracti128_si256(p, 1))));
+    }
+#elif defined(__SSE4_1__)
+    const __m128i offset = _mm_set1_epi16((int16_t) in_offset);
+    for (; c + 8 <= channels; c += 8) {
+        const __m128i x = _mm_add_epi16(_mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (in + c))), offset);
+        const __m128i w = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (filter + c)));
+        const __m128i p = _mm_mullo_epi16(x, w);
+        __m128i * a = (__m128i *) (acc + c);
+        _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_cvtepi16_epi32(p)));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_cvtepi16_epi32(_mm_srli_si128(p, 8))));
+    }
+#endif
+    for (; c < channels; c++) {
+        acc[c] += ((int32_t) in[c] + in_offset) * filter[c];
+    }
+}
+
+void esp_nn_depthwise_conv_s8 ( const data_dims_t *input_dims, const int8_t *input_data,
+                                const data_dims_t *filter_dims, const int8_t *filter_data,
+                                const int32_t *bias, const data_dims_t *output_dims, int8_t *out_data,
+                                const dw_conv_params_t *conv_params, const quant_data_t *quant_data ) {
+    const int input_wd = input_dims->width;
+    const int input_ht = input_dims->height;
+    const int in_ch = input_dims->channels;
+    const int filter_wd = filter_dims->width;
+    const int filter_ht = filter_dims->height;
+    const int output_wd = output_dims->width;
+    const int output_ht = output_dims->height;
+    const int out_ch = output_dims->channels;
+    const int ch_mult = conv_params->ch_mult;
+    const int stride_wd = conv_params->stride.width;
+    const int stride_ht = conv_params->stride.height;
+    const int pad_wd = conv_params->padding.width;
+    const int pad_ht = conv_params->padding.height;
+    const int32_t in_offset = conv_params->in_offset;
+    const int32_t out_offset = conv_params->out_offset;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+
+    int32_t * acc = (int32_t *) depthwise_scratch;
+
+    for (int out_y = 0; out_y < output_ht; out_y++) {
+        const int in_y0 = out_y * stride_ht - pad_ht;
+        const int fy_start = in_y0 < 0 ? -in_y0 : 0;
+        const int fy_end = input_ht - in_y0 < filter_ht ? input_ht - in_y0 : filter_ht;
+        for (int out_x = 0; out_x < output_wd; out_x++) {
+            const int in_x0 = out_x * stride_wd - pad_wd;
+            const int fx_start = in_x0 < 0 ? -in_x0 : 0;
+            const int fx_end = input_wd - in_x0 < filter_wd ? input_wd - in_x0 : filter_wd;
+
+            if (bias) {
+                memcpy(acc, bias, out_ch * sizeof(int32_t));
+            } else {
+                memset(acc, 0, out_ch * sizeof(int32_t));
+            }
+
+            for (int fy = fy_start; fy < fy_end; fy++) {
+                for (int fx = fx_start; fx < fx_end; fx++) {
+                    const int8_t * in = input_data + ((in_y0 + fy) * input_wd + in_x0 + fx) * in_ch;
+                    const int8_t * filter = filter_data + (fy * filter_wd + fx) * out_ch;
+                    if (ch_mult == 1) {
+                        depthwise_accumulate(acc, in, filter, in_offset, in_ch);
+                    } else {
+                        for (int ic = 0; ic < in_ch; ic++) {
+                            const int32_t x = (int32_t) in[ic] + in_offset;
+                            for (int m = 0; m < ch_mult; m++) {
+                                acc[ic * ch_mult + m] += x * filter[ic * ch_mult + m];
+                            }
+                        }
+                    }
+                }
+            }
+
+            int8_t * out = out_data + (out_y * output_wd + out_x) * out_ch;
+            for (int oc = 0; oc < out_ch; oc++) {
+                const int32_t scaled = esp_nn_multiply_by_quantized_mult(acc[oc], quant_data->mult[oc], quant_data->shift[oc]);
+                out[oc] = esp_nn_clamp_s8(scaled + out_offset, activation_min, activation_max);
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+/********************************************************************************************
+* Portable esp-nn fully connected.
+*
+* sum((x + in_offset) * (w + filter_offset)) is expanded into an int8 dot product plus the
+* offset terms, so the inner loop runs four output channels over the input at a time.
+***********************************************************************************************/
+
+#include "esp_nn.h"
+#include "esp_nn_common.h"
+
+void esp_nn_fully_connected_s8 ( const int8_t *input_data, const int32_t input_offset,
+                                 const uint16_t row_len, const int8_t *filter_data,
+                                 const int32_t filter_offset, const int32_t *bias,
+                                 int8_t *out_data, const uint16_t out_channels,
+                                 const int32_t out_offset, const int32_t out_shift,
+                                 const int32_t out_mult, const int32_t activation_min,
+                                 const int32_t activation_max ) {
+    // Wraps around like the int32 accumulator of the reference would, if it did.
+    const uint32_t input_term = (uint32_t) (filter_offset * esp_nn_sum_s8(input_data, row_len)) +
+                                (uint32_t) row_len * (uint32_t) (input_offset * filter_offset);
+
+    int oc = 0;
+    for (; oc + 4 <= out_channels; oc += 4) {
+        const int8_t * filters[4] = {
+            filter_data + oc * row_len, filter_data + (oc + 1) * row_len,
+            filter_data + (oc + 2) * row_len, filter_data + (oc + 3) * row_len
+        };
+        int32_t sums[4];
+        esp_nn_dot_s8_x4(input_data, filters, row_len, sums);
+        for (int k = 0; k < 4; k++) {
+            uint32_t acc = (uint32_t) sums[k] + input_term +
+                           (uint32_t) (input_offset * esp_nn_sum_s8(filters[k], row_len));
+            if (bias) {acc += (uint32_t) bias[oc + k];}
+            const int32_t scaled = esp_nn_multiply_by_quantized_mult((int32_t) acc, out_mult, out_shift);
+            out_data[oc + k] = esp_nn_clamp_s8(scaled + out_offset, activation_min, activation_max);
+        }
+    }
+    for (; oc < out_channels; oc++) {
+        const int8_t * filter = filter_data + oc * row_len;
+        uint32_t acc = (uint32_t) esp_nn_dot_s8(input_data, filter, row_len) + input_term +
+                       (uint32_t) (input_offset * esp_nn_sum_s8(filter, row_len));
+        if (bias) {acc += (uint32_t) bias[oc];}
+        const int32_t scaled = esp_nn_multiply_by_quantized_mult((int32_t) acc, out_mult, out_shift);
+        out_data[oc] = esp_nn_clamp_s8(scaled + out_offset, activation_min, activation_max);
+    }
+}
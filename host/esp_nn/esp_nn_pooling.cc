@@ -0,0 +1,87 @@
+/********************************************************************************************
+* Portable esp-nn pooling.
+*
+* Both pools run over blocks of channels of one output pixel, so the loops over the
+* filter taps read contiguous channels and vectorize.
+***********************************************************************************************/
+
+#include "esp_nn.h"
+#include "esp_nn_common.h"
+
+#define POOL_CHANNEL_BLOCK 64
+
+void esp_nn_avg_pool_s8 ( const int8_t *input, const uint16_t input_wd, const uint16_t input_ht,
+                          int8_t *output, const uint16_t output_wd, const uint16_t output_ht,
+                          const uint16_t stride_wd, const uint16_t stride_ht,
+                          const uint16_t filter_wd, const uint16_t filter_ht,
+                          const uint16_t pad_wd, const uint16_t pad_ht,
+                          const int32_t activation_min, const int32_t activation_max,
+                          const uint16_t channels ) {
+    int32_t acc[POOL_CHANNEL_BLOCK];
+
+    for (int out_y = 0; out_y < output_ht; out_y++) {
+        const int in_y0 = out_y * stride_ht - pad_ht;
+        const int fy_start = in_y0 < 0 ? -in_y0 : 0;
+        const int fy_end = input_ht - in_y0 < filter_ht ? input_ht - in_y0 : filter_ht;
+        for (int out_x = 0; out_x < output_wd; out_x++) {
+            const int in_x0 = out_x * stride_wd - pad_wd;
+            const int fx_start = in_x0 < 0 ? -in_x0 : 0;
+            const int fx_end = input_wd - in_x0 < filter_wd ? input_wd - in_x0 : filter_wd;
+            const int count = (fy_end - fy_start) * (fx_end - fx_start);
+            int8_t * out = output + (out_y * output_wd + out_x) * channels;
+            if (count <= 0) {continue;}
+
+            for (int c0 = 0; c0 < channels; c0 += POOL_CHANNEL_BLOCK) {
+                const int block = channels - c0 < POOL_CHANNEL_BLOCK ? channels - c0 : POOL_CHANNEL_BLOCK;
+                for (int c = 0; c < block; c++) {acc[c] = 0;}
+                for (int fy = fy_start; fy < fy_end; fy++) {
+                    for (int fx = fx_start; fx < fx_end; fx++) {
+                        const int8_t * in = input + ((in_y0 + fy) * input_wd + in_x0 + fx) * channels + c0;
+                        for (int c = 0; c < block; c++) {acc[c] += in[c];}
+                    }
+                }
+                for (int c = 0; c < block; c++) {
+                    // Round to the closest integer value.
+                    const int32_t avg = acc[c] > 0 ? (acc[c] + count / 2) / count : (acc[c] - count / 2) / count;
+                    out[c0 + c] = esp_nn_clamp_s8(avg, activation_min, activation_max);
+                }
+            }
+        }
+    }
+}
+
+void esp_nn_max_pool_s8 ( const int8_t *input, const uint16_t input_wd, const uint16_t input_ht,
+                          int8_t *output, const uint16_t output_wd, const uint16_t output_ht,
+                          const uint16_t stride_wd, const uint16_t stride_ht,
+                          const uint16_t filter_wd, const uint16_t filter_ht,
+                          const uint16_t pad_wd, const uint16_t pad_ht,
+                          const int32_t activation_min, const int32_t activation_max,
+                          const uint16_t channels ) {
+    int8_t max[POOL_CHANNEL_BLOCK];
+
+    for (int out_y = 0; out_y < output_ht; out_y++) {
+        const int in_y0 = out_y * stride_ht - pad_ht;
+        const int fy_start = in_y0 < 0 ? -in_y0 : 0;
+        const int fy_end = input_ht - in_y0 < filter_ht ? input_ht - in_y0 : filter_ht;
+        for (int out_x = 0; out_x < output_wd; out_x++) {
+            const int in_x0 = out_x * stride_wd - pad_wd;
+            const int fx_start = in_x0 < 0 ? -in_x0 : 0;
+            const int fx_end = input_wd - in_x0 < filter_wd ? input_wd - in_x0 : filter_wd;
+            int8_t * out = output + (out_y * output_wd + out_x) * channels;
+
+            for (int c0 = 0; c0 < channels; c0 += POOL_CHANNEL_BLOCK) {
+                const int block = channels - c0 < POOL_CHANNEL_BLOCK ? channels - c0 : POOL_CHANNEL_BLOCK;
+                for (int c = 0; c < block; c++) {max[c] = INT8_MIN;}
+                for (int fy = fy_start; fy < fy_end; fy++) {
+                    for (int fx = fx_start; fx < fx_end; fx++) {
+                        const int8_t * in = input + ((in_y0 + fy) * input_wd + in_x0 + fx) * channels + c0;
+                        for (int c = 0; c < block; c++) {max[c] = in[c] > max[c] ? in[c] : max[c];}
+                    }
+                }
+                for (int c = 0; c < block; c++) {
+                    out[c0 + c] = esp_nn_clamp_s8(max[c], activation_min, activation_max);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/********************************************************************************************
+* Portable esp-nn softmax.
+*
+* Same fixed point arithmetic as reference_ops::Softmax, which evaluates the exponential of
+* every value twice (for the sum, then for the output). Here it is evaluated once and kept.
+***********************************************************************************************/
+
+#include "esp_nn.h"
+#include "esp_nn_common.h"
+
+#include "tensorflow/lite/kernels/internal/common.h"
+
+#define SOFTMAX_MAX_CACHED_WIDTH 256
+
+// The kernel sizes its scratch from dims that a 2D tensor does not have, so the
+// exponentials are kept on the stack instead.
+int32_t esp_nn_get_softmax_scratch_size ( const int32_t width, const int32_t height ) {
+    return 0;
+}
+
+void esp_nn_set_softmax_scratch_buf ( void *buffer ) {
+}
+
+void esp_nn_softmax_s8 ( const int8_t *input_data, const int32_t height, const int32_t width,
+                         const int32_t mult, const int32_t shift, const int32_t diff_min,
+                         int8_t *output_data ) {
+    static const int kScaledDiffIntegerBits = 5;
+    static const int kAccumulationIntegerBits = 12;
+    using FixedPointScaledDiff = gemmlowp::FixedPoint<int32_t, kScaledDiffIntegerBits>;
+    using FixedPointAccum = gemmlowp::FixedPoint<int32_t, kAccumulationIntegerBits>;
+    using FixedPoint0 = gemmlowp::FixedPoint<int32_t, 0>;
+
+    int32_t exps[SOFTMAX_MAX_CACHED_WIDTH];
+    const bool cached = width <= SOFTMAX_MAX_CACHED_WIDTH;
+
+    for (int i = 0; i < height; i++) {
+        const int8_t * in = input_data + i * width;
+        int8_t * out = output_data + i * width;
+
+        int8_t max_in_row = INT8_MIN;
+        for (int c = 0; c < width; c++) {max_in_row = in[c] > max_in_row ? in[c] : max_in_row;}
+
+        FixedPointAccum sum_of_exps = FixedPointAccum::Zero();
+        for (int c = 0; c < width; c++) {
+            const int32_t input_diff = (int32_t) in[c] - max_in_row;
+            if (input_diff >= diff_min) {
+                const int32_t input_diff_rescaled =
+                    tflite::MultiplyByQuantizedMultiplierGreaterThanOne(input_diff, mult, shift);
+                const FixedPoint0 exp_in_0 =
+                    gemmlowp::exp_on_negative_values(FixedPointScaledDiff::FromRaw(input_diff_rescaled));
+                if (cached) {exps[c] = exp_in_0.raw();}
+                sum_of_exps = sum_of_exps + gemmlowp::Rescale<kAccumulationIntegerBits>(exp_in_0);
+            }
+        }
+
+        int num_bits_over_unit;
+        const FixedPoint0 shifted_scale = FixedPoint0::FromRaw(
+            tflite::GetReciprocal(sum_of_exps.raw(), kAccumulationIntegerBits, &num_bits_over_unit));
+
+        for (int c = 0; c < width; c++) {
+            const int32_t input_diff = (int32_t) in[c] - max_in_row;
+            if (input_diff >= diff_min) {
+                FixedPoint0 exp_in_0;
+                if (cached) {
+                    exp_in_0 = FixedPoint0::FromRaw(exps[c]);
+                } else {
+                    const int32_t input_diff_rescaled =
+                        tflite::MultiplyByQuantizedMultiplierGreaterThanOne(input_diff, mult, shift);
+                    exp_in_0 = gemmlowp::exp_on_negative_values(FixedPointScaledDiff::FromRaw(input_diff_rescaled));
+                }
+                const int32_t unsat_output = gemmlowp::RoundingDivideByPOT(
+                    (shifted_scale * exp_in_0).raw(), num_bits_over_unit + 31 - 8);
+                out[c] = esp_nn_clamp_s8(unsat_output + INT8_MIN, INT8_MIN, INT8_MAX);
+            } else {
+                out[c] = INT8_MIN;
+            }
+        }
+    }
+}
@@ -0,0 +1,18 @@
+/********************************************************************************************
+* Host implementation of the command responder.
+*
+* There are no LEDs or buzzers on a workstation, commands are only logged.
+***********************************************************************************************/
+
+#include "esp_log.h"
+
+#include "ges_iavoz_command_responder.h"
+
+static const char * RESPONDER_TAG = "IAVOZ_RESPONDER";
+
+void RespondToCommand(IAVOZ_KEY_t found_command) {
+    ESP_LOGI(RESPONDER_TAG, "Responding to command: %d", found_command);
+}
+
+void initCommandResponder() {
+}
@@ -0,0 +1,245 @@
+/********************************************************************************************
+* iavoz_eval: multi-threaded offline evaluation over a labelled WAV corpus.
+*
+* Usage: iavoz_eval [-j workers] [-s step_ms] [-o report.json] corpus_dir
+*
+* The corpus is laid out as for iavoz_rtf_bench. Every worker thread runs its own system
+* (interpreter, tensor arena, frontend and recognizer) over the shared read-only model and
+* takes the next file from a shared queue until the corpus is exhausted, so a shard of long
+* files does not hold up the others. Each file is evaluated on its own, from a reset
+* system, so the results do not depend on the number of workers or on which one ran it.
+* Detection metrics per keyword and the step latency of all workers are merged into one
+* JSON report. -j defaults to the number of cores.
+***********************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "esp_timer.h"
+#include "iavoz_host.h"
+
+static const char * TAG = "IAVOZ_EVAL";
+
+// Step latency histogram buckets, bucket b counts the steps of [2^b, 2^(b+1)) us.
+static constexpr int kLatencyBuckets = 24;
+
+struct EvalWorker {
+    IAVoz_System_t * sys;
+    std::thread thread;
+
+    std::vector<uint32_t> step_us;
+    uint32_t latency_buckets[kLatencyBuckets];
+    int64_t audio_ms;
+    int invocations;
+    int failed_files;
+    int detections;
+    int false_alarms;
+    int keyword_files[IAVOZ_NUM_KEYS];
+    int keyword_hits[IAVOZ_NUM_KEYS];
+
+    const IAVoz_HostUtterance_t * current;
+    int current_hit;
+};
+
+struct EvalQueue {
+    const std::vector<IAVoz_HostUtterance_t> * utterances;
+    std::atomic<size_t> next;
+    int32_t step_ms;
+};
+
+static void EvalActivation ( EvalWorker * worker, IAVOZ_KEY_t key ) {
+    worker->detections++;
+    if (worker->current->label != IAVOZ_KEY_NULL && key == worker->current->label) {
+        worker->current_hit = 1;
+    } else {
+        worker->false_alarms++;
+    }
+}
+
+static void EvalStepHook ( IAVoz_System_t * sys, int32_t, int, void * user ) {
+    EvalWorker * worker = (EvalWorker *) user;
+    uint32_t step_us = sys->timings.step_us;
+    worker->step_us.push_back(step_us);
+
+    int bucket = 0;
+    while (bucket < kLatencyBuckets - 1 && step_us >> (bucket + 1)) {bucket++;}
+    worker->latency_buckets[bucket]++;
+
+    if (sys->timings.invoked) {worker->invocations++;}
+    if (sys->activation != IAVOZ_KEY_NULL) {EvalActivation(worker, sys->activation);}
+}
+
+static void EvalWorkerRun ( EvalWorker * worker, EvalQueue * queue ) {
+    for (;;) {
+        size_t index = queue->next.fetch_add(1);
+        if (index >= queue->utterances->size()) {break;}
+        const IAVoz_HostUtterance_t & utterance = (*queue->utterances)[index];
+
+        worker->current = &utterance;
+        worker->current_hit = 0;
+        if (!IAVoz_System_Reset(worker->sys) ||
+            !IAVoz_Host_RunWav(worker->sys, utterance.path.c_str(), queue->step_ms, EvalStepHook, worker)) {
+            worker->failed_files++;
+            continue;
+        }
+        worker->audio_ms += LatestAudioTimestamp(worker->sys->ap);
+
+        if (utterance.label != IAVOZ_KEY_NULL) {
+            worker->keyword_files[utterance.label]++;
+            worker->keyword_hits[utterance.label] += worker->current_hit;
+        }
+    }
+}
+
+int main ( int argc, char ** argv ) {
+    int workers = (int) std::thread::hardware_concurrency();
+    int32_t step_ms = kFeatureSliceStrideMs * 5;
+    const char * report_path = NULL;
+    int arg = 1;
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-j") && arg + 1 < argc) {
+            workers = atoi(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-s") && arg + 1 < argc) {
+            step_ms = atoi(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-o") && arg + 1 < argc) {
+            report_path = argv[++arg];
+        } else {
+            break;
+        }
+    }
+    if (workers <= 0) {workers = 1;}
+
+    if (arg != argc - 1 || step_ms <= 0 || step_ms % kFeatureSliceStrideMs) {
+        fprintf(stderr, "usage: %s [-j workers] [-s step_ms] [-o report.json] corpus_dir\n", argv[0]);
+        return 2;
+    }
+
+    std::string corpus = argv[arg];
+    std::vector<IAVoz_HostUtterance_t> utterances = IAVoz_Host_ListCorpus(corpus);
+    if (utterances.empty()) {
+        ESP_LOGE(TAG, "No WAV files found under %s", corpus.c_str());
+        return 1;
+    }
+    if ((size_t) workers > utterances.size()) {workers = (int) utterances.size();}
+
+    std::vector<EvalWorker> pool(workers);
+    for (EvalWorker & worker : pool) {
+        worker.sys = NULL;
+        memset(worker.latency_buckets, 0, sizeof(worker.latency_buckets));
+        worker.audio_ms = 0;
+        worker.invocations = 0;
+        worker.failed_files = 0;
+        worker.detections = 0;
+        worker.false_alarms = 0;
+        memset(worker.keyword_files, 0, sizeof(worker.keyword_files));
+        memset(worker.keyword_hits, 0, sizeof(worker.keyword_hits));
+        worker.current = NULL;
+        worker.current_hit = 0;
+
+        if (!IAVoz_System_Init(&worker.sys, &IAVoz_HostModelSettings, IAVoz_Host_NullCallback)) {
+            ESP_LOGE(TAG, "System init failed");
+            return 1;
+        }
+    }
+
+    EvalQueue queue;
+    queue.utterances = &utterances;
+    queue.next = 0;
+    queue.step_ms = step_ms;
+
+    int64_t start = esp_timer_get_time();
+    for (EvalWorker & worker : pool) {worker.thread = std::thread(EvalWorkerRun, &worker, &queue);}
+    for (EvalWorker & worker : pool) {worker.thread.join();}
+    int64_t wall_us = esp_timer_get_time() - start;
+
+    // Merge the workers.
+    std::vector<uint32_t> step_us;
+    uint32_t latency_buckets[kLatencyBuckets] = {0};
+    int64_t audio_ms = 0;
+    int invocations = 0, failed_files = 0, detections = 0, false_alarms = 0;
+    int keyword_files[IAVOZ_NUM_KEYS] = {0}, keyword_hits[IAVOZ_NUM_KEYS] = {0};
+    for (EvalWorker & worker : pool) {
+        step_us.insert(step_us.end(), worker.step_us.begin(), worker.step_us.end());
+        for (int b = 0; b < kLatencyBuckets; b++) {latency_buckets[b] += worker.latency_buckets[b];}
+        audio_ms += worker.audio_ms;
+        invocations += worker.invocations;
+        failed_files += worker.failed_files;
+        detections += worker.detections;
+        false_alarms += worker.false_alarms;
+        for (int key = 0; key < IAVOZ_NUM_KEYS; key++) {
+            keyword_files[key] += worker.keyword_files[key];
+            keyword_hits[key] += worker.keyword_hits[key];
+        }
+        IAVoz_System_DeInit(worker.sys);
+    }
+    std::sort(step_us.begin(), step_us.end());
+
+    int64_t pipeline_us = 0;
+    for (uint32_t v : step_us) {pipeline_us += v;}
+    double audio_hours = audio_ms / 3600000.0;
+
+    int total_keyword_files = 0, total_keyword_hits = 0;
+    for (int key = 0; key < IAVOZ_NUM_KEYS; key++) {
+        total_keyword_files += keyword_files[key];
+        total_keyword_hits += keyword_hits[key];
+    }
+
+    FILE * out = report_path ? fopen(report_path, "w") : stdout;
+    if (!out) {
+        ESP_LOGE(TAG, "Could not open %s", report_path);
+        return 1;
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"corpus\": \"%s\",\n", corpus.c_str());
+    fprintf(out, "  \"files\": %zu,\n", utterances.size());
+    fprintf(out, "  \"failed_files\": %d,\n", failed_files);
+    fprintf(out, "  \"workers\": %d,\n", workers);
+    fprintf(out, "  \"step_ms\": %d,\n", step_ms);
+    fprintf(out, "  \"audio_seconds\": %.3f,\n", audio_ms / 1000.0);
+    fprintf(out, "  \"wall_seconds\": %.3f,\n", wall_us / 1e6);
+    fprintf(out, "  \"audio_hours_per_minute\": %.3f,\n", wall_us ? audio_hours / (wall_us / 6e7) : 0.0);
+    fprintf(out, "  \"real_time_factor\": %.5f,\n", audio_ms ? (pipeline_us / 1000.0) / audio_ms : 0.0);
+    fprintf(out, "  \"invocations\": %d,\n", invocations);
+    fprintf(out, "  \"step\": {\"count\": %zu, \"p50_us\": %u, \"p95_us\": %u, \"p99_us\": %u, \"max_us\": %u},\n",
+            step_us.size(), IAVoz_Host_Percentile(step_us, 50), IAVoz_Host_Percentile(step_us, 95), IAVoz_Host_Percentile(step_us, 99),
+            step_us.empty() ? 0 : step_us.back());
+    fprintf(out, "  \"step_histogram_us\": {");
+    bool first = true;
+    for (int b = 0; b < kLatencyBuckets; b++) {
+        if (!latency_buckets[b]) {continue;}
+        fprintf(out, "%s\"%u\": %u", first ? "" : ", ", b ? 1u << b : 0u, latency_buckets[b]);
+        first = false;
+    }
+    fprintf(out, "},\n");
+    fprintf(out, "  \"detections\": %d,\n", detections);
+    fprintf(out, "  \"false_alarms\": %d,\n", false_alarms);
+    fprintf(out, "  \"false_alarms_per_hour\": %.2f,\n", audio_hours > 0 ? false_alarms / audio_hours : 0.0);
+    fprintf(out, "  \"keywords\": {");
+    first = true;
+    for (int key = IAVOZ_KEY_HEYLOLA; key < IAVOZ_NUM_KEYS; key++) {
+        if (!keyword_files[key]) {continue;}
+        fprintf(out, "%s\n    \"%s\": {\"files\": %d, \"hits\": %d, \"hit_rate\": %.4f}", first ? "" : ",",
+                IAVoz_HostKeyNames[key], keyword_files[key], keyword_hits[key], (double) keyword_hits[key] / keyword_files[key]);
+        first = false;
+    }
+    fprintf(out, "%s},\n", first ? "" : "\n  ");
+    fprintf(out, "  \"keyword_files\": %d,\n", total_keyword_files);
+    fprintf(out, "  \"keyword_hits\": %d,\n", total_keyword_hits);
+    fprintf(out, "  \"keyword_hit_rate\": %.4f\n", total_keyword_files ? (double) total_keyword_hits / total_keyword_files : 0.0);
+    fprintf(out, "}\n");
+
+    if (report_path) {fclose(out);}
+
+    return failed_files ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+/********************************************************************************************
+* iavoz_filterbank_gen: writes the precomputed mel filterbank header of the feature provider.
+*
+* Usage: iavoz_filterbank_gen [-c channels] [-l lower_hz] [-u upper_hz] > ges_iavoz_filterbank_table.h
+*
+* Builds the filterbank the way FrontendPopulateState does at runtime, for the window,
+* sample rate and channels of model_settings.h and the band limits of InitializeMicroFeatures
+* (or the given ones), and prints it as a FilterbankTable: the padding of the runtime layout
+* is dropped, so every channel is a run of contiguous bins with one weight each.
+***********************************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "esp_log.h"
+#include "model_settings.h"
+
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend_util.h"
+
+static const char * TAG = "IAVOZ_FB_GEN";
+
+static void PrintArray ( const char * name, const std::vector<int16_t> & values ) {
+    printf("static const int16_t %s[%zu] = {", name, values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        printf("%s%d,", i % 12 ? " " : "\n    ", values[i]);
+    }
+    printf("\n};\n\n");
+}
+
+int main ( int argc, char ** argv ) {
+    int num_channels = kFeatureSliceSize;
+    float lower_band_limit = 125.0;
+    float upper_band_limit = 7500.0;
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-c") && arg + 1 < argc) {
+            num_channels = atoi(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-l") && arg + 1 < argc) {
+            lower_band_limit = atof(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-u") && arg + 1 < argc) {
+            upper_band_limit = atof(argv[++arg]);
+        } else {
+            break;
+        }
+    }
+    if (arg != argc || num_channels <= 0) {
+        fprintf(stderr, "usage: %s [-c channels] [-l lower_hz] [-u upper_hz]\n", argv[0]);
+        return 2;
+    }
+
+    FrontendConfig config;
+    FrontendFillConfigWithDefaults(&config);
+    config.window.size_ms = kFeatureSliceDurationMs;
+    config.window.step_size_ms = kFeatureSliceStrideMs;
+    config.filterbank.num_channels = num_channels;
+    config.filterbank.lower_band_limit = lower_band_limit;
+    config.filterbank.upper_band_limit = upper_band_limit;
+
+    FrontendState state;
+    if (!FrontendPopulateState(&config, &state, kAudioSampleFrequency)) {
+        ESP_LOGE(TAG, "FrontendPopulateState() failed");
+        return 1;
+    }
+    const FilterbankState & fb = state.filterbank;
+    const int spectrum_size = state.fft.fft_size / 2 + 1;
+
+    // The runtime layout pads every channel with zero weights out to aligned blocks,
+    // a bin of a channel always has a nonzero weight or unweight.
+    std::vector<int16_t> widths, weights, unweights;
+    int bin = fb.start_index;
+    for (int chan = 0; chan <= fb.num_channels; chan++) {
+        int width = 0;
+        for (int j = 0; j < fb.channel_widths[chan]; j++) {
+            const int16_t weight = fb.weights[fb.channel_weight_starts[chan] + j];
+            const int16_t unweight = fb.unweights[fb.channel_weight_starts[chan] + j];
+            if (!weight && !unweight) {continue;}
+            if (fb.channel_frequency_starts[chan] + j != bin) {
+                ESP_LOGE(TAG, "Channel %d does not start at bin %d", chan, bin);
+                return 1;
+            }
+            weights.push_back(weight);
+            unweights.push_back(unweight);
+            bin++;
+            width++;
+        }
+        widths.push_back(width);
+    }
+    if (bin != fb.end_index) {
+        ESP_LOGE(TAG, "Channels end at bin %d instead of %d", bin, fb.end_index);
+        return 1;
+    }
+
+    printf("// Generated by iavoz_filterbank_gen, do not edit: %d channels over %.9g-%.9g Hz,\n"
+           "// %d Hz audio, %d spectrum bins.\n\n", num_channels, lower_band_limit, upper_band_limit,
+           kAudioSampleFrequency, spectrum_size);
+    printf("#ifndef GES_IAVOZ_FILTERBANK_TABLE_H\n#define GES_IAVOZ_FILTERBANK_TABLE_H\n\n");
+    printf("#include \"tensorflow/lite/experimental/microfrontend/lib/filterbank.h\"\n\n");
+    PrintArray("kIAVozFilterbankChannelWidths", widths);
+    PrintArray("kIAVozFilterbankWeights", weights);
+    PrintArray("kIAVozFilterbankUnweights", unweights);
+    printf("static const struct FilterbankTable kIAVozFilterbankTable = {\n"
+           "    %d, %d, %d, %#.9gf, %#.9gf, %d, %d,\n"
+           "    kIAVozFilterbankChannelWidths, kIAVozFilterbankWeights, kIAVozFilterbankUnweights,\n"
+           "};\n\n", kAudioSampleFrequency, spectrum_size, num_channels, lower_band_limit, upper_band_limit,
+           fb.start_index, fb.end_index);
+    printf("#endif\n");
+
+    FrontendFreeStateContents(&state);
+    return 0;
+}
@@ -0,0 +1,598 @@
+/********************************************************************************************
+* iavoz_frontend_bench: optimized microfrontend kernels against the reference ones.
+*
+* Usage: iavoz_frontend_bench [-n repeats] [file.wav ...]
+*
+* Runs the frontend stage by stage over synthetic audio (tones, noise, silence and full
+* scale clipping) and the given 16 kHz WAV files, feeding the window, FFT and energy
+* stages to their Reference and Optimized kernels from frontend_kernels.h and comparing the
+* outputs bit for bit. The energy and filterbank fused over the table of ges_iavoz_filterbank_table.h are
+* checked against the reference pair the same way, which also catches a stale table.
+* Random inputs over the full range of each stage are checked too. Then every kernel
+* is timed over the recorded stage inputs, keeping the best of n passes. The lookup table square root and
+* log (FilterbankConfig.lut_sqrt, LogScaleConfig.lut_log) are not exact: their largest
+* error against the exact ones is reported as a share of the documented bound. The int8
+* output of FrontendProcessFramesInt8 is checked against the division the feature provider
+* used to quantize FrontendProcessFrames with, for every 16 bit value and over the audio,
+* and both are timed per frame.
+* Exits with 1 on any mismatch or error over the bound.
+***********************************************************************************************/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ges_iavoz_filterbank_table.h"
+#include "model_settings.h"
+
+#include "tensorflow/lite/experimental/microfrontend/lib/bits.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend_kernels.h"
+#include "tensorflow/lite/experimental/microfrontend/lib/frontend_util.h"
+
+static const char * TAG = "IAVOZ_FRONTEND";
+
+static constexpr int kRandomRounds = 2000;
+
+// Quantization of the input of the deployed model.
+static constexpr float kInputScale = 1.0f / 256;
+static constexpr int kInputZeroPoint = -128;
+// Another model input quantization, for the general multiplier and shift of LogScaleQuantize.
+static constexpr float kOtherInputScale = 0.1f;
+static constexpr int kOtherInputZeroPoint = -20;
+// The divisor the feature provider quantized the frontend output with.
+static constexpr int32_t kValueDiv = static_cast<int32_t>((25.6f * 26.0f) + 0.5f);
+
+enum Stage {
+    kStageWindow,
+    kStageFft,
+    kStageEnergy,
+    kStageFused,
+    kStageCount,
+};
+
+enum LutStage {
+    kLutSqrt,
+    kLutLog,
+    kLutCount,
+};
+
+static const char * kLutNames[] = {"sqrt", "log"};
+
+// The largest error as a share of the bound, over_bound counts the errors above it.
+struct LutErrors {
+    double worst[kLutCount];
+    int over_bound[kLutCount];
+};
+
+static void AddLutError ( LutErrors * errors, LutStage stage, uint32_t a, uint32_t b, uint32_t bound ) {
+    const uint32_t error = a > b ? a - b : b - a;
+    if ((double) error / bound > errors->worst[stage]) {errors->worst[stage] = (double) error / bound;}
+    errors->over_bound[stage] += error > bound;
+}
+
+static const char * kStageNames[] = {"window", "fft", "energy", "energy+filterbank"};
+
+static uint32_t NextRandom ( uint32_t * seed ) {
+    *seed = *seed * 1664525 + 1013904223;
+    return *seed;
+}
+
+// Random values with a random number of significant bits, so that small and large
+// magnitudes are both covered.
+static uint32_t NextRandomMagnitude ( uint32_t * seed ) {
+    uint32_t bits = NextRandom(seed) % 33;
+    uint32_t value = NextRandom(seed) ^ (NextRandom(seed) << 16);
+    return bits == 32 ? value : value & ((1u << bits) - 1);
+}
+
+static bool PopulateState ( FrontendState * state, const FilterbankTable * table,
+                            float input_scale = kInputScale, int input_zero_point = kInputZeroPoint ) {
+    // Same configuration as InitializeMicroFeatures.
+    FrontendConfig config;
+    config.window.size_ms = kFeatureSliceDurationMs;
+    config.window.step_size_ms = kFeatureSliceStrideMs;
+    config.filterbank.num_channels = kFeatureSliceSize;
+    config.filterbank.lower_band_limit = 125.0;
+    config.filterbank.upper_band_limit = 7500.0;
+    config.filterbank.table = table;
+    config.filterbank.lut_sqrt = 0;
+    config.noise_reduction.smoothing_bits = 10;
+    config.noise_reduction.even_smoothing = 0.025;
+    config.noise_reduction.odd_smoothing = 0.06;
+    config.noise_reduction.min_signal_remaining = 0.05;
+    config.pcan_gain_control.enable_pcan = 1;
+    config.pcan_gain_control.strength = 0.95;
+    config.pcan_gain_control.offset = 80.0;
+    config.pcan_gain_control.gain_bits = 21;
+    config.log_scale.enable_log = 1;
+    config.log_scale.scale_shift = 6;
+    config.log_scale.lut_log = 0;
+    config.log_scale.int8_step = kValueDiv * input_scale;
+    config.log_scale.int8_zero_point = input_zero_point;
+    config.voice_activity.enable_vad = 0;
+    return FrontendPopulateState(&config, state, kAudioSampleFrequency);
+}
+
+static void AppendSynthetic ( std::vector<int16_t> & audio ) {
+    uint32_t seed = 0xf00dcafe;
+    const int second = kAudioSampleFrequency;
+
+    // Silence, quiet noise, a sweep getting louder, then a clipped square wave.
+    audio.insert(audio.end(), second / 2, 0);
+    for (int i = 0; i < second; i++) {audio.push_back((int16_t) ((int32_t) (NextRandom(&seed) >> 16) % 64 - 32));}
+    for (int i = 0; i < 2 * second; i++) {
+        int32_t period = 8 + i / 400;
+        int32_t amplitude = 200 + i / 3;
+        int32_t noise = (int32_t) (NextRandom(&seed) >> 22) - 512;
+        int32_t sample = ((i % period) < period / 2 ? amplitude : -amplitude) + noise;
+        audio.push_back((int16_t) (sample > 32767 ? 32767 : sample < -32768 ? -32768 : sample));
+    }
+    for (int i = 0; i < second / 2; i++) {audio.push_back((i / 20) % 2 ? 32767 : -32768);}
+}
+
+// Appends the samples of a 16 bit PCM mono WAV file.
+static bool AppendWav ( std::vector<int16_t> & audio, const char * path ) {
+    FILE * f = fopen(path, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Cannot open %s", path);
+        return false;
+    }
+
+    uint8_t header[12];
+    bool ok = fread(header, 1, 12, f) == 12 && !memcmp(header, "RIFF", 4) && !memcmp(header + 8, "WAVE", 4);
+    while (ok) {
+        uint8_t chunk[8];
+        if (fread(chunk, 1, 8, f) != 8) {ok = false; break;}
+        uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t) chunk[7] << 24);
+        if (!memcmp(chunk, "data", 4)) {
+            std::vector<uint8_t> data(size);
+            size = fread(data.data(), 1, size, f);
+            for (uint32_t i = 0; i + 1 < size; i += 2) {audio.push_back((int16_t) (data[i] | (data[i + 1] << 8)));}
+            break;
+        }
+        fseek(f, size + (size & 1), SEEK_CUR);
+    }
+    fclose(f);
+
+    if (!ok) {ESP_LOGE(TAG, "%s is not a PCM WAV file", path);}
+    return ok;
+}
+
+// The inputs every stage saw on the reference path, one entry per frame.
+struct StageInputs {
+    std::vector<const int16_t *> frames;
+    std::vector<std::vector<int16_t>> windowed;
+    std::vector<int> input_shift;
+    std::vector<std::vector<complex_int16_t>> fft;
+    std::vector<std::vector<uint64_t>> work;
+    std::vector<std::vector<uint32_t>> filterbank;
+    std::vector<std::vector<uint32_t>> gained;
+    std::vector<int> correction_bits;
+};
+
+// Runs the frontend over audio in both states, comparing every stage. Returns the
+// mismatches per stage and records the reference stage inputs.
+static void CheckFrames ( FrontendState * ref, FrontendState * opt, FrontendState * tab, const std::vector<int16_t> & audio,
+                          StageInputs * inputs, int mismatches[kStageCount] ) {
+    const size_t window_size = ref->window.size;
+    const size_t step = ref->window.step;
+    const int num_channels = ref->filterbank.num_channels;
+    const size_t spectrum_size = ref->fft.fft_size / 2 + 1;
+    const int start = ref->filterbank.start_index;
+    const int end = ref->filterbank.end_index;
+
+    std::vector<complex_int16_t> ref_energy(spectrum_size), opt_energy(spectrum_size);
+    std::vector<uint32_t> signal(num_channels);
+
+    for (size_t offset = 0; offset + window_size <= audio.size(); offset += step) {
+        const int16_t * frame = audio.data() + offset;
+        inputs->frames.push_back(frame);
+
+        WindowApplyReference(&ref->window, frame);
+        WindowApplyOptimized(&opt->window, frame);
+        mismatches[kStageWindow] += ref->window.max_abs_output_value != opt->window.max_abs_output_value ||
+                                    memcmp(ref->window.output, opt->window.output, window_size * sizeof(int16_t));
+
+        int input_shift = 15 - MostSignificantBit32(ref->window.max_abs_output_value);
+        inputs->windowed.emplace_back(ref->window.output, ref->window.output + window_size);
+        inputs->input_shift.push_back(input_shift);
+        FftComputeReference(&ref->fft, ref->window.output, input_shift);
+        FftComputeOptimized(&opt->fft, ref->window.output, input_shift);
+        mismatches[kStageFft] += memcmp(ref->fft.output, opt->fft.output, spectrum_size * sizeof(complex_int16_t)) != 0;
+        inputs->fft.emplace_back(ref->fft.output, ref->fft.output + spectrum_size);
+
+        // In place, as FrontendProcessWindow runs it.
+        ref_energy = inputs->fft.back();
+        opt_energy = inputs->fft.back();
+        FilterbankConvertFftComplexToEnergyReference(&ref->filterbank, ref_energy.data(), (int32_t *) ref_energy.data());
+        FilterbankConvertFftComplexToEnergyOptimized(&opt->filterbank, opt_energy.data(), (int32_t *) opt_energy.data());
+        const int32_t * energy = (const int32_t *) ref_energy.data();
+        mismatches[kStageEnergy] += memcmp(energy + start, (const int32_t *) opt_energy.data() + start, (end - start) * sizeof(int32_t)) != 0;
+
+        FilterbankAccumulateChannels(&ref->filterbank, energy);
+        FilterbankAccumulateSpectrum(&tab->filterbank, inputs->fft.back().data());
+        mismatches[kStageFused] += memcmp(ref->filterbank.work, tab->filterbank.work, (num_channels + 1) * sizeof(uint64_t)) != 0;
+
+        inputs->work.emplace_back(ref->filterbank.work + 1, ref->filterbank.work + 1 + num_channels);
+        const uint32_t * scaled = FilterbankSqrt(&ref->filterbank, input_shift);
+        inputs->filterbank.emplace_back(scaled, scaled + num_channels);
+
+        signal = inputs->filterbank.back();
+        NoiseReductionApply(&ref->noise_reduction, signal.data());
+        PcanGainControlApply(&ref->pcan_gain_control, signal.data());
+        inputs->gained.push_back(signal);
+
+        int correction_bits = MostSignificantBit32(ref->fft.fft_size) - 1 - (kFilterbankBits / 2);
+        inputs->correction_bits.push_back(correction_bits);
+    }
+}
+
+// Random inputs over the whole range of every stage.
+static void CheckRandom ( FrontendState * ref, FrontendState * opt, FrontendState * tab, int mismatches[kStageCount] ) {
+    uint32_t seed = 0x1234abcd;
+    const size_t window_size = ref->window.size;
+    const int num_channels = ref->filterbank.num_channels;
+    const size_t spectrum_size = ref->fft.fft_size / 2 + 1;
+    const int start = ref->filterbank.start_index;
+    const int end = ref->filterbank.end_index;
+
+    std::vector<int16_t> frame(window_size);
+    std::vector<complex_int16_t> ref_energy(spectrum_size), opt_energy(spectrum_size), spectrum(spectrum_size);
+
+    for (int round = 0; round < kRandomRounds; round++) {
+        for (int16_t & s : frame) {s = (int16_t) (round % 8 == 0 ? ((NextRandom(&seed) >> 31) ? 32767 : -32768) : NextRandom(&seed) >> 16);}
+        WindowApplyReference(&ref->window, frame.data());
+        WindowApplyOptimized(&opt->window, frame.data());
+        mismatches[kStageWindow] += ref->window.max_abs_output_value != opt->window.max_abs_output_value ||
+                                    memcmp(ref->window.output, opt->window.output, window_size * sizeof(int16_t));
+
+        // Any shift, including the ones that wrap the scaled input.
+        int input_shift = (int) (NextRandom(&seed) % 16);
+        for (int16_t & s : frame) {s = (int16_t) (round % 8 == 0 ? -32768 : NextRandomMagnitude(&seed));}
+        FftComputeReference(&ref->fft, frame.data(), input_shift);
+        FftComputeOptimized(&opt->fft, frame.data(), input_shift);
+        mismatches[kStageFft] += memcmp(ref->fft.output, opt->fft.output, spectrum_size * sizeof(complex_int16_t)) != 0;
+
+        for (complex_int16_t & c : ref_energy) {
+            c.real = (int16_t) (round % 8 == 0 ? -32768 : NextRandom(&seed) >> 16);
+            c.imag = (int16_t) (round % 8 == 0 ? -32768 : NextRandom(&seed) >> 16);
+        }
+        opt_energy = ref_energy;
+        spectrum = ref_energy;
+        FilterbankConvertFftComplexToEnergyReference(&ref->filterbank, ref_energy.data(), (int32_t *) ref_energy.data());
+        FilterbankConvertFftComplexToEnergyOptimized(&opt->filterbank, opt_energy.data(), (int32_t *) opt_energy.data());
+        mismatches[kStageEnergy] += memcmp((int32_t *) ref_energy.data() + start, (int32_t *) opt_energy.data() + start,
+                                           (end - start) * sizeof(int32_t)) != 0;
+
+        FilterbankAccumulateChannels(&ref->filterbank, (const int32_t *) ref_energy.data());
+        FilterbankAccumulateSpectrum(&tab->filterbank, spectrum.data());
+        mismatches[kStageFused] += memcmp(ref->filterbank.work, tab->filterbank.work, (num_channels + 1) * sizeof(uint64_t)) != 0;
+    }
+}
+
+// Square roots of values, in blocks of num_channels, with the exact and the lookup table
+// FilterbankSqrt. The bound is 1 + exact / 2^16.
+static void CheckSqrtLut ( FilterbankState * fb, const std::vector<uint64_t> & values, LutErrors * errors ) {
+    const size_t num_channels = fb->num_channels;
+    std::vector<uint32_t> exact(num_channels);
+
+    for (size_t base = 0; base < values.size(); base += num_channels) {
+        const size_t count = values.size() - base < num_channels ? values.size() - base : num_channels;
+        memcpy(fb->work + 1, values.data() + base, count * sizeof(uint64_t));
+        fb->lut_sqrt = 0;
+        memcpy(exact.data(), FilterbankSqrt(fb, 0), count * sizeof(uint32_t));
+        memcpy(fb->work + 1, values.data() + base, count * sizeof(uint64_t));
+        fb->lut_sqrt = 1;
+        const uint32_t * lut = FilterbankSqrt(fb, 0);
+
+        for (size_t i = 0; i < count; i++) {AddLutError(errors, kLutSqrt, lut[i], exact[i], 1 + (exact[i] >> 16));}
+    }
+    fb->lut_sqrt = 0;
+}
+
+// Logs of one block of values with the exact and the lookup table LogScaleApply. The
+// bound is 1.
+static void CheckLogLut ( LogScaleState * log_scale, const uint32_t * values, int count, int correction_bits,
+                          LutErrors * errors ) {
+    std::vector<uint32_t> exact_signal(values, values + count), lut_signal(values, values + count);
+    log_scale->lut_log = 0;
+    const uint16_t * exact = LogScaleApply(log_scale, exact_signal.data(), count, correction_bits);
+    log_scale->lut_log = 1;
+    const uint16_t * lut = LogScaleApply(log_scale, lut_signal.data(), count, correction_bits);
+    log_scale->lut_log = 0;
+
+    for (int i = 0; i < count; i++) {AddLutError(errors, kLutLog, lut[i], exact[i], 1);}
+}
+
+// The recorded frames, random values of every magnitude and the powers of two with their
+// neighbours.
+static void CheckLut ( FrontendState * state, const StageInputs & inputs, LutErrors * errors ) {
+    uint32_t seed = 0x5eed1e55;
+    const int num_channels = state->filterbank.num_channels;
+    std::vector<uint64_t> roots;
+    for (const std::vector<uint64_t> & work : inputs.work) {roots.insert(roots.end(), work.begin(), work.end());}
+    for (int i = 0; i < kRandomRounds * num_channels; i++) {
+        uint64_t value = ((uint64_t) NextRandomMagnitude(&seed) << 32) | NextRandom(&seed);
+        roots.push_back(value >> (NextRandom(&seed) % 64));
+    }
+    for (int bit = 0; bit < 64; bit++) {
+        roots.push_back((1ull << bit) - 1);
+        roots.push_back(1ull << bit);
+        roots.push_back((1ull << bit) + 1);
+    }
+    roots.push_back(UINT64_MAX);
+    CheckSqrtLut(&state->filterbank, roots, errors);
+
+    for (size_t f = 0; f < inputs.gained.size(); f++) {
+        CheckLogLut(&state->log_scale, inputs.gained[f].data(), num_channels, inputs.correction_bits[f], errors);
+    }
+    std::vector<uint32_t> values(num_channels);
+    for (int round = 0; round < kRandomRounds; round++) {
+        for (uint32_t & v : values) {v = NextRandomMagnitude(&seed);}
+        CheckLogLut(&state->log_scale, values.data(), num_channels, (int) (NextRandom(&seed) % 7) - 3, errors);
+    }
+    for (int bit = 0; bit < 32; bit++) {
+        uint32_t powers[] = {(1u << bit) - 1, 1u << bit, (1u << bit) + 1, UINT32_MAX};
+        CheckLogLut(&state->log_scale, powers, 4, 0, errors);
+    }
+}
+
+// Time per call of the exact or lookup table square root or log over the recorded inputs,
+// in ns, the best of repeats passes.
+static double TimeLut ( LutStage stage, bool lut, FrontendState * state, const StageInputs & inputs, int repeats ) {
+    const size_t frames = inputs.frames.size();
+    const int num_channels = state->filterbank.num_channels;
+    std::vector<uint32_t> signal(num_channels);
+    state->filterbank.lut_sqrt = lut;
+    state->log_scale.lut_log = lut;
+
+    int64_t best = INT64_MAX;
+    for (int r = 0; r < repeats; r++) {
+        int64_t start = esp_timer_get_time();
+        for (size_t f = 0; f < frames; f++) {
+            if (stage == kLutSqrt) {
+                memcpy(state->filterbank.work + 1, inputs.work[f].data(), num_channels * sizeof(uint64_t));
+                FilterbankSqrt(&state->filterbank, inputs.input_shift[f]);
+            } else {
+                memcpy(signal.data(), inputs.gained[f].data(), num_channels * sizeof(uint32_t));
+                LogScaleApply(&state->log_scale, signal.data(), num_channels, inputs.correction_bits[f]);
+            }
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (elapsed < best) {best = elapsed;}
+    }
+    state->filterbank.lut_sqrt = 0;
+    state->log_scale.lut_log = 0;
+    return frames ? best * 1000.0 / frames : 0.0;
+}
+
+// The int8 quantization the feature provider did after FrontendProcessFrames.
+static int8_t QuantizeDivide ( uint16_t value ) {
+    int32_t quantized = ((value * 256) + (kValueDiv / 2)) / kValueDiv + kInputZeroPoint;
+    if (quantized < -128) {quantized = -128;}
+    if (quantized > 127) {quantized = 127;}
+    return (int8_t) quantized;
+}
+
+// round(value / (kValueDiv * input_scale)) + input_zero_point in double, clamped to int8.
+static int8_t QuantizeReference ( uint16_t value, float input_scale, int input_zero_point ) {
+    const float step = kValueDiv * input_scale;
+    int32_t quantized = (int32_t) floor(value / (double) step + 0.5) + input_zero_point;
+    if (quantized < -128) {quantized = -128;}
+    if (quantized > 127) {quantized = 127;}
+    return (int8_t) quantized;
+}
+
+// Every 16 bit value through LogScaleQuantize, then the audio through FrontendProcessFrames
+// and FrontendProcessFramesInt8 on fresh states quantizing for input_scale and
+// input_zero_point, comparing the quantized slices and the sum of the last one. Returns
+// the mismatches.
+static int CheckInt8 ( float input_scale, int input_zero_point, const std::vector<int16_t> & audio ) {
+    FrontendState frames, int8;
+    if (!PopulateState(&frames, &kIAVozFilterbankTable) ||
+        !PopulateState(&int8, &kIAVozFilterbankTable, input_scale, input_zero_point)) {return 1;}
+
+    int mismatches = 0;
+    for (uint32_t value = 0; value <= 0xFFFF; value++) {
+        mismatches += LogScaleQuantize(&int8.log_scale, value) != QuantizeReference(value, input_scale, input_zero_point);
+    }
+    const size_t num_frames = (audio.size() - frames.window.size) / frames.window.step + 1;
+    const int num_channels = frames.filterbank.num_channels;
+
+    std::vector<uint16_t> values(num_frames * num_channels);
+    std::vector<int8_t> quantized(num_frames * num_channels);
+    FrontendProcessFrames(&frames, audio.data(), num_frames, values.data());
+    const uint32_t sum = FrontendProcessFramesInt8(&int8, audio.data(), num_frames, quantized.data(), NULL);
+
+    for (size_t i = 0; i < values.size(); i++) {
+        mismatches += quantized[i] != QuantizeReference(values[i], input_scale, input_zero_point);
+    }
+    uint32_t last_sum = 0;
+    for (int i = 0; i < num_channels; i++) {last_sum += values[values.size() - num_channels + i];}
+    mismatches += sum != last_sum;
+
+    FrontendFreeStateContents(&frames);
+    FrontendFreeStateContents(&int8);
+    return mismatches;
+}
+
+// Time per frame of the whole frontend over the audio, in ns, the best of repeats passes:
+// FrontendProcessFrames then the division and the float mean of the feature provider, or
+// FrontendProcessFramesInt8.
+static double TimeInt8 ( bool fused, FrontendState * state, const std::vector<int16_t> & audio, int repeats ) {
+    const size_t num_frames = (audio.size() - state->window.size) / state->window.step + 1;
+    const int num_channels = state->filterbank.num_channels;
+    std::vector<uint16_t> values(num_channels);
+    std::vector<int8_t> quantized(num_channels);
+    volatile float mean = 0;
+    volatile uint32_t sum = 0;
+
+    double best = 0;
+    for (int r = 0; r < repeats; r++) {
+        FrontendReset(state);
+        int64_t start = esp_timer_get_time();
+        for (size_t f = 0; f < num_frames; f++) {
+            const int16_t * frame = audio.data() + f * state->window.step;
+            if (fused) {
+                sum = FrontendProcessFramesInt8(state, frame, 1, quantized.data(), NULL);
+            } else {
+                FrontendProcessFrames(state, frame, 1, values.data());
+                float total = 0;
+                for (int i = 0; i < num_channels; i++) {
+                    quantized[i] = QuantizeDivide(values[i]);
+                    total += values[i];
+                }
+                mean = total / num_channels;
+            }
+        }
+        double ns = 1000.0 * (esp_timer_get_time() - start) / num_frames;
+        if (r == 0 || ns < best) {best = ns;}
+    }
+    (void) mean;
+    (void) sum;
+    return best;
+}
+
+// Time per call of one kernel over all the recorded inputs, in ns. The best of repeats
+// passes is kept, which filters out the scheduling noise of a loaded machine. The fused
+// stage runs on a state built from the table, its reference is the energy and filterbank
+// reference kernels one after the other.
+static double TimeStage ( Stage stage, bool optimized, FrontendState * state, const StageInputs & inputs, int repeats ) {
+    const size_t frames = inputs.frames.size();
+    std::vector<int32_t> energy(state->fft.fft_size / 2 + 1);
+
+    int64_t best = INT64_MAX;
+    for (int r = 0; r < repeats; r++) {
+        FrontendReset(state);
+        int64_t start = esp_timer_get_time();
+        for (size_t f = 0; f < frames; f++) {
+            switch (stage) {
+            case kStageWindow:
+                (optimized ? WindowApplyOptimized : WindowApplyReference)(&state->window, inputs.frames[f]);
+                break;
+            case kStageFft:
+                (optimized ? FftComputeOptimized : FftComputeReference)(&state->fft, inputs.windowed[f].data(),
+                                                                         inputs.input_shift[f]);
+                break;
+            case kStageEnergy:
+                (optimized ? FilterbankConvertFftComplexToEnergyOptimized : FilterbankConvertFftComplexToEnergyReference)(
+                    &state->filterbank, (complex_int16_t *) inputs.fft[f].data(), energy.data());
+                break;
+            case kStageFused:
+                if (optimized) {
+                    FilterbankAccumulateSpectrum(&state->filterbank, inputs.fft[f].data());
+                } else {
+                    FilterbankConvertFftComplexToEnergyReference(&state->filterbank, (complex_int16_t *) inputs.fft[f].data(),
+                                                                 energy.data());
+                    FilterbankAccumulateChannels(&state->filterbank, energy.data());
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (elapsed < best) {best = elapsed;}
+    }
+    return frames ? best * 1000.0 / frames : 0.0;
+}
+
+int main ( int argc, char ** argv ) {
+    int repeats = 20;
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-n") && arg + 1 < argc) {
+            repeats = atoi(argv[++arg]);
+        } else {
+            break;
+        }
+    }
+    if ((arg < argc && argv[arg][0] == '-') || repeats <= 0) {
+        fprintf(stderr, "usage: %s [-n repeats] [file.wav ...]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<int16_t> audio;
+    AppendSynthetic(audio);
+    for (; arg < argc; arg++) {
+        if (!AppendWav(audio, argv[arg])) {return 2;}
+    }
+
+    FrontendState ref, opt, tab;
+    if (!PopulateState(&ref, NULL) || !PopulateState(&opt, NULL) || !PopulateState(&tab, &kIAVozFilterbankTable)) {
+        ESP_LOGE(TAG, "FrontendPopulateState() failed");
+        return 1;
+    }
+    if (!tab.filterbank.table) {
+        ESP_LOGE(TAG, "ges_iavoz_filterbank_table.h does not match the config, regenerate it with iavoz_filterbank_gen");
+        return 1;
+    }
+
+    int mismatches[kStageCount] = {0};
+    StageInputs inputs;
+    CheckFrames(&ref, &opt, &tab, audio, &inputs, mismatches);
+    CheckRandom(&ref, &opt, &tab, mismatches);
+
+#ifdef MICROFRONTEND_OPTIMIZED
+    const char * backend = "optimized";
+#else
+    const char * backend = "reference";
+#endif
+    printf("%zu frames + %d random rounds, the pipeline runs the %s kernels\n", inputs.frames.size(), kRandomRounds, backend);
+    printf("%-18s %12s %12s %8s %10s\n", "stage", "ref_ns", "opt_ns", "speedup", "mismatch");
+
+    int total_mismatches = 0;
+    for (int stage = 0; stage < kStageCount; stage++) {
+        double ref_ns = TimeStage((Stage) stage, false, &ref, inputs, repeats);
+        double opt_ns = TimeStage((Stage) stage, true, stage == kStageFused ? &tab : &ref, inputs, repeats);
+        printf("%-18s %12.1f %12.1f %7.2fx %10d\n", kStageNames[stage], ref_ns, opt_ns, opt_ns > 0 ? ref_ns / opt_ns : 0.0,
+               mismatches[stage]);
+        total_mismatches += mismatches[stage];
+    }
+
+    LutErrors lut_errors = {};
+    CheckLut(&ref, inputs, &lut_errors);
+    printf("\n%-18s %12s %12s %8s %10s %10s\n", "lookup table", "exact_ns", "lut_ns", "speedup", "of_bound", "over_bound");
+    int total_over_bound = 0;
+    for (int stage = 0; stage < kLutCount; stage++) {
+        double exact_ns = TimeLut((LutStage) stage, false, &ref, inputs, repeats);
+        double lut_ns = TimeLut((LutStage) stage, true, &ref, inputs, repeats);
+        printf("%-18s %12.1f %12.1f %7.2fx %10.2f %10d\n", kLutNames[stage], exact_ns, lut_ns, lut_ns > 0 ? exact_ns / lut_ns : 0.0,
+               lut_errors.worst[stage], lut_errors.over_bound[stage]);
+        total_over_bound += lut_errors.over_bound[stage];
+    }
+
+    const int int8_mismatches = CheckInt8(kInputScale, kInputZeroPoint, audio) +
+                                CheckInt8(kOtherInputScale, kOtherInputZeroPoint, audio);
+    const double divide_ns = TimeInt8(false, &tab, audio, repeats);
+    const double int8_ns = TimeInt8(true, &tab, audio, repeats);
+    printf("\n%-18s %12s %12s %8s %10s\n", "output", "divide_ns", "int8_ns", "speedup", "mismatch");
+    printf("%-18s %12.1f %12.1f %7.2fx %10d\n", "int8 frame", divide_ns, int8_ns, int8_ns > 0 ? divide_ns / int8_ns : 0.0,
+           int8_mismatches);
+
+    FrontendFreeStateContents(&ref);
+    FrontendFreeStateContents(&opt);
+    FrontendFreeStateContents(&tab);
+
+    if (total_mismatches) {
+        ESP_LOGE(TAG, "Optimized kernels differ from the reference %d times", total_mismatches);
+        return 1;
+    }
+    if (int8_mismatches) {
+        ESP_LOGE(TAG, "int8 frontend output differs from the divided one %d times", int8_mismatches);
+        return 1;
+    }
+    if (total_over_bound) {
+        ESP_LOGE(TAG, "Lookup table square root or log over its error bound %d times", total_over_bound);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+/********************************************************************************************
+* Host helpers shared by the ges_iavoz workstation tools.
+***********************************************************************************************/
+
+#include "iavoz_host.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include <algorithm>
+
+#include "model_settings.h"
+
+static const char * TAG = "IAVOZ_HOST";
+
+IAVoz_ModelSettings_t IAVoz_HostModelSettings = {
+    .kMaxAudioSampleSize = kMaxAudioSampleSize,
+    .kAudioSampleFrequency = kAudioSampleFrequency,
+    .kFeatureSliceSize = kFeatureSliceSize,
+    .kFeatureSliceCount = kFeatureSliceCount,
+    .kFeatureElementCount = kFeatureElementCount,
+    .kFeatureSliceStrideMs = kFeatureSliceStrideMs,
+    .kFeatureSliceDurationMs = kFeatureSliceDurationMs,
+    .kSilenceIndex = kSilenceIndex,
+    .kUnknownIndex = kUnknownIndex,
+    .kCategoryCount = kCategoryCount,
+    .kCategoryLabels = kCategoryLabels,
+};
+
+void IAVoz_Host_NullCallback ( IAVOZ_KEY_t, uint64_t ) {
+}
+
+const char * IAVoz_HostKeyNames[IAVOZ_NUM_KEYS] = {
+    "null", "heylola", "enciende", "apaga", "sube", "baja", "para", "socorro", "activa", "todo",
+};
+
+static IAVOZ_KEY_t IAVoz_Host_LabelFromName ( const char * name ) {
+    for (int key = IAVOZ_KEY_HEYLOLA; key < IAVOZ_NUM_KEYS; key++) {
+        if (!strcasecmp(name, IAVoz_HostKeyNames[key])) {return (IAVOZ_KEY_t) key;}
+    }
+    return IAVOZ_KEY_NULL;
+}
+
+static bool IAVoz_Host_HasWavExtension ( const char * name ) {
+    size_t len = strlen(name);
+    return len > 4 && !strcasecmp(name + len - 4, ".wav");
+}
+
+static std::vector<std::string> IAVoz_Host_ListDir ( const std::string & path, bool directories ) {
+    std::vector<std::string> entries;
+    DIR * dir = opendir(path.c_str());
+    if (!dir) {return entries;}
+
+    struct dirent * entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {continue;}
+        bool is_dir = (entry->d_type == DT_DIR);
+        if (is_dir == directories && (is_dir || IAVoz_Host_HasWavExtension(entry->d_name))) {
+            entries.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+std::vector<IAVoz_HostUtterance_t> IAVoz_Host_ListCorpus ( const std::string & corpus ) {
+    std::vector<IAVoz_HostUtterance_t> utterances;
+    for (const std::string & label : IAVoz_Host_ListDir(corpus, true)) {
+        for (const std::string & file : IAVoz_Host_ListDir(corpus + "/" + label, false)) {
+            utterances.push_back({corpus + "/" + label + "/" + file, IAVoz_Host_LabelFromName(label.c_str())});
+        }
+    }
+    return utterances;
+}
+
+bool IAVoz_Host_RunWav ( IAVoz_System_t * sys, const char * path, int32_t step_ms, IAVoz_HostStepHook_t hook, void * user ) {
+    if (!IAVoz_AudioProvider_LoadWav(sys->ap, path)) {return false;}
+
+    // The first step fills the whole feature window, make sure the capture buffer holds it.
+    // A file shorter than that still gets its one step.
+    bool is_fed = false;
+    if (LatestAudioTimestamp(sys->ap) == 0) {
+        IAVoz_AudioProvider_FeedWav(sys->ap, sys->ms->kFeatureSliceCount * sys->ms->kFeatureSliceStrideMs);
+        is_fed = IAVoz_AudioProvider_IsWavDone(sys->ap);
+    }
+
+    while (is_fed || !IAVoz_AudioProvider_IsWavDone(sys->ap)) {
+        if (!is_fed && IAVoz_AudioProvider_FeedWav(sys->ap, step_ms) == 0) {break;}
+        is_fed = false;
+
+        int how_many_new_slices = 0;
+        TfLiteStatus step_status = IAVoz_System_Step(sys, &how_many_new_slices);
+        if (step_status != kTfLiteOk) {
+            ESP_LOGE(TAG, "Step failed on %s at %d ms", path, LatestAudioTimestamp(sys->ap));
+            return false;
+        }
+
+        if (hook) {hook(sys, LatestAudioTimestamp(sys->ap), how_many_new_slices, user);}
+    }
+
+    return true;
+}
+
+// Sleeps until wake, calling the hook once for every inference the system tasks finish
+// meanwhile. Every inference is recorded in the latency statistics, and the next one is
+// at least a slice of real time away, so polling once per tick sees each of them.
+static void IAVoz_Host_SleepUntil ( IAVoz_System_t * sys, TickType_t wake, IAVoz_HostStepHook_t hook, void * user, uint32_t * seen ) {
+    for (;;) {
+        if (hook && sys->latency.count != *seen) {
+            *seen = sys->latency.count;
+            hook(sys, LatestAudioTimestamp(sys->ap), -1, user);
+        }
+
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t) (wake - now) <= 0) {break;}
+        vTaskDelay(hook ? 1 : wake - now);
+    }
+}
+
+bool IAVoz_Host_StreamWav ( IAVoz_System_t * sys, const char * path, int32_t step_ms, int core, IAVoz_HostStepHook_t hook, void * user ) {
+    if (!IAVoz_AudioProvider_LoadWav(sys->ap, path)) {return false;}
+
+    uint32_t seen = sys->latency.count;
+    IAVoz_System_Start(sys, core);
+
+    TickType_t wake = xTaskGetTickCount();
+    while (IAVoz_AudioProvider_FeedWav(sys->ap, step_ms) > 0) {
+        wake += step_ms / portTICK_PERIOD_MS;
+        IAVoz_Host_SleepUntil(sys, wake, hook, user, &seen);
+    }
+
+    // Let the tasks drain the last window before stopping them.
+    wake = xTaskGetTickCount() + 2 * sys->ms->kFeatureSliceDurationMs / portTICK_PERIOD_MS + 100 / portTICK_PERIOD_MS;
+    IAVoz_Host_SleepUntil(sys, wake, hook, user, &seen);
+    IAVoz_System_Stop(sys);
+    return true;
+}
+
+uint32_t IAVoz_Host_Percentile ( const std::vector<uint32_t> & sorted, double p ) {
+    if (sorted.empty()) {return 0;}
+    size_t rank = (size_t) (p / 100.0 * sorted.size() + 0.5);
+    if (rank < 1) {rank = 1;}
+    if (rank > sorted.size()) {rank = sorted.size();}
+    return sorted[rank - 1];
+}
+
+void IAVoz_Host_PrintLatency ( IAVoz_System_t * sys ) {
+    const IAVoz_SystemLatency_t * latency = &sys->latency;
+    if (!latency->count) {
+        printf("no invocations\n");
+        return;
+    }
+
+    printf("detection latency over %u invocations: mean %.1f ms, max %.1f ms\n", (unsigned) latency->count,
+           latency->total_us / 1000.0 / latency->count, latency->max_us / 1000.0);
+
+    uint32_t peak = 0;
+    for (int i = 0; i < IAVOZ_LATENCY_BUCKETS; i++) {
+        if (latency->buckets[i] > peak) {peak = latency->buckets[i];}
+    }
+
+    for (int i = 0; i < IAVOZ_LATENCY_BUCKETS; i++) {
+        if (!latency->buckets[i]) {continue;}
+
+        char bar[41] = {0};
+        memset(bar, '#', (size_t) (40.0 * latency->buckets[i] / peak + 0.5));
+        if (i == IAVOZ_LATENCY_BUCKETS - 1) {
+            printf("  >= %3d ms %6u %s\n", i * IAVOZ_LATENCY_BUCKET_MS, (unsigned) latency->buckets[i], bar);
+        } else {
+            printf("%3d-%3d ms %6u %s\n", i * IAVOZ_LATENCY_BUCKET_MS, (i + 1) * IAVOZ_LATENCY_BUCKET_MS,
+                   (unsigned) latency->buckets[i], bar);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/********************************************************************************************
+* Host helpers shared by the ges_iavoz workstation tools.
+***********************************************************************************************/
+
+#ifndef _IAVOZ_HOST
+#define _IAVOZ_HOST
+
+#include <string>
+#include <vector>
+
+#include "ges_iavoz_main.h"
+
+// Same settings IAVOZ_Init hands to the system on the device.
+extern IAVoz_ModelSettings_t IAVoz_HostModelSettings;
+
+// System callback for the tools that read detections from sys->activation. The recognizer
+// stops at the activation (see RecognizeCommands::ProcessLatestResults), so it never runs.
+void IAVoz_Host_NullCallback ( IAVOZ_KEY_t, uint64_t );
+
+// Called after every IAVoz_System_Step with the audio time it was run at.
+typedef void (*IAVoz_HostStepHook_t)(IAVoz_System_t * sys, int32_t time_ms, int how_many_new_slices, void * user);
+
+/**
+ * @brief Streams a WAV file through the system as fast as possible.
+ *
+ * @param sys       A system initialized with the WAV audio source.
+ * @param path      16 kHz, 16 bit PCM WAV file.
+ * @param step_ms   Audio fed between two calls to IAVoz_System_Step, a multiple of kFeatureSliceStrideMs.
+ * @param hook      Optional per-step callback.
+ *
+ * @return
+ *     - true if the whole file was processed
+ *     - false if the file could not be loaded or the pipeline failed
+ */
+bool IAVoz_Host_RunWav ( IAVoz_System_t * sys, const char * path, int32_t step_ms, IAVoz_HostStepHook_t hook, void * user );
+
+/**
+ * @brief Plays a WAV file in real time through the system tasks, as the microphone would.
+ *
+ * Starts the system with IAVoz_System_Start, feeds step_ms of audio every step_ms and
+ * stops it once the file is over. The system tasks step on their own, so the hook is
+ * polled once per tick instead and called after every inference they ran, with
+ * how_many_new_slices set to -1.
+ *
+ * @param sys       A stopped system initialized with the WAV audio source.
+ * @param path      16 kHz, 16 bit PCM WAV file.
+ * @param step_ms   Audio fed at a time.
+ * @param core      Core handed to IAVoz_System_Start.
+ * @param hook      Optional per-inference callback.
+ *
+ * @return
+ *     - true if the whole file was played
+ *     - false if the file could not be loaded
+ */
+bool IAVoz_Host_StreamWav ( IAVoz_System_t * sys, const char * path, int32_t step_ms, int core, IAVoz_HostStepHook_t hook, void * user );
+
+// Lower case keyword names, indexed by IAVOZ_KEY_t.
+extern const char * IAVoz_HostKeyNames[IAVOZ_NUM_KEYS];
+
+// A WAV file of a labelled corpus.
+typedef struct {
+    std::string path;
+    IAVOZ_KEY_t label;
+} IAVoz_HostUtterance_t;
+
+/**
+ * @brief Lists the WAV files of a labelled corpus.
+ *
+ * The corpus holds one directory per label, named after the keyword in lower case
+ * (heylola, enciende, apaga, ...). Any other directory, e.g. "null" or "noise", holds
+ * negative samples labelled IAVOZ_KEY_NULL. Directories and files are sorted by name.
+ */
+std::vector<IAVoz_HostUtterance_t> IAVoz_Host_ListCorpus ( const std::string & corpus );
+
+// The p-th percentile (nearest rank) of values sorted in ascending order, 0 if empty.
+uint32_t IAVoz_Host_Percentile ( const std::vector<uint32_t> & sorted, double p );
+
+// Prints the detection latency histogram collected by the system.
+void IAVoz_Host_PrintLatency ( IAVoz_System_t * sys );
+
+#endif // _IAVOZ_HOST
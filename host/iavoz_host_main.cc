@@ -0,0 +1,68 @@
+/********************************************************************************************
+* iavoz_host: runs the keyword spotting pipeline over WAV files on a workstation.
+*
+* Usage: iavoz_host [-s step_ms] [-r] [-v] file.wav [file.wav ...]
+*
+* By default every file is pushed through IAVoz_System_Step as fast as possible. With -r it
+* is played in real time and processed by the system tasks, as on the device, and the
+* detection latency histogram is printed at the end. Every keyword the recognizer activates
+* on is printed with the audio time it was heard at.
+***********************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iavoz_host.h"
+
+static const char * TAG = "IAVOZ_HOST";
+
+static IAVoz_System_t * IAVoz_System = NULL;
+
+static void iavoz_host_step_hook ( IAVoz_System_t * sys, int32_t time_ms, int, void * user ) {
+    if (sys->activation == IAVOZ_KEY_NULL) {return;}
+    printf("%s: keyword %s at %d ms\n", (const char *) user, IAVoz_HostKeyNames[sys->activation], time_ms);
+}
+
+int main ( int argc, char ** argv ) {
+    int32_t step_ms = kFeatureSliceStrideMs * 5;
+    bool real_time = false;
+    int first_file = 1;
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    for (; first_file < argc && argv[first_file][0] == '-'; first_file++) {
+        if (!strcmp(argv[first_file], "-s") && first_file + 1 < argc) {
+            step_ms = atoi(argv[++first_file]);
+        } else if (!strcmp(argv[first_file], "-r")) {
+            real_time = true;
+        } else if (!strcmp(argv[first_file], "-v")) {
+            esp_log_level_set("*", ESP_LOG_INFO);
+        } else {
+            break;
+        }
+    }
+
+    if (first_file >= argc || step_ms <= 0 || step_ms % kFeatureSliceStrideMs) {
+        fprintf(stderr, "usage: %s [-s step_ms] [-r] [-v] file.wav [file.wav ...]\n", argv[0]);
+        fprintf(stderr, "       step_ms must be a multiple of %d\n", kFeatureSliceStrideMs);
+        return 2;
+    }
+
+    if (!IAVoz_System_Init(&IAVoz_System, &IAVoz_HostModelSettings, IAVoz_Host_NullCallback)) {
+        ESP_LOGE(TAG, "System init failed");
+        return 1;
+    }
+
+    int failures = 0;
+    for (int i = first_file; i < argc; i++) {
+        bool ok = real_time ? IAVoz_Host_StreamWav(IAVoz_System, argv[i], step_ms, -1, iavoz_host_step_hook, argv[i])
+                            : IAVoz_Host_RunWav(IAVoz_System, argv[i], step_ms, iavoz_host_step_hook, argv[i]);
+        if (!ok) {failures++;}
+    }
+
+    if (real_time) {IAVoz_Host_PrintLatency(IAVoz_System);}
+
+    IAVoz_System_DeInit(IAVoz_System);
+    return failures ? 1 : 0;
+}
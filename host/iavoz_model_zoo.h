@@ -0,0 +1,14 @@
+#ifndef IAVOZ_MODEL_ZOO_H
+#define IAVOZ_MODEL_ZOO_H
+
+// Registry of the candidate models, generated by host/CMakeLists.txt. Every model
+// source defines g_model, so each one is compiled with g_model renamed after its file.
+typedef struct {
+    const char * name;
+    const unsigned char * data;
+} IAVoz_ZooModel_t;
+
+extern const IAVoz_ZooModel_t kIAVozZooModels[];
+extern const int kIAVozZooModelCount;
+
+#endif // IAVOZ_MODEL_ZOO_H
@@ -0,0 +1,238 @@
+/********************************************************************************************
+* iavoz_model_zoo_bench: side-by-side arena and latency figures for every candidate model.
+*
+* Usage: iavoz_model_zoo_bench [-n invocations] [-a arena_bytes] [-p] [model ...]
+*
+* Every model in old_models/ (plus the deployed mobilnet.cc and its iavoz_pack_weights
+* version mobilnet_packed.cc) is linked in under its own symbol, see iavoz_model_zoo.h.
+* Each one is loaded through tflite::GetModel, allocated with a RecordingMicroInterpreter
+* to measure the arena it really needs and then invoked N times on a fixed pseudo random
+* input. -p adds the per-op latency breakdown.
+***********************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "iavoz_model_zoo.h"
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/recording_micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+static const char * TAG = "IAVOZ_ZOO";
+
+// Accumulates the time spent in every node over all the invocations. MicroGraph
+// opens one event per node, in execution order, tagged with the op name.
+class ZooProfiler : public tflite::MicroProfiler {
+  public:
+    uint32_t BeginEvent ( const char * tag ) override {
+        if (current_ == nodes_.size()) {nodes_.push_back({tag, 0});}
+        start_us_ = esp_timer_get_time();
+        return current_++;
+    }
+
+    void EndEvent ( uint32_t event_handle ) override {
+        nodes_[event_handle].total_us += esp_timer_get_time() - start_us_;
+    }
+
+    void NextInvoke ( void ) {current_ = 0;}
+
+    void Reset ( void ) {
+        nodes_.clear();
+        current_ = 0;
+    }
+
+    struct Node {
+        const char * tag;
+        int64_t total_us;
+    };
+
+    std::vector<Node> nodes_;
+
+  private:
+    uint32_t current_ = 0;
+    int64_t start_us_ = 0;
+
+    TF_LITE_REMOVE_VIRTUAL_DELETE;
+};
+
+struct ZooResult {
+    const IAVoz_ZooModel_t * model;
+    bool ok;
+    size_t nodes;
+    size_t arena_bytes;
+    size_t persistent_bytes;
+    int64_t mean_us;
+    int64_t min_us;
+    int64_t max_us;
+};
+
+static void PrintOpBreakdown ( const ZooProfiler & profiler, int invocations ) {
+    struct OpTotal {
+        const char * tag;
+        int count;
+        int64_t total_us;
+    };
+    std::vector<OpTotal> ops;
+
+    int64_t total_us = 0;
+    for (const ZooProfiler::Node & node : profiler.nodes_) {
+        total_us += node.total_us;
+        auto op = std::find_if(ops.begin(), ops.end(), [&](const OpTotal & o) {return !strcmp(o.tag, node.tag);});
+        if (op == ops.end()) {
+            ops.push_back({node.tag, 1, node.total_us});
+        } else {
+            op->count++;
+            op->total_us += node.total_us;
+        }
+    }
+
+    std::sort(ops.begin(), ops.end(), [](const OpTotal & a, const OpTotal & b) {return a.total_us > b.total_us;});
+
+    printf("  %-24s %6s %12s %7s\n", "op", "nodes", "us/invoke", "share");
+    for (const OpTotal & op : ops) {
+        printf("  %-24s %6d %12.1f %6.1f%%\n", op.tag, op.count, (double) op.total_us / invocations,
+               total_us ? 100.0 * op.total_us / total_us : 0.0);
+    }
+}
+
+static ZooResult RunModel ( const IAVoz_ZooModel_t * entry, uint8_t * arena, size_t arena_size, int invocations,
+                            ZooProfiler * profiler, tflite::ErrorReporter * error_reporter ) {
+    static tflite::AllOpsResolver resolver;
+    ZooResult result = {entry, false, 0, 0, 0, 0, 0, 0};
+
+    const tflite::Model * model = tflite::GetModel(entry->data);
+    if (model->version() != TFLITE_SCHEMA_VERSION) {
+        ESP_LOGE(TAG, "%s: schema version %d not equal to supported version %d", entry->name, model->version(), TFLITE_SCHEMA_VERSION);
+        return result;
+    }
+
+    profiler->Reset();
+    tflite::RecordingMicroInterpreter interpreter(model, resolver, arena, arena_size, error_reporter, nullptr, profiler);
+    if (interpreter.AllocateTensors() != kTfLiteOk) {
+        ESP_LOGE(TAG, "%s: AllocateTensors() failed with a %u byte arena", entry->name, (unsigned) arena_size);
+        return result;
+    }
+
+    result.nodes = model->subgraphs()->Get(0)->operators()->size();
+    result.arena_bytes = interpreter.arena_used_bytes();
+    result.persistent_bytes = interpreter.GetMicroAllocator().GetSimpleMemoryAllocator()->GetPersistentUsedBytes();
+
+    // Fixed input so every model sees the same data from run to run.
+    TfLiteTensor * input = interpreter.input(0);
+    uint32_t seed = 0x1a2b3c4d;
+    for (size_t i = 0; i < input->bytes; i++) {
+        seed = seed * 1664525 + 1013904223;
+        input->data.uint8[i] = (uint8_t) (seed >> 24);
+    }
+
+    // Warm-up, not measured.
+    if (interpreter.Invoke() != kTfLiteOk) {
+        ESP_LOGE(TAG, "%s: Invoke() failed", entry->name);
+        return result;
+    }
+    profiler->Reset();
+
+    int64_t total_us = 0;
+    result.min_us = INT64_MAX;
+    for (int i = 0; i < invocations; i++) {
+        profiler->NextInvoke();
+        int64_t start = esp_timer_get_time();
+        interpreter.Invoke();
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        total_us += elapsed;
+        result.min_us = std::min(result.min_us, elapsed);
+        result.max_us = std::max(result.max_us, elapsed);
+    }
+
+    result.mean_us = total_us / invocations;
+    result.ok = true;
+    return result;
+}
+
+int main ( int argc, char ** argv ) {
+    int invocations = 20;
+    size_t arena_size = 4 * 1024 * 1024;
+    bool per_op = false;
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-n") && arg + 1 < argc) {
+            invocations = atoi(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-a") && arg + 1 < argc) {
+            arena_size = strtoul(argv[++arg], NULL, 0);
+        } else if (!strcmp(argv[arg], "-p")) {
+            per_op = true;
+        } else {
+            break;
+        }
+    }
+
+    if (invocations <= 0 || arena_size == 0 || (arg < argc && argv[arg][0] == '-')) {
+        fprintf(stderr, "usage: %s [-n invocations] [-a arena_bytes] [-p] [model ...]\n", argv[0]);
+        return 2;
+    }
+
+    uint8_t * arena = (uint8_t *) aligned_alloc(16, (arena_size + 15) & ~(size_t) 15);
+    if (!arena) {
+        ESP_LOGE(TAG, "Error allocating a %u byte arena", (unsigned) arena_size);
+        return 1;
+    }
+
+    static tflite::MicroErrorReporter error_reporter;
+    static ZooProfiler profiler;
+    std::vector<ZooResult> results;
+
+    for (int i = 0; i < kIAVozZooModelCount; i++) {
+        const IAVoz_ZooModel_t * entry = &kIAVozZooModels[i];
+
+        bool selected = (arg == argc);
+        for (int j = arg; j < argc && !selected; j++) {selected = !strcmp(argv[j], entry->name);}
+        if (!selected) {continue;}
+
+        ZooResult result = RunModel(entry, arena, arena_size, invocations, &profiler, &error_reporter);
+        results.push_back(result);
+
+        if (per_op && result.ok) {
+            printf("%s\n", entry->name);
+            PrintOpBreakdown(profiler, invocations);
+            printf("\n");
+        }
+    }
+
+    if (results.empty()) {
+        ESP_LOGE(TAG, "No model matched");
+        free(arena);
+        return 1;
+    }
+
+    std::sort(results.begin(), results.end(), [](const ZooResult & a, const ZooResult & b) {
+        if (a.ok != b.ok) {return a.ok;}
+        return a.mean_us < b.mean_us;
+    });
+
+    printf("%-48s %6s %12s %12s %10s %10s %10s\n", "model", "nodes", "arena_B", "persist_B", "mean_us", "min_us", "max_us");
+    int failed = 0;
+    for (const ZooResult & r : results) {
+        if (!r.ok) {
+            printf("%-48s %6s\n", r.model->name, "FAILED");
+            failed++;
+            continue;
+        }
+        printf("%-48s %6zu %12zu %12zu %10lld %10lld %10lld\n", r.model->name, r.nodes, r.arena_bytes, r.persistent_bytes,
+               (long long) r.mean_us, (long long) r.min_us, (long long) r.max_us);
+    }
+
+    free(arena);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,752 @@
+/********************************************************************************************
+* iavoz_nn_bench: portable esp-nn kernels against the reference_integer_ops ones.
+*
+* Usage: iavoz_nn_bench [-n repeats] [-r rounds]
+*
+* Feeds random shapes (1x1 and 3x3 filters, strides 1 and 2, padding, depth multipliers,
+* channel counts around the vector widths) and random quantization parameters to every
+* function of esp_nn/esp_nn.h and to the reference kernel the esp_nn kernels fall back to
+* without ESP_NN, comparing the outputs bit for bit. Then times both on the layer shapes of
+* the deployed model, keeping the best of five passes of n calls. The depthwise kernels
+* specialized for 3x3 filters (kernels/esp_nn/depthwise_conv_specialized.h) are checked
+* the same way and timed against esp-nn on every depthwise layer of the model, and the
+* packed weights kernels (kernels/packed_weights.h) on every CONV_2D layer and the
+* FULLY_CONNECTED. MeanInt8OverHeightWidth (kernels/reduce.h) is checked against the
+* generic reducer it replaces and timed on the classifier head.
+* Exits with 1 on any mismatch.
+***********************************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_nn.h"
+#include "esp_timer.h"
+
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/add.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/depthwise_conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/mean.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/mul.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/pooling.h"
+#include "tensorflow/lite/kernels/internal/reference/reduce.h"
+#include "tensorflow/lite/kernels/internal/reference/softmax.h"
+#include "tensorflow/lite/micro/kernels/esp_nn/depthwise_conv_specialized.h"
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
+#include "tensorflow/lite/micro/kernels/reduce.h"
+
+static const char * TAG = "IAVOZ_NN";
+
+static std::mt19937 rng(1234);
+
+static int RandInt ( int lo, int hi ) {
+    return std::uniform_int_distribution<int>(lo, hi)(rng);
+}
+
+static void RandFill ( std::vector<int8_t> & v ) {
+    for (int8_t & x : v) {x = (int8_t) RandInt(-128, 127);}
+}
+
+// A multiplier in [0.5, 1) as Q31 and a shift, as QuantizeMultiplier gives them.
+static void RandQuant ( int32_t * mult, int32_t * shift, int min_shift, int max_shift ) {
+    *mult = RandInt(1 << 30, INT32_MAX);
+    *shift = RandInt(min_shift, max_shift);
+}
+
+// Activation range, either the full int8 range or a fused RELU-like one.
+static void RandActivation ( int32_t * act_min, int32_t * act_max ) {
+    if (RandInt(0, 1)) {
+        *act_min = -128;
+        *act_max = 127;
+    } else {
+        *act_min = RandInt(-128, 0);
+        *act_max = RandInt(*act_min, 127);
+    }
+}
+
+// Output size of a convolution or pool with TfLite SAME padding when same, VALID otherwise.
+static int OutSize ( int in, int filter, int stride, bool same, int * pad ) {
+    int out = same ? (in + stride - 1) / stride : (in - filter + stride) / stride;
+    int total = (out - 1) * stride + filter - in;
+    *pad = same && total > 0 ? total / 2 : 0;
+    return out;
+}
+
+static tflite::RuntimeShape Shape ( std::initializer_list<int32_t> dims ) {
+    return tflite::RuntimeShape((int) dims.size(), dims.begin());
+}
+
+static bool Compare ( const char * what, const std::vector<int8_t> & expected, const std::vector<int8_t> & actual ) {
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (expected[i] != actual[i]) {
+            ESP_LOGE(TAG, "%s: output %zu is %d, reference %d", what, i, actual[i], expected[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* convolutions */
+
+struct ConvCase {
+    int input_ht, input_wd, in_ch, out_ch;
+    int filter_ht, filter_wd;
+    int stride_ht, stride_wd;
+    bool same;
+    int ch_mult;    // depthwise only
+
+    int output_ht, output_wd, pad_ht, pad_wd;
+    int32_t in_offset, out_offset, act_min, act_max;
+    std::vector<int8_t> input, filter, ref_out, nn_out;
+    std::vector<int32_t> bias, mult, shift;
+    std::vector<uint8_t> scratch;
+    // PackConv() weights.
+    std::vector<int8_t> packed_filter;
+    std::vector<int32_t> packed_bias;
+};
+
+static void ConvSetup ( ConvCase & c, bool depthwise ) {
+    if (depthwise) {c.out_ch = c.in_ch * c.ch_mult;}
+    c.output_ht = OutSize(c.input_ht, c.filter_ht, c.stride_ht, c.same, &c.pad_ht);
+    c.output_wd = OutSize(c.input_wd, c.filter_wd, c.stride_wd, c.same, &c.pad_wd);
+    c.in_offset = -RandInt(-128, 127);
+    c.out_offset = RandInt(-128, 127);
+    RandActivation(&c.act_min, &c.act_max);
+
+    c.input.resize(c.input_ht * c.input_wd * c.in_ch);
+    c.filter.resize(c.filter_ht * c.filter_wd * (depthwise ? c.out_ch : c.in_ch * c.out_ch));
+    c.ref_out.resize(c.output_ht * c.output_wd * c.out_ch);
+    c.nn_out.resize(c.ref_out.size());
+    c.bias.resize(c.out_ch);
+    c.mult.resize(c.out_ch);
+    c.shift.resize(c.out_ch);
+    RandFill(c.input);
+    RandFill(c.filter);
+    for (int oc = 0; oc < c.out_ch; oc++) {
+        c.bias[oc] = RandInt(-50000, 50000);
+        RandQuant(&c.mult[oc], &c.shift[oc], -12, 1);
+    }
+}
+
+static void ConvReference ( ConvCase & c ) {
+    tflite::ConvParams params = {};
+    params.padding_values.height = c.pad_ht;
+    params.padding_values.width = c.pad_wd;
+    params.stride_height = c.stride_ht;
+    params.stride_width = c.stride_wd;
+    params.dilation_height_factor = 1;
+    params.dilation_width_factor = 1;
+    params.input_offset = c.in_offset;
+    params.output_offset = c.out_offset;
+    params.quantized_activation_min = c.act_min;
+    params.quantized_activation_max = c.act_max;
+    tflite::reference_integer_ops::ConvPerChannel(
+        params, c.mult.data(), c.shift.data(),
+        Shape({1, c.input_ht, c.input_wd, c.in_ch}), c.input.data(),
+        Shape({c.out_ch, c.filter_ht, c.filter_wd, c.in_ch}), c.filter.data(),
+        Shape({c.out_ch}), c.bias.data(),
+        Shape({1, c.output_ht, c.output_wd, c.out_ch}), c.ref_out.data());
+}
+
+static void ConvEspNn ( ConvCase & c ) {
+    data_dims_t input_dims = {c.input_wd, c.input_ht, c.in_ch, 1};
+    data_dims_t output_dims = {c.output_wd, c.output_ht, c.out_ch, 1};
+    data_dims_t filter_dims = {c.filter_wd, c.filter_ht, 0, 0};
+    conv_params_t params = {c.in_offset, c.out_offset, {c.stride_wd, c.stride_ht}, {c.pad_wd, c.pad_ht},
+                            {0, 0}, {c.act_min, c.act_max}};
+    quant_data_t quant = {c.shift.data(), c.mult.data()};
+    c.scratch.resize(esp_nn_get_conv_scratch_size(&input_dims, &filter_dims, &output_dims, &params));
+    esp_nn_set_conv_scratch_buf(c.scratch.data());
+    esp_nn_conv_s8(&input_dims, c.input.data(), &filter_dims, c.filter.data(), c.bias.data(),
+                   &output_dims, c.nn_out.data(), &params, &quant);
+}
+
+static void DepthwiseReference ( ConvCase & c ) {
+    tflite::DepthwiseParams params = {};
+    params.padding_values.height = c.pad_ht;
+    params.padding_values.width = c.pad_wd;
+    params.stride_height = c.stride_ht;
+    params.stride_width = c.stride_wd;
+    params.dilation_height_factor = 1;
+    params.dilation_width_factor = 1;
+    params.depth_multiplier = c.ch_mult;
+    params.input_offset = c.in_offset;
+    params.output_offset = c.out_offset;
+    params.quantized_activation_min = c.act_min;
+    params.quantized_activation_max = c.act_max;
+    tflite::reference_integer_ops::DepthwiseConvPerChannel(
+        params, c.mult.data(), c.shift.data(),
+        Shape({1, c.input_ht, c.input_wd, c.in_ch}), c.input.data(),
+        Shape({1, c.filter_ht, c.filter_wd, c.out_ch}), c.filter.data(),
+        Shape({c.out_ch}), c.bias.data(),
+        Shape({1, c.output_ht, c.output_wd, c.out_ch}), c.ref_out.data());
+}
+
+static void DepthwiseEspNn ( ConvCase & c ) {
+    data_dims_t input_dims = {c.input_wd, c.input_ht, c.in_ch, 1};
+    data_dims_t output_dims = {c.output_wd, c.output_ht, c.out_ch, 1};
+    data_dims_t filter_dims = {c.filter_wd, c.filter_ht, 0, 0};
+    dw_conv_params_t params = {c.in_offset, c.out_offset, c.ch_mult, {c.stride_wd, c.stride_ht},
+                               {c.pad_wd, c.pad_ht}, {0, 0}, {c.act_min, c.act_max}};
+    quant_data_t quant = {c.shift.data(), c.mult.data()};
+    c.scratch.resize(esp_nn_get_depthwise_conv_scratch_size(&input_dims, &filter_dims, &output_dims, &params));
+    esp_nn_set_depthwise_conv_scratch_buf(c.scratch.data());
+    esp_nn_depthwise_conv_s8(&input_dims, c.input.data(), &filter_dims, c.filter.data(), c.bias.data(),
+                             &output_dims, c.nn_out.data(), &params, &quant);
+}
+
+static void DepthwiseSpecialized ( ConvCase & c ) {
+    tflite::DepthwiseConvSpecializedFn kernel = tflite::GetDepthwiseConvSpecialized(
+        c.filter_ht, c.filter_wd, c.stride_ht, c.stride_wd, c.ch_mult);
+    tflite::DepthwiseConvSpecializedParams params = {
+        c.input_ht, c.input_wd, c.in_ch, c.output_ht, c.output_wd, c.pad_ht, c.pad_wd,
+        c.in_offset, c.out_offset, c.act_min, c.act_max, c.mult.data(), c.shift.data(), NULL};
+    c.scratch.resize(tflite::DepthwiseConvSpecializedScratchSize(c.in_ch));
+    params.scratch = c.scratch.data();
+    kernel(params, c.input.data(), c.filter.data(), c.bias.data(), c.nn_out.data());
+}
+
+static ConvCase PackConv ( ConvCase c ) {
+    const int depth = c.filter_ht * c.filter_wd * c.in_ch;
+    c.packed_filter.resize(c.filter.size());
+    c.packed_bias.resize(c.out_ch);
+    tflite::PackWeightsFilter(c.filter.data(), c.out_ch, c.filter_ht * c.filter_wd, c.in_ch, c.packed_filter.data());
+    tflite::PackWeightsBias(c.filter.data(), c.bias.data(), c.out_ch, depth, c.in_offset, c.packed_bias.data());
+    return c;
+}
+
+static void ConvPacked ( ConvCase & c ) {
+    tflite::PackedConvParams params = {
+        c.input_ht, c.input_wd, c.in_ch, c.filter_ht, c.filter_wd, c.output_ht, c.output_wd, c.out_ch,
+        c.stride_ht, c.stride_wd, c.pad_ht, c.pad_wd, c.in_offset, c.out_offset, c.act_min, c.act_max,
+        c.mult.data(), c.shift.data()};
+    tflite::PackedConvPerChannel(params, c.input.data(), c.packed_filter.data(), c.packed_bias.data(),
+                                 c.nn_out.data());
+}
+
+static ConvCase RandConvCase ( bool depthwise ) {
+    ConvCase c;
+    c.input_ht = RandInt(1, 16);
+    c.input_wd = RandInt(1, 16);
+    c.in_ch = RandInt(1, 70);
+    c.out_ch = RandInt(1, 70);
+    c.filter_ht = RandInt(0, 1) ? 1 : RandInt(2, 10);
+    c.filter_wd = RandInt(0, 2) ? c.filter_ht : RandInt(1, 8);
+    c.stride_ht = RandInt(1, 2);
+    c.stride_wd = RandInt(1, 2);
+    c.same = RandInt(0, 1);
+    c.ch_mult = depthwise && RandInt(0, 3) == 0 ? RandInt(2, 3) : 1;
+    // VALID needs the filter to fit.
+    if (!c.same) {
+        if (c.input_ht < c.filter_ht) {c.input_ht = c.filter_ht;}
+        if (c.input_wd < c.filter_wd) {c.input_wd = c.filter_wd;}
+    }
+    ConvSetup(c, depthwise);
+    return c;
+}
+
+// A depthwise layer one of the specialized kernels covers.
+static ConvCase RandSpecializedCase ( ) {
+    ConvCase c;
+    c.input_ht = RandInt(1, 16);
+    c.input_wd = RandInt(1, 16);
+    c.in_ch = RandInt(1, 70);
+    c.filter_ht = c.filter_wd = 3;
+    c.stride_ht = c.stride_wd = RandInt(1, 2);
+    c.same = RandInt(0, 1);
+    c.ch_mult = RandInt(0, 3) == 0 ? 2 : 1;
+    if (!c.same) {
+        if (c.input_ht < c.filter_ht) {c.input_ht = c.filter_ht;}
+        if (c.input_wd < c.filter_wd) {c.input_wd = c.filter_wd;}
+    }
+    ConvSetup(c, true);
+    return c;
+}
+
+/* fully connected */
+
+struct FcCase {
+    int row_len, out_ch;
+    int32_t in_offset, filter_offset, out_offset, mult, shift, act_min, act_max;
+    std::vector<int8_t> input, filter, ref_out, nn_out;
+    std::vector<int32_t> bias;
+    // PackFc() weights.
+    std::vector<int8_t> packed_filter;
+    std::vector<int32_t> packed_bias;
+};
+
+static FcCase RandFcCase ( int row_len, int out_ch ) {
+    FcCase c;
+    c.row_len = row_len;
+    c.out_ch = out_ch;
+    c.in_offset = -RandInt(-128, 127);
+    c.filter_offset = RandInt(0, 3) ? 0 : RandInt(-127, 127);
+    c.out_offset = RandInt(-128, 127);
+    RandQuant(&c.mult, &c.shift, -12, 0);
+    RandActivation(&c.act_min, &c.act_max);
+    c.input.resize(row_len);
+    c.filter.resize(row_len * out_ch);
+    c.ref_out.resize(out_ch);
+    c.nn_out.resize(out_ch);
+    c.bias.resize(out_ch);
+    RandFill(c.input);
+    RandFill(c.filter);
+    for (int32_t & b : c.bias) {b = RandInt(-50000, 50000);}
+    return c;
+}
+
+static void FcReference ( FcCase & c ) {
+    tflite::FullyConnectedParams params = {};
+    params.input_offset = c.in_offset;
+    params.weights_offset = c.filter_offset;
+    params.output_offset = c.out_offset;
+    params.output_multiplier = c.mult;
+    params.output_shift = c.shift;
+    params.quantized_activation_min = c.act_min;
+    params.quantized_activation_max = c.act_max;
+    tflite::reference_integer_ops::FullyConnected(
+        params, Shape({1, c.row_len}), c.input.data(),
+        Shape({c.out_ch, c.row_len}), c.filter.data(),
+        Shape({c.out_ch}), c.bias.data(),
+        Shape({1, c.out_ch}), c.ref_out.data());
+}
+
+static void FcEspNn ( FcCase & c ) {
+    esp_nn_fully_connected_s8(c.input.data(), c.in_offset, c.row_len, c.filter.data(), c.filter_offset,
+                              c.bias.data(), c.nn_out.data(), c.out_ch, c.out_offset, c.shift, c.mult,
+                              c.act_min, c.act_max);
+}
+
+// The packed weights need symmetric filters.
+static FcCase PackFc ( FcCase c ) {
+    c.filter_offset = 0;
+    c.packed_filter.resize(c.filter.size());
+    c.packed_bias.resize(c.out_ch);
+    tflite::PackWeightsFilter(c.filter.data(), c.out_ch, 1, c.row_len, c.packed_filter.data());
+    tflite::PackWeightsBias(c.filter.data(), c.bias.data(), c.out_ch, c.row_len, c.in_offset, c.packed_bias.data());
+    return c;
+}
+
+static void FcPacked ( FcCase & c ) {
+    tflite::PackedFullyConnectedParams params = {c.row_len, c.out_ch, c.out_offset, c.mult, c.shift,
+                                                 c.act_min, c.act_max};
+    tflite::PackedFullyConnected(params, c.input.data(), c.packed_filter.data(), c.packed_bias.data(),
+                                 c.nn_out.data());
+}
+
+/* pooling */
+
+struct PoolCase {
+    int input_ht, input_wd, channels, filter_ht, filter_wd, stride_ht, stride_wd;
+    int output_ht, output_wd, pad_ht, pad_wd;
+    int32_t act_min, act_max;
+    std::vector<int8_t> input, ref_out, nn_out;
+};
+
+static PoolCase RandPoolCase ( ) {
+    PoolCase c;
+    c.filter_ht = RandInt(1, 4);
+    c.filter_wd = RandInt(1, 4);
+    c.stride_ht = RandInt(1, 3);
+    c.stride_wd = RandInt(1, 3);
+    c.input_ht = RandInt(c.filter_ht, 14);
+    c.input_wd = RandInt(c.filter_wd, 14);
+    c.channels = RandInt(1, 100);
+    const bool same = RandInt(0, 1);
+    c.output_ht = OutSize(c.input_ht, c.filter_ht, c.stride_ht, same, &c.pad_ht);
+    c.output_wd = OutSize(c.input_wd, c.filter_wd, c.stride_wd, same, &c.pad_wd);
+    RandActivation(&c.act_min, &c.act_max);
+    c.input.resize(c.input_ht * c.input_wd * c.channels);
+    c.ref_out.resize(c.output_ht * c.output_wd * c.channels);
+    c.nn_out.resize(c.ref_out.size());
+    RandFill(c.input);
+    return c;
+}
+
+static tflite::PoolParams PoolParams ( const PoolCase & c ) {
+    tflite::PoolParams params = {};
+    params.padding_values.height = c.pad_ht;
+    params.padding_values.width = c.pad_wd;
+    params.stride_height = c.stride_ht;
+    params.stride_width = c.stride_wd;
+    params.filter_height = c.filter_ht;
+    params.filter_width = c.filter_wd;
+    params.quantized_activation_min = c.act_min;
+    params.quantized_activation_max = c.act_max;
+    return params;
+}
+
+static void AvgPoolReference ( PoolCase & c ) {
+    tflite::reference_integer_ops::AveragePool(
+        PoolParams(c), Shape({1, c.input_ht, c.input_wd, c.channels}), c.input.data(),
+        Shape({1, c.output_ht, c.output_wd, c.channels}), c.ref_out.data());
+}
+
+static void AvgPoolEspNn ( PoolCase & c ) {
+    esp_nn_avg_pool_s8(c.input.data(), c.input_wd, c.input_ht, c.nn_out.data(), c.output_wd, c.output_ht,
+                       c.stride_wd, c.stride_ht, c.filter_wd, c.filter_ht, c.pad_wd, c.pad_ht,
+                       c.act_min, c.act_max, c.channels);
+}
+
+static void MaxPoolReference ( PoolCase & c ) {
+    tflite::reference_integer_ops::MaxPool(
+        PoolParams(c), Shape({1, c.input_ht, c.input_wd, c.channels}), c.input.data(),
+        Shape({1, c.output_ht, c.output_wd, c.channels}), c.ref_out.data());
+}
+
+static void MaxPoolEspNn ( PoolCase & c ) {
+    esp_nn_max_pool_s8(c.input.data(), c.input_wd, c.input_ht, c.nn_out.data(), c.output_wd, c.output_ht,
+                       c.stride_wd, c.stride_ht, c.filter_wd, c.filter_ht, c.pad_wd, c.pad_ht,
+                       c.act_min, c.act_max, c.channels);
+}
+
+/* mean */
+
+// MEAN over height and width, the generic reducer of EvalMeanHelper against MeanInt8OverHeightWidth.
+struct MeanCase {
+    tflite::MeanInt8Params params;
+    bool keep_dims;
+    std::vector<int8_t> input, ref_out, nn_out;
+    std::vector<int32_t> sums;
+    std::vector<int> temp_index, resolved_axis;
+};
+
+static MeanCase MakeMeanCase ( int batches, int height, int width, int depth, bool keep_dims, float input_scale,
+                               int32_t input_zp, float output_scale, int32_t output_zp ) {
+    MeanCase c;
+    c.params = {};
+    c.params.batches = batches;
+    c.params.height = height;
+    c.params.width = width;
+    c.params.depth = depth;
+    c.keep_dims = keep_dims;
+    c.params.input_zero_point = input_zp;
+    c.params.output_zero_point = output_zp;
+    c.params.input_scale = input_scale;
+    c.params.output_scale = output_scale;
+    // As PrepareMeanOrSumHelper and EvalMeanHelper.
+    tflite::QuantizeMultiplier((double) input_scale / (double) output_scale, &c.params.multiplier, &c.params.shift);
+    if (keep_dims) {
+        c.params.stage = tflite::MeanOutputStage::kMultiplier;
+    } else if (input_zp == output_zp && input_scale == output_scale) {
+        c.params.stage = tflite::MeanOutputStage::kSameQuantization;
+    } else {
+        c.params.stage = tflite::MeanOutputStage::kFloat;
+    }
+    c.input.resize(batches * height * width * depth);
+    c.ref_out.resize(batches * depth);
+    c.nn_out.resize(c.ref_out.size());
+    c.sums.resize(c.ref_out.size());
+    c.temp_index.resize(4);
+    c.resolved_axis.resize(2);
+    RandFill(c.input);
+    return c;
+}
+
+static MeanCase RandMeanCase ( ) {
+    const float input_scale = 0.001f * RandInt(1, 100);
+    const int32_t input_zp = RandInt(-128, 127);
+    const bool same = RandInt(0, 3) == 0;
+    return MakeMeanCase(RandInt(1, 2), RandInt(1, 9), RandInt(1, 9), RandInt(1, 300), RandInt(0, 1), input_scale,
+                        input_zp, same ? input_scale : 0.001f * RandInt(1, 100), same ? input_zp : RandInt(-128, 127));
+}
+
+static void MeanReference ( MeanCase & c ) {
+    const tflite::MeanInt8Params & p = c.params;
+    const int input_dims[] = {p.batches, p.height, p.width, p.depth};
+    const int reduced_dims[] = {p.batches, p.depth};
+    const int axis[] = {1, 2};
+    if (c.keep_dims) {
+        tflite::MeanParams op_params = {};
+        op_params.axis_count = 2;
+        op_params.axis[0] = 1;
+        op_params.axis[1] = 2;
+        tflite::reference_integer_ops::Mean(op_params, p.multiplier, p.shift, Shape({p.batches, p.height, p.width, p.depth}),
+                                            c.input.data(), p.input_zero_point, Shape({p.batches, 1, 1, p.depth}),
+                                            c.ref_out.data(), p.output_zero_point);
+    } else if (p.stage == tflite::MeanOutputStage::kSameQuantization) {
+        tflite::reference_ops::Mean(c.input.data(), input_dims, 4, c.ref_out.data(), reduced_dims, 2, axis, 2, false,
+                                    c.temp_index.data(), c.resolved_axis.data(), c.sums.data());
+    } else {
+        tflite::reference_ops::QuantizedMeanOrSum(c.input.data(), p.input_zero_point, p.input_scale, input_dims, 4,
+                                                  c.ref_out.data(), p.output_zero_point, p.output_scale, reduced_dims,
+                                                  2, axis, 2, false, c.temp_index.data(), c.resolved_axis.data(),
+                                                  c.sums.data(), false);
+    }
+}
+
+static void MeanFast ( MeanCase & c ) {
+    tflite::MeanInt8OverHeightWidth(c.params, c.input.data(), c.sums.data(), c.nn_out.data());
+}
+
+/* elementwise */
+
+struct ElementwiseCase {
+    tflite::ArithmeticParams params;
+    std::vector<int8_t> input1, input2, ref_out, nn_out;
+};
+
+static ElementwiseCase RandElementwiseCase ( int size, bool add ) {
+    ElementwiseCase c;
+    c.params = {};
+    c.params.input1_offset = -RandInt(-128, 127);
+    c.params.input2_offset = -RandInt(-128, 127);
+    c.params.output_offset = RandInt(-128, 127);
+    RandActivation(&c.params.quantized_activation_min, &c.params.quantized_activation_max);
+    if (add) {
+        // As the ADD kernel prepares them: 20 bits of headroom, right shifts only.
+        c.params.left_shift = 20;
+        RandQuant(&c.params.input1_multiplier, &c.params.input1_shift, -6, 0);
+        RandQuant(&c.params.input2_multiplier, &c.params.input2_shift, -6, 0);
+        RandQuant(&c.params.output_multiplier, &c.params.output_shift, -26, -18);
+    } else {
+        RandQuant(&c.params.output_multiplier, &c.params.output_shift, -16, 0);
+    }
+    c.input1.resize(size);
+    c.input2.resize(size);
+    c.ref_out.resize(size);
+    c.nn_out.resize(size);
+    RandFill(c.input1);
+    RandFill(c.input2);
+    return c;
+}
+
+static void AddReference ( ElementwiseCase & c ) {
+    const tflite::RuntimeShape shape = Shape({1, (int32_t) c.input1.size()});
+    tflite::reference_integer_ops::Add(c.params, shape, c.input1.data(), shape, c.input2.data(),
+                                       shape, c.ref_out.data());
+}
+
+static void AddEspNn ( ElementwiseCase & c ) {
+    const tflite::ArithmeticParams & p = c.params;
+    esp_nn_add_elementwise_s8(c.input1.data(), c.input2.data(), p.input1_offset, p.input2_offset,
+                              p.input1_multiplier, p.input2_multiplier, p.input1_shift, p.input2_shift,
+                              p.left_shift, c.nn_out.data(), p.output_offset, p.output_multiplier,
+                              p.output_shift, p.quantized_activation_min, p.quantized_activation_max,
+                              (int32_t) c.input1.size());
+}
+
+static void MulReference ( ElementwiseCase & c ) {
+    const tflite::RuntimeShape shape = Shape({1, (int32_t) c.input1.size()});
+    tflite::reference_integer_ops::Mul(c.params, shape, c.input1.data(), shape, c.input2.data(),
+                                       shape, c.ref_out.data());
+}
+
+static void MulEspNn ( ElementwiseCase & c ) {
+    const tflite::ArithmeticParams & p = c.params;
+    esp_nn_mul_elementwise_s8(c.input1.data(), c.input2.data(), p.input1_offset, p.input2_offset,
+                              c.nn_out.data(), p.output_offset, p.output_multiplier, p.output_shift,
+                              p.quantized_activation_min, p.quantized_activation_max,
+                              (int32_t) c.input1.size());
+}
+
+/* softmax */
+
+struct SoftmaxCase {
+    int rows, width;
+    tflite::SoftmaxParams params;
+    std::vector<int8_t> input, ref_out, nn_out;
+};
+
+static SoftmaxCase RandSoftmaxCase ( int rows, int width ) {
+    SoftmaxCase c;
+    c.rows = rows;
+    c.width = width;
+    c.params = {};
+    // Input scales from 1/256 to 1/2 with beta 1, as CalculateSoftmaxParams prepares them.
+    const double input_scale = 1.0 / (1 << RandInt(1, 8));
+    int input_left_shift;
+    tflite::PreprocessSoftmaxScaling(1.0, input_scale, 5, &c.params.input_multiplier, &input_left_shift);
+    c.params.input_left_shift = input_left_shift;
+    c.params.diff_min = -1.0 * tflite::CalculateInputRadius(5, input_left_shift, 31);
+    c.input.resize(rows * width);
+    c.ref_out.resize(c.input.size());
+    c.nn_out.resize(c.input.size());
+    RandFill(c.input);
+    return c;
+}
+
+static void SoftmaxReference ( SoftmaxCase & c ) {
+    const tflite::RuntimeShape shape = Shape({c.rows, c.width});
+    tflite::reference_ops::Softmax(c.params, shape, c.input.data(), shape, c.ref_out.data());
+}
+
+static void SoftmaxEspNn ( SoftmaxCase & c ) {
+    esp_nn_softmax_s8(c.input.data(), c.rows, c.width, c.params.input_multiplier, c.params.input_left_shift,
+                      c.params.diff_min, c.nn_out.data());
+}
+
+/* checks and timings */
+
+template <typename Case>
+static bool Check ( const char * what, Case & c, void (*reference)(Case &), void (*esp_nn)(Case &) ) {
+    reference(c);
+    esp_nn(c);
+    return Compare(what, c.ref_out, c.nn_out);
+}
+
+// Best of five passes of repeats calls, per call.
+template <typename Case>
+static double BestOf ( int repeats, Case & c, void (*kernel)(Case &) ) {
+    int64_t best = INT64_MAX;
+    for (int pass = 0; pass < 5; pass++) {
+        int64_t start = esp_timer_get_time();
+        for (int r = 0; r < repeats; r++) {kernel(c);}
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (elapsed < best) {best = elapsed;}
+    }
+    return (double) best / repeats;
+}
+
+template <typename Case>
+static void Time ( const char * what, int repeats, Case c, void (*reference)(Case &), void (*esp_nn)(Case &) ) {
+    const double reference_us = BestOf(repeats, c, reference);
+    const double esp_nn_us = BestOf(repeats, c, esp_nn);
+    printf("%-32s %10.2f %10.2f %8.2fx\n", what, reference_us, esp_nn_us,
+           esp_nn_us > 0 ? reference_us / esp_nn_us : 0.0);
+}
+
+static ConvCase ModelConv ( int input_ht, int input_wd, int in_ch, int out_ch, int filter, int stride, int ch_mult ) {
+    ConvCase c;
+    c.input_ht = input_ht;
+    c.input_wd = input_wd;
+    c.in_ch = in_ch;
+    c.out_ch = out_ch;
+    c.filter_ht = c.filter_wd = filter;
+    c.stride_ht = c.stride_wd = stride;
+    c.same = true;
+    c.ch_mult = ch_mult;
+    ConvSetup(c, ch_mult > 0);
+    return c;
+}
+
+// Global average pool.
+static PoolCase ModelAvgPool ( int input_ht, int input_wd, int channels ) {
+    PoolCase c;
+    c.input_ht = c.filter_ht = input_ht;
+    c.input_wd = c.filter_wd = input_wd;
+    c.stride_ht = c.stride_wd = 1;
+    c.channels = channels;
+    c.output_ht = c.output_wd = 1;
+    c.pad_ht = c.pad_wd = 0;
+    c.act_min = -128;
+    c.act_max = 127;
+    c.input.resize(input_ht * input_wd * channels);
+    c.ref_out.resize(channels);
+    c.nn_out.resize(channels);
+    RandFill(c.input);
+    return c;
+}
+
+int main ( int argc, char ** argv ) {
+    int repeats = 20;
+    int rounds = 300;
+
+    for (int arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "-n") && arg + 1 < argc) {
+            repeats = atoi(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-r") && arg + 1 < argc) {
+            rounds = atoi(argv[++arg]);
+        } else {
+            fprintf(stderr, "usage: %s [-n repeats] [-r rounds]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (repeats < 1) {repeats = 1;}
+
+    int failures = 0;
+    for (int round = 0; round < rounds; round++) {
+        ConvCase conv = RandConvCase(false);
+        failures += !Check("conv", conv, ConvReference, ConvEspNn);
+        ConvCase depthwise = RandConvCase(true);
+        failures += !Check("depthwise", depthwise, DepthwiseReference, DepthwiseEspNn);
+        ConvCase specialized = RandSpecializedCase();
+        failures += !Check("depthwise specialized", specialized, DepthwiseReference, DepthwiseSpecialized);
+        ConvCase packed = PackConv(RandConvCase(false));
+        failures += !Check("conv packed", packed, ConvReference, ConvPacked);
+        FcCase fc = RandFcCase(RandInt(1, 300), RandInt(1, 40));
+        failures += !Check("fully connected", fc, FcReference, FcEspNn);
+        FcCase fc_packed = PackFc(RandFcCase(RandInt(1, 300), RandInt(1, 40)));
+        failures += !Check("fully connected packed", fc_packed, FcReference, FcPacked);
+        PoolCase avg = RandPoolCase();
+        failures += !Check("avg pool", avg, AvgPoolReference, AvgPoolEspNn);
+        PoolCase max = RandPoolCase();
+        failures += !Check("max pool", max, MaxPoolReference, MaxPoolEspNn);
+        ElementwiseCase add = RandElementwiseCase(RandInt(1, 300), true);
+        failures += !Check("add", add, AddReference, AddEspNn);
+        ElementwiseCase mul = RandElementwiseCase(RandInt(1, 300), false);
+        failures += !Check("mul", mul, MulReference, MulEspNn);
+        SoftmaxCase softmax = RandSoftmaxCase(RandInt(1, 4), RandInt(1, 300));
+        failures += !Check("softmax", softmax, SoftmaxReference, SoftmaxEspNn);
+        MeanCase mean = RandMeanCase();
+        failures += !Check("mean", mean, MeanReference, MeanFast);
+    }
+    printf("%d random rounds, %d mismatches\n\n", rounds, failures);
+
+    // Layers of the shape of the deployed model, 49x40 features.
+    printf("%-32s %10s %10s %9s\n", "kernel (us per call)", "reference", "esp_nn", "speedup");
+    Time("conv 3x3/2 49x40x1 -> 16", repeats, ModelConv(49, 40, 1, 16, 3, 2, 0), ConvReference, ConvEspNn);
+    Time("depthwise 3x3 25x20x16", repeats, ModelConv(25, 20, 16, 16, 3, 1, 1), DepthwiseReference, DepthwiseEspNn);
+    Time("conv 1x1 25x20x16 -> 32", repeats, ModelConv(25, 20, 16, 32, 1, 1, 0), ConvReference, ConvEspNn);
+    Time("depthwise 3x3/2 25x20x32", repeats, ModelConv(25, 20, 32, 32, 3, 2, 1), DepthwiseReference, DepthwiseEspNn);
+    Time("conv 1x1 13x10x32 -> 64", repeats, ModelConv(13, 10, 32, 64, 1, 1, 0), ConvReference, ConvEspNn);
+    Time("fully connected 1024 -> 12", repeats, RandFcCase(1024, 12), FcReference, FcEspNn);
+    Time("avg pool 7x5x64", repeats, ModelAvgPool(7, 5, 64), AvgPoolReference, AvgPoolEspNn);
+    Time("add 4096", repeats, RandElementwiseCase(4096, true), AddReference, AddEspNn);
+    Time("mul 4096", repeats, RandElementwiseCase(4096, false), MulReference, MulEspNn);
+    Time("softmax 1x12", repeats, RandSoftmaxCase(1, 12), SoftmaxReference, SoftmaxEspNn);
+
+    // Every depthwise layer of the deployed model, stride 2 ones with their PAD fused.
+    printf("\n%-32s %10s %10s %9s\n", "depthwise (us per call)", "esp_nn", "specialized", "speedup");
+    Time("3x3 50x20x16", repeats, ModelConv(50, 20, 16, 16, 3, 1, 1), DepthwiseEspNn, DepthwiseSpecialized);
+    Time("3x3/2 50x20x48", repeats, ModelConv(50, 20, 48, 48, 3, 2, 1), DepthwiseEspNn, DepthwiseSpecialized);
+    Time("3x3 25x10x48", repeats, ModelConv(25, 10, 48, 48, 3, 1, 1), DepthwiseEspNn, DepthwiseSpecialized);
+    Time("3x3/2 25x10x48", repeats, ModelConv(25, 10, 48, 48, 3, 2, 1), DepthwiseEspNn, DepthwiseSpecialized);
+    Time("3x3 13x5x96", repeats, ModelConv(13, 5, 96, 96, 3, 1, 1), DepthwiseEspNn, DepthwiseSpecialized);
+    Time("3x3/2 13x5x96", repeats, ModelConv(13, 5, 96, 96, 3, 2, 1), DepthwiseEspNn, DepthwiseSpecialized);
+    Time("3x3 7x3x144", repeats, ModelConv(7, 3, 144, 144, 3, 1, 1), DepthwiseEspNn, DepthwiseSpecialized);
+    Time("3x3 7x3x192", repeats, ModelConv(7, 3, 192, 192, 3, 1, 1), DepthwiseEspNn, DepthwiseSpecialized);
+    Time("3x3/2 7x3x192", repeats, ModelConv(7, 3, 192, 192, 3, 2, 1), DepthwiseEspNn, DepthwiseSpecialized);
+    Time("3x3 4x2x336", repeats, ModelConv(4, 2, 336, 336, 3, 1, 1), DepthwiseEspNn, DepthwiseSpecialized);
+
+    // Every CONV_2D shape of the deployed model and its FULLY_CONNECTED, as iavoz_pack_weights
+    // lays them out.
+    printf("\n%-32s %10s %10s %9s\n", "conv (us per call)", "esp_nn", "packed", "speedup");
+    Time("3x3/2 99x40x1 -> 16", repeats, PackConv(ModelConv(99, 40, 1, 16, 3, 2, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 50x20x16 -> 8", repeats, PackConv(ModelConv(50, 20, 16, 8, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 50x20x8 -> 48", repeats, PackConv(ModelConv(50, 20, 8, 48, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 25x10x48 -> 8", repeats, PackConv(ModelConv(25, 10, 48, 8, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 25x10x8 -> 48", repeats, PackConv(ModelConv(25, 10, 8, 48, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 13x5x48 -> 16", repeats, PackConv(ModelConv(13, 5, 48, 16, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 13x5x16 -> 96", repeats, PackConv(ModelConv(13, 5, 16, 96, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 13x5x96 -> 16", repeats, PackConv(ModelConv(13, 5, 96, 16, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 7x3x96 -> 24", repeats, PackConv(ModelConv(7, 3, 96, 24, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 7x3x24 -> 144", repeats, PackConv(ModelConv(7, 3, 24, 144, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 7x3x144 -> 24", repeats, PackConv(ModelConv(7, 3, 144, 24, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 7x3x144 -> 32", repeats, PackConv(ModelConv(7, 3, 144, 32, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 7x3x32 -> 192", repeats, PackConv(ModelConv(7, 3, 32, 192, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 7x3x192 -> 32", repeats, PackConv(ModelConv(7, 3, 192, 32, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 4x2x192 -> 56", repeats, PackConv(ModelConv(4, 2, 192, 56, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 4x2x56 -> 336", repeats, PackConv(ModelConv(4, 2, 56, 336, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 4x2x336 -> 56", repeats, PackConv(ModelConv(4, 2, 336, 56, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 4x2x336 -> 112", repeats, PackConv(ModelConv(4, 2, 336, 112, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("1x1 4x2x112 -> 1280", repeats, PackConv(ModelConv(4, 2, 112, 1280, 1, 1, 0)), ConvEspNn, ConvPacked);
+    Time("fully connected 1280 -> 5", repeats, PackFc(RandFcCase(1280, 5)), FcEspNn, FcPacked);
+
+    // The classifier head of the deployed model, without and with keep_dims, and a smaller one.
+    printf("\n%-32s %10s %10s %9s\n", "mean (us per call)", "generic", "fast", "speedup");
+    Time("4x2x1280", repeats, MakeMeanCase(1, 4, 2, 1280, false, 0.00274055f, -128, 0.000861246f, -128),
+         MeanReference, MeanFast);
+    Time("4x2x1280 keep_dims", repeats, MakeMeanCase(1, 4, 2, 1280, true, 0.00274055f, -128, 0.000861246f, -128),
+         MeanReference, MeanFast);
+    Time("7x5x64", repeats, MakeMeanCase(1, 7, 5, 64, false, 0.0235f, -128, 0.0235f, -128), MeanReference, MeanFast);
+
+    return failures ? 1 : 0;
+}
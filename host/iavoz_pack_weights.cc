@@ -0,0 +1,288 @@
+/********************************************************************************************
+* iavoz_pack_weights: re-lays the int8 CONV_2D and FULLY_CONNECTED weights of a model for
+* the packed kernels of tflite-lib.
+*
+* Usage: iavoz_pack_weights [-c] in.(cc|tflite) out.(cc|tflite)
+*
+* The input is a .tflite file or a model source with a g_model array, as in
+* components/ges_iavoz. Every filter is written in the channel interleaved layout of
+* kernels/packed_weights.h and its bias gets bias + input_offset * sum(filter) folded in,
+* then the operators are listed in the PackedWeights metadata so MicroInterpreter hands
+* them to the packed kernels. Operators that share their weights, lack a bias or have
+* asymmetric filters are left as they are.
+*
+* With -c nothing is written: the model in out is compared with the one that would be, and
+* a stale out exits with 1. The host build runs this on components/ges_iavoz/mobilnet_packed.cc.
+***********************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esp_log.h"
+
+#include "flatbuffers/flatbuffers.h"
+#include "tensorflow/lite/micro/kernels/packed_weights.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+static const char * TAG = "IAVOZ_PACK";
+
+static bool EndsWith ( const std::string & s, const char * suffix ) {
+    const size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static bool ReadFile ( const std::string & path, std::string * contents ) {
+    FILE * f = fopen(path.c_str(), "rb");
+    if (!f) {return false;}
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        contents->append(chunk, n);
+    }
+    fclose(f);
+    return true;
+}
+
+// The bytes of the g_model array of a model source.
+static bool ParseModelSource ( const std::string & source, std::vector<uint8_t> * model ) {
+    size_t pos = source.find("g_model[]");
+    if (pos == std::string::npos) {return false;}
+    pos = source.find('{', pos);
+    const size_t end = source.find('}', pos);
+    if (pos == std::string::npos || end == std::string::npos) {return false;}
+
+    for (pos = source.find("0x", pos); pos < end; pos = source.find("0x", pos)) {
+        model->push_back((uint8_t) strtoul(source.c_str() + pos, NULL, 16));
+        pos += 2;
+    }
+    return !model->empty();
+}
+
+static bool WriteModelSource ( const std::string & path, const std::string & input, const uint8_t * data, size_t size ) {
+    FILE * f = fopen(path.c_str(), "w");
+    if (!f) {return false;}
+
+    const size_t slash = input.find_last_of('/');
+    fprintf(f, "// Generated by iavoz_pack_weights from %s, do not edit. The CONV_2D and\n"
+               "// FULLY_CONNECTED weights are laid out for the kernels of\n"
+               "// tensorflow/lite/micro/kernels/packed_weights.h.\n\n",
+            slash == std::string::npos ? input.c_str() : input.c_str() + slash + 1);
+    fprintf(f, "#include \"model.h\"\n\n"
+               "// We need to keep the data array aligned on some architectures.\n"
+               "#ifdef __has_attribute\n"
+               "#define HAVE_ATTRIBUTE(x) __has_attribute(x)\n"
+               "#else\n"
+               "#define HAVE_ATTRIBUTE(x) 0\n"
+               "#endif\n"
+               "#if HAVE_ATTRIBUTE(aligned) || (defined(__GNUC__) && !defined(__clang__))\n"
+               "#define DATA_ALIGN_ATTRIBUTE __attribute__((aligned(16)))\n"
+               "#else\n"
+               "#define DATA_ALIGN_ATTRIBUTE\n"
+               "#endif\n\n");
+    fprintf(f, "const unsigned char g_model[] DATA_ALIGN_ATTRIBUTE = {");
+    for (size_t i = 0; i < size; i++) {
+        fprintf(f, "%s0x%02x", i == 0 ? "\n  " : (i % 12 ? ", " : ",\n  "), data[i]);
+    }
+    fprintf(f, "\n};\nconst int g_model_len = %zu;\n", size);
+    return fclose(f) == 0;
+}
+
+// The tensor buffer holds constant data that no other tensor reads.
+static bool OwnsBuffer ( const tflite::ModelT & model, const tflite::TensorT & tensor ) {
+    if (tensor.buffer == 0 || tensor.buffer >= model.buffers.size() || model.buffers[tensor.buffer]->data.empty()) {
+        return false;
+    }
+    int users = 0;
+    for (const auto & subgraph : model.subgraphs) {
+        for (const auto & other : subgraph->tensors) {
+            users += other->buffer == tensor.buffer;
+        }
+    }
+    return users == 1;
+}
+
+static int TensorReaders ( const tflite::SubGraphT & subgraph, int tensor ) {
+    int readers = 0;
+    for (const auto & op : subgraph.operators) {
+        for (int input : op->inputs) {
+            readers += input == tensor;
+        }
+    }
+    return readers;
+}
+
+static bool PackOperator ( tflite::ModelT & model, tflite::SubGraphT & subgraph, tflite::OperatorT & op,
+                           tflite::BuiltinOperator code ) {
+    if (op.inputs.size() != 3 || op.inputs[0] < 0 || op.inputs[1] < 0 || op.inputs[2] < 0) {return false;}
+    if (code == tflite::BuiltinOperator_CONV_2D) {
+        const tflite::Conv2DOptionsT * options = op.builtin_options.AsConv2DOptions();
+        if (!options || options->dilation_w_factor != 1 || options->dilation_h_factor != 1) {return false;}
+    } else {
+        const tflite::FullyConnectedOptionsT * options = op.builtin_options.AsFullyConnectedOptions();
+        if (!options || options->weights_format != tflite::FullyConnectedOptionsWeightsFormat_DEFAULT) {return false;}
+    }
+
+    const tflite::TensorT & input = *subgraph.tensors[op.inputs[0]];
+    tflite::TensorT & filter = *subgraph.tensors[op.inputs[1]];
+    tflite::TensorT & bias = *subgraph.tensors[op.inputs[2]];
+    if (input.type != tflite::TensorType_INT8 || filter.type != tflite::TensorType_INT8 ||
+        bias.type != tflite::TensorType_INT32 || filter.shape.empty() || !input.quantization ||
+        input.quantization->zero_point.size() != 1 || !filter.quantization) {
+        return false;
+    }
+    for (int64_t zero_point : filter.quantization->zero_point) {
+        if (zero_point != 0) {return false;}
+    }
+    if (!OwnsBuffer(model, filter) || !OwnsBuffer(model, bias) ||
+        TensorReaders(subgraph, op.inputs[1]) != 1 || TensorReaders(subgraph, op.inputs[2]) != 1) {
+        return false;
+    }
+
+    std::vector<uint8_t> & filter_data = model.buffers[filter.buffer]->data;
+    std::vector<uint8_t> & bias_data = model.buffers[bias.buffer]->data;
+    const int output_depth = filter.shape[0];
+    if (output_depth <= 0 || filter_data.size() % output_depth ||
+        bias_data.size() != output_depth * sizeof(int32_t)) {
+        return false;
+    }
+    const int depth = filter_data.size() / output_depth;
+    // The CONV_2D filters are OHWI, packed by tap.
+    const int tap_depth = code == tflite::BuiltinOperator_CONV_2D ? filter.shape.back() : depth;
+    if (tap_depth <= 0 || depth % tap_depth) {return false;}
+
+    std::vector<int8_t> packed(filter_data.size());
+    std::vector<int32_t> packed_bias(output_depth);
+    const int8_t * weights = (const int8_t *) filter_data.data();
+    const int32_t input_offset = (int32_t) -input.quantization->zero_point[0];
+    if (!tflite::PackWeightsBias(weights, (const int32_t *) bias_data.data(), output_depth, depth,
+                                 input_offset, packed_bias.data())) {
+        return false;
+    }
+    tflite::PackWeightsFilter(weights, output_depth, depth / tap_depth, tap_depth, packed.data());
+
+    memcpy(filter_data.data(), packed.data(), packed.size());
+    memcpy(bias_data.data(), packed_bias.data(), bias_data.size());
+    return true;
+}
+
+// The model of a .tflite file or of the g_model array of a model source.
+static bool ReadModel ( const std::string & path, std::vector<uint8_t> * model ) {
+    std::string contents;
+    if (!ReadFile(path, &contents)) {
+        ESP_LOGE(TAG, "Could not read %s", path.c_str());
+        return false;
+    }
+    if (EndsWith(path, ".tflite")) {
+        model->assign(contents.begin(), contents.end());
+    } else if (!ParseModelSource(contents, model)) {
+        ESP_LOGE(TAG, "No g_model array in %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main ( int argc, char ** argv ) {
+    bool check = false;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-c")) {
+            check = true;
+        } else {
+            break;
+        }
+    }
+    if (argc - arg != 2) {
+        fprintf(stderr, "usage: %s [-c] in.(cc|tflite) out.(cc|tflite)\n", argv[0]);
+        return 2;
+    }
+    const std::string in_path = argv[arg];
+    const std::string out_path = argv[arg + 1];
+
+    std::vector<uint8_t> bytes;
+    if (!ReadModel(in_path, &bytes)) {return 1;}
+
+    flatbuffers::Verifier verifier(bytes.data(), bytes.size());
+    if (!tflite::VerifyModelBuffer(verifier)) {
+        ESP_LOGE(TAG, "%s is not a valid model", in_path.c_str());
+        return 1;
+    }
+    std::unique_ptr<tflite::ModelT> model(tflite::GetModel(bytes.data())->UnPack());
+
+    for (const auto & metadata : model->metadata) {
+        if (metadata->name == tflite::kPackedWeightsMetadata) {
+            ESP_LOGE(TAG, "%s is already packed", in_path.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<int32_t> listed = {tflite::kPackedWeightsVersion, tflite::kPackedWeightsChannelBlock, 0};
+    int candidates = 0;
+    size_t packed_bytes = 0;
+    for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs.size(); subgraph_idx++) {
+        tflite::SubGraphT & subgraph = *model->subgraphs[subgraph_idx];
+        for (size_t op_idx = 0; op_idx < subgraph.operators.size(); op_idx++) {
+            tflite::OperatorT & op = *subgraph.operators[op_idx];
+            const tflite::BuiltinOperator code = tflite::GetBuiltinCode(model->operator_codes[op.opcode_index].get());
+            if (code != tflite::BuiltinOperator_CONV_2D && code != tflite::BuiltinOperator_FULLY_CONNECTED) {continue;}
+
+            candidates++;
+            if (!PackOperator(*model, subgraph, op, code)) {
+                ESP_LOGW(TAG, "Operator %zu of subgraph %zu (%s) left unpacked", op_idx, subgraph_idx,
+                         tflite::EnumNameBuiltinOperator(code));
+                continue;
+            }
+            listed.push_back((int32_t) subgraph_idx);
+            listed.push_back((int32_t) op_idx);
+            listed[2]++;
+            packed_bytes += model->buffers[subgraph.tensors[op.inputs[1]]->buffer]->data.size();
+        }
+    }
+
+    std::unique_ptr<tflite::BufferT> buffer(new tflite::BufferT());
+    buffer->data.resize(listed.size() * sizeof(int32_t));
+    memcpy(buffer->data.data(), listed.data(), buffer->data.size());
+    std::unique_ptr<tflite::MetadataT> metadata(new tflite::MetadataT());
+    metadata->name = tflite::kPackedWeightsMetadata;
+    metadata->buffer = model->buffers.size();
+    model->buffers.push_back(std::move(buffer));
+    model->metadata.push_back(std::move(metadata));
+
+    // The flatbuffers of tflite-lib have no implicit default allocator.
+    flatbuffers::DefaultAllocator allocator;
+    flatbuffers::FlatBufferBuilder builder(bytes.size(), &allocator);
+    tflite::FinishModelBuffer(builder, tflite::Model::Pack(builder, model.get()));
+
+    if (check) {
+        std::vector<uint8_t> existing;
+        if (!ReadModel(out_path, &existing)) {return 1;}
+        if (existing.size() != builder.GetSize() ||
+            memcmp(existing.data(), builder.GetBufferPointer(), existing.size()) != 0) {
+            ESP_LOGE(TAG, "%s does not match %s, regenerate it with iavoz_pack_weights", out_path.c_str(),
+                     in_path.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    bool written;
+    if (EndsWith(out_path, ".tflite")) {
+        FILE * f = fopen(out_path.c_str(), "wb");
+        written = f && fwrite(builder.GetBufferPointer(), 1, builder.GetSize(), f) == builder.GetSize();
+        written = f && fclose(f) == 0 && written;
+    } else {
+        written = WriteModelSource(out_path, in_path, builder.GetBufferPointer(), builder.GetSize());
+    }
+    if (!written) {
+        ESP_LOGE(TAG, "Could not write %s", out_path.c_str());
+        return 1;
+    }
+
+    ESP_LOGI(TAG, "Packed %d of %d operators, %zu filter bytes, model %zu -> %u bytes", listed[2], candidates,
+             packed_bytes, bytes.size(), (unsigned) builder.GetSize());
+    return 0;
+}
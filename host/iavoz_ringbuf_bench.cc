@@ -0,0 +1,177 @@
+/********************************************************************************************
+* iavoz_ringbuf_bench: throughput of the capture ring buffer, old ringbuf.c against IAVoz_RingBuf.
+*
+* Usage: iavoz_ringbuf_bench [-s seconds_of_audio] [-w write_samples] [-r read_samples]
+*
+* A producer task writes a counting sample sequence in chunks of w samples, as the I2S task
+* does, while the consumer reads it back in chunks of r samples, as GetAudioSlices does.
+* Both sides block when the buffer is full or empty. Every sample is checked on the way
+* out, a corrupted or reordered stream exits with 1.
+***********************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "ges_iavoz_audio_provider.h"
+#include "ges_iavoz_ringbuf.h"
+#include "ringbuf.h"
+
+static const char * TAG = "IAVOZ_RB_BENCH";
+
+enum BenchMode {
+    kModeRingbufC,
+    kModeCopy,
+    kModeSpan,
+};
+
+static const char * kModeNames[] = {"ringbuf.c", "IAVoz_RingBuf copy", "IAVoz_RingBuf span"};
+
+struct BenchRun {
+    BenchMode mode;
+    int64_t total_samples;
+    uint32_t write_samples;
+    uint32_t read_samples;
+
+    ringbuf_t * rb_c;
+    IAVoz_RingBuf_t * rb;
+    SemaphoreHandle_t producer_done;
+};
+
+static void ProducerTask ( void * vParam ) {
+    BenchRun * run = (BenchRun *) vParam;
+    std::vector<int16_t> chunk(run->write_samples);
+    int64_t produced = 0;
+
+    while (produced < run->total_samples) {
+        uint32_t count = run->write_samples;
+        if (count > run->total_samples - produced) {count = run->total_samples - produced;}
+        for (uint32_t i = 0; i < count; i++) {chunk[i] = (int16_t) (produced + i);}
+
+        uint32_t done = 0;
+        while (done < count) {
+            if (run->mode == kModeRingbufC) {
+                int written = rb_write(run->rb_c, (uint8_t *) (chunk.data() + done), (count - done) * sizeof(int16_t), portMAX_DELAY);
+                if (written > 0) {done += written / sizeof(int16_t);}
+            } else {
+                done += IAVoz_RingBuf_Write(run->rb, chunk.data() + done, count - done, portMAX_DELAY);
+            }
+        }
+        produced += count;
+    }
+
+    xSemaphoreGive(run->producer_done);
+    vTaskDelete(NULL);
+}
+
+// Returns the number of samples that did not match the sequence.
+static int64_t Consume ( BenchRun * run ) {
+    std::vector<int16_t> chunk(run->read_samples);
+    int64_t consumed = 0;
+    int64_t errors = 0;
+
+    while (consumed < run->total_samples) {
+        uint32_t count = run->read_samples;
+        if (count > run->total_samples - consumed) {count = run->total_samples - consumed;}
+
+        if (run->mode == kModeSpan) {
+            // Check the samples in place, without copying them out.
+            IAVoz_RingBuf_WaitFilled(run->rb, count, portMAX_DELAY);
+            uint32_t done = 0;
+            while (done < count) {
+                const int16_t * span;
+                uint32_t span_size = IAVoz_RingBuf_ReadSpan(run->rb, &span);
+                if (span_size > count - done) {span_size = count - done;}
+                for (uint32_t i = 0; i < span_size; i++) {errors += (span[i] != (int16_t) (consumed + done + i));}
+                IAVoz_RingBuf_Consume(run->rb, span_size);
+                done += span_size;
+            }
+        } else {
+            uint32_t done = 0;
+            while (done < count) {
+                if (run->mode == kModeRingbufC) {
+                    int read = rb_read(run->rb_c, (uint8_t *) (chunk.data() + done), (count - done) * sizeof(int16_t), portMAX_DELAY);
+                    if (read > 0) {done += read / sizeof(int16_t);}
+                } else {
+                    done += IAVoz_RingBuf_Read(run->rb, chunk.data() + done, count - done, portMAX_DELAY);
+                }
+            }
+            for (uint32_t i = 0; i < count; i++) {errors += (chunk[i] != (int16_t) (consumed + i));}
+        }
+        consumed += count;
+    }
+
+    return errors;
+}
+
+int main ( int argc, char ** argv ) {
+    int seconds = 3600;
+    uint32_t write_samples = i2s_bytes_to_read / 4;
+    uint32_t read_samples = 320;
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-s") && arg + 1 < argc) {
+            seconds = atoi(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-w") && arg + 1 < argc) {
+            write_samples = atoi(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-r") && arg + 1 < argc) {
+            read_samples = atoi(argv[++arg]);
+        } else {
+            break;
+        }
+    }
+
+    if (arg != argc || seconds <= 0 || write_samples == 0 || read_samples == 0 ||
+        write_samples > (uint32_t) kAudioCaptureBufferSize || read_samples > (uint32_t) kAudioCaptureBufferSize) {
+        fprintf(stderr, "usage: %s [-s seconds_of_audio] [-w write_samples] [-r read_samples]\n", argv[0]);
+        return 2;
+    }
+
+    const int64_t total_samples = (int64_t) seconds * 16000;
+    printf("%lld samples, writes of %u, reads of %u, %d sample buffer\n", (long long) total_samples,
+           (unsigned) write_samples, (unsigned) read_samples, (int) kAudioCaptureBufferSize);
+    printf("%-20s %10s %14s %10s\n", "buffer", "ms", "Msamples/s", "errors");
+
+    int64_t total_errors = 0;
+    for (int mode = kModeRingbufC; mode <= kModeSpan; mode++) {
+        BenchRun run = {(BenchMode) mode, total_samples, write_samples, read_samples, NULL, NULL, NULL};
+
+        if (mode == kModeRingbufC) {
+            run.rb_c = rb_init("bench", kAudioCaptureBufferSize * sizeof(int16_t));
+        } else if (!IAVoz_RingBuf_Init(&run.rb, kAudioCaptureBufferSize, kMaxAudioSampleSize)) {
+            ESP_LOGE(TAG, "Ring buffer init failed");
+            return 1;
+        }
+        run.producer_done = xSemaphoreCreateBinary();
+
+        int64_t start = esp_timer_get_time();
+        TaskHandle_t producer = NULL;
+        xTaskCreate(ProducerTask, "producer", 4096, &run, 5, &producer);
+        int64_t errors = Consume(&run);
+        xSemaphoreTake(run.producer_done, portMAX_DELAY);
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        printf("%-20s %10.1f %14.2f %10lld\n", kModeNames[mode], elapsed / 1000.0,
+               elapsed ? (double) total_samples / elapsed : 0.0, (long long) errors);
+        total_errors += errors;
+
+        vSemaphoreDelete(run.producer_done);
+        if (run.rb_c) {rb_cleanup(run.rb_c);}
+        IAVoz_RingBuf_DeInit(run.rb);
+    }
+
+    if (total_errors) {
+        ESP_LOGE(TAG, "%lld samples came out corrupted", (long long) total_errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,214 @@
+/********************************************************************************************
+* iavoz_rtf_bench: end-to-end real-time-factor benchmark over a labelled WAV corpus.
+*
+* Usage: iavoz_rtf_bench [-s step_ms] [-o report.json] corpus_dir
+*
+* The corpus holds one directory per label, named after the keyword in lower case
+* (heylola, enciende, apaga, sube, baja, para, socorro, activa, todo). Any other
+* directory, e.g. "null" or "noise", holds negative samples. Files are replayed in
+* sorted order as one continuous stream and a detection is attributed to the file
+* that was playing when it fired.
+***********************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "esp_timer.h"
+#include "iavoz_host.h"
+
+static const char * TAG = "IAVOZ_RTF";
+
+struct BenchState {
+    std::vector<uint32_t> populate_us;
+    std::vector<uint32_t> invoke_us;
+    std::vector<uint32_t> recognize_us;
+    std::vector<uint32_t> step_us;
+
+    const IAVoz_HostUtterance_t * current;
+    int detections;
+    int hits;
+    int false_alarms;
+    int current_hit;
+};
+
+static BenchState bench;
+
+static void WriteStage ( FILE * out, const char * name, const std::vector<uint32_t> & values, bool last ) {
+    unsigned long long total = 0;
+    for (uint32_t v : values) {total += v;}
+    std::vector<uint32_t> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+
+    fprintf(out, "    \"%s\": {\"count\": %zu, \"mean_us\": %llu, \"p50_us\": %u, \"p95_us\": %u, \"p99_us\": %u}%s\n",
+            name, values.size(), values.empty() ? 0ULL : total / values.size(),
+            IAVoz_Host_Percentile(sorted, 50), IAVoz_Host_Percentile(sorted, 95), IAVoz_Host_Percentile(sorted, 99), last ? "" : ",");
+}
+
+static void BenchActivation ( IAVOZ_KEY_t key ) {
+    bench.detections++;
+    if (bench.current && bench.current->label != IAVOZ_KEY_NULL && key == bench.current->label) {
+        bench.current_hit = 1;
+    } else {
+        bench.false_alarms++;
+    }
+}
+
+static void BenchStepHook ( IAVoz_System_t * sys, int32_t, int, void * ) {
+    bench.step_us.push_back(sys->timings.step_us);
+    bench.populate_us.push_back(sys->timings.populate_us);
+    if (sys->timings.invoked) {
+        bench.invoke_us.push_back(sys->timings.invoke_us);
+        bench.recognize_us.push_back(sys->timings.recognize_us);
+    }
+    if (sys->activation != IAVOZ_KEY_NULL) {BenchActivation(sys->activation);}
+}
+
+// One keyword followed by a gap in the results, as when the VAD gate skips windows or the
+// feed stalls, must count as one activation: the recognizer keeps reporting the keyword as
+// found_command while the averaging window refills, but not as activated.
+static bool CheckActivationCountedOnce ( void ) {
+    static const int32_t kTimesMs[] = {0, 100, 200, 1500, 1600, 1700};
+    static const int kKeywordSteps = 3;
+    int8_t scores[kCategoryCount];
+    int dims_data[3] = {2, 1, kCategoryCount};
+    TfLiteTensor results = {};
+    results.type = kTfLiteInt8;
+    results.dims = reinterpret_cast<TfLiteIntArray *>(dims_data);
+    results.data.int8 = scores;
+
+    tflite::MicroErrorReporter error_reporter;
+    RecognizeCommands recognizer(&error_reporter);
+    int activations = 0;
+    for (int step = 0; step < (int) (sizeof(kTimesMs) / sizeof(kTimesMs[0])); step++) {
+        const IAVOZ_KEY_t key = step < kKeywordSteps ? IAVOZ_KEY_HEYLOLA : IAVOZ_KEY_NULL;
+        for (int i = 0; i < kCategoryCount; i++) {scores[i] = kCategoryLabels[i] == key ? 127 : -128;}
+
+        IAVOZ_KEY_t found_command = IAVOZ_KEY_NULL;
+        IAVOZ_KEY_t activated = IAVOZ_KEY_NULL;
+        uint8_t score = 0;
+        uint8_t found_index = 0;
+        bool is_new_command = false;
+        if (recognizer.ProcessLatestResults(&results, kTimesMs[step], &found_command, &score,
+                                            &is_new_command, &found_index, &activated) != kTfLiteOk) {
+            return false;
+        }
+        if (activated != IAVOZ_KEY_NULL) {activations++;}
+    }
+    if (activations != 1) {
+        ESP_LOGE(TAG, "A keyword followed by a gap counted as %d activations", activations);
+        return false;
+    }
+    return true;
+}
+
+int main ( int argc, char ** argv ) {
+    int32_t step_ms = kFeatureSliceStrideMs * 5;
+    const char * report_path = NULL;
+    int arg = 1;
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-s") && arg + 1 < argc) {
+            step_ms = atoi(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-o") && arg + 1 < argc) {
+            report_path = argv[++arg];
+        } else {
+            break;
+        }
+    }
+
+    if (arg != argc - 1 || step_ms <= 0 || step_ms % kFeatureSliceStrideMs) {
+        fprintf(stderr, "usage: %s [-s step_ms] [-o report.json] corpus_dir\n", argv[0]);
+        return 2;
+    }
+
+    if (!CheckActivationCountedOnce()) {return 1;}
+
+    std::string corpus = argv[arg];
+    std::vector<IAVoz_HostUtterance_t> utterances = IAVoz_Host_ListCorpus(corpus);
+
+    if (utterances.empty()) {
+        ESP_LOGE(TAG, "No WAV files found under %s", corpus.c_str());
+        return 1;
+    }
+
+    IAVoz_System_t * sys = NULL;
+    if (!IAVoz_System_Init(&sys, &IAVoz_HostModelSettings, IAVoz_Host_NullCallback)) {
+        ESP_LOGE(TAG, "System init failed");
+        return 1;
+    }
+
+    int keyword_files = 0;
+    int failed_files = 0;
+    int64_t audio_ms = 0;
+    int64_t start = esp_timer_get_time();
+
+    for (const IAVoz_HostUtterance_t & utterance : utterances) {
+        bench.current = &utterance;
+        bench.current_hit = 0;
+
+        int32_t start_ms = LatestAudioTimestamp(sys->ap);
+        if (!IAVoz_Host_RunWav(sys, utterance.path.c_str(), step_ms, BenchStepHook, NULL)) {
+            failed_files++;
+            continue;
+        }
+        audio_ms += LatestAudioTimestamp(sys->ap) - start_ms;
+
+        if (utterance.label != IAVOZ_KEY_NULL) {
+            keyword_files++;
+            bench.hits += bench.current_hit;
+        }
+    }
+
+    int64_t wall_us = esp_timer_get_time() - start;
+    double audio_hours = audio_ms / 3600000.0;
+
+    // The real-time factor only counts pipeline steps, not WAV loading.
+    int64_t pipeline_us = 0;
+    for (uint32_t v : bench.step_us) {pipeline_us += v;}
+
+    FILE * out = report_path ? fopen(report_path, "w") : stdout;
+    if (!out) {
+        ESP_LOGE(TAG, "Could not open %s", report_path);
+        return 1;
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"corpus\": \"%s\",\n", corpus.c_str());
+    fprintf(out, "  \"files\": %zu,\n", utterances.size());
+    fprintf(out, "  \"failed_files\": %d,\n", failed_files);
+    fprintf(out, "  \"step_ms\": %d,\n", step_ms);
+    fprintf(out, "  \"audio_seconds\": %.3f,\n", audio_ms / 1000.0);
+    fprintf(out, "  \"wall_seconds\": %.3f,\n", wall_us / 1e6);
+    fprintf(out, "  \"pipeline_seconds\": %.3f,\n", pipeline_us / 1e6);
+    fprintf(out, "  \"real_time_factor\": %.5f,\n", audio_ms ? (pipeline_us / 1000.0) / audio_ms : 0.0);
+    fprintf(out, "  \"invocations\": %zu,\n", bench.invoke_us.size());
+    fprintf(out, "  \"gate\": {\"windows\": %u, \"skipped_silence\": %u, \"skipped_position\": %u, \"hangover\": %u},\n",
+            (unsigned) sys->gate.windows, (unsigned) sys->gate.skipped_silence, (unsigned) sys->gate.skipped_position,
+            (unsigned) sys->gate.hangover);
+    fprintf(out, "  \"stages\": {\n");
+    WriteStage(out, "populate", bench.populate_us, false);
+    WriteStage(out, "invoke", bench.invoke_us, false);
+    WriteStage(out, "recognize", bench.recognize_us, false);
+    WriteStage(out, "step", bench.step_us, true);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"detections\": %d,\n", bench.detections);
+    fprintf(out, "  \"detections_per_hour\": %.2f,\n", audio_hours > 0 ? bench.detections / audio_hours : 0.0);
+    fprintf(out, "  \"false_alarms\": %d,\n", bench.false_alarms);
+    fprintf(out, "  \"false_alarms_per_hour\": %.2f,\n", audio_hours > 0 ? bench.false_alarms / audio_hours : 0.0);
+    fprintf(out, "  \"keyword_files\": %d,\n", keyword_files);
+    fprintf(out, "  \"keyword_hits\": %d,\n", bench.hits);
+    fprintf(out, "  \"keyword_hit_rate\": %.4f\n", keyword_files ? (double) bench.hits / keyword_files : 0.0);
+    fprintf(out, "}\n");
+
+    if (report_path) {fclose(out);}
+
+    IAVoz_System_DeInit(sys);
+    return failed_files ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+/********************************************************************************************
+* iavoz_streaming_bench: incremental vs full inference on a sliding feature window.
+*
+* Usage: iavoz_streaming_bench [-n invocations] [-k shift[,shift...]] [model]
+*
+* Slides a window of kFeatureSliceSize wide rows over a pseudo random feature stream,
+* moving it by k rows between invocations. Every window is run through a plain
+* MicroInterpreter and a StreamingMicroInterpreter, the outputs must match bit for bit.
+* Reports the mean invoke time of both and the share of streamed activations that had
+* to be recomputed. Exits with 1 on any mismatch.
+***********************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "iavoz_model_zoo.h"
+#include "model_settings.h"
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/streaming_micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+static const char * TAG = "IAVOZ_STREAM";
+
+static constexpr size_t kArenaSize = 2 * 1024 * 1024;
+
+static int8_t NextFeature ( uint32_t * seed ) {
+    *seed = *seed * 1664525 + 1013904223;
+    return (int8_t) (*seed >> 24);
+}
+
+int main ( int argc, char ** argv ) {
+    int invocations = 50;
+    std::vector<int> shifts = {1, 2, 4, 5, 8, 16, 32};
+    const char * model_name = "mobilnet";
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-n") && arg + 1 < argc) {
+            invocations = atoi(argv[++arg]);
+        } else if (!strcmp(argv[arg], "-k") && arg + 1 < argc) {
+            shifts.clear();
+            for (char * k = strtok(argv[++arg], ","); k; k = strtok(NULL, ",")) {shifts.push_back(atoi(k));}
+        } else {
+            break;
+        }
+    }
+    if (arg < argc) {model_name = argv[arg++];}
+
+    if (arg != argc || invocations <= 0 || shifts.empty()) {
+        fprintf(stderr, "usage: %s [-n invocations] [-k shift[,shift...]] [model]\n", argv[0]);
+        return 2;
+    }
+
+    const IAVoz_ZooModel_t * entry = NULL;
+    for (int i = 0; i < kIAVozZooModelCount; i++) {
+        if (!strcmp(kIAVozZooModels[i].name, model_name)) {entry = &kIAVozZooModels[i];}
+    }
+    if (!entry) {
+        ESP_LOGE(TAG, "Unknown model %s", model_name);
+        return 2;
+    }
+
+    static tflite::MicroErrorReporter error_reporter;
+    static tflite::AllOpsResolver resolver;
+    const tflite::Model * model = tflite::GetModel(entry->data);
+
+    alignas(16) static uint8_t full_arena[kArenaSize];
+    alignas(16) static uint8_t streaming_arena[kArenaSize];
+    tflite::MicroInterpreter full(model, resolver, full_arena, kArenaSize, &error_reporter);
+    tflite::StreamingMicroInterpreter streaming(model, resolver, streaming_arena, kArenaSize, &error_reporter);
+
+    if (full.AllocateTensors() != kTfLiteOk || streaming.AllocateTensors() != kTfLiteOk ||
+        streaming.AllocateStreamingState() != kTfLiteOk) {
+        ESP_LOGE(TAG, "%s: allocation failed", model_name);
+        return 1;
+    }
+
+    TfLiteTensor * full_input = full.input(0);
+    TfLiteTensor * streaming_input = streaming.input(0);
+    const int row_bytes = kFeatureSliceSize;
+    const int rows = full_input->bytes / row_bytes;
+
+    printf("%s: %d x %d input, %zu of %zu operators streamed, %zu bytes of cache\n", model_name, rows, row_bytes,
+           streaming.streaming_operators(), (size_t) model->subgraphs()->Get(0)->operators()->size(),
+           streaming.streaming_bytes());
+    printf("%6s %12s %12s %8s %12s %10s\n", "shift", "full_us", "stream_us", "speedup", "recomputed", "mismatch");
+
+    std::vector<int8_t> window(rows * row_bytes);
+    int total_mismatches = 0;
+
+    for (int shift : shifts) {
+        if (shift <= 0 || shift > rows) {continue;}
+
+        uint32_t seed = 0x5eed1234;
+        for (int8_t & v : window) {v = NextFeature(&seed);}
+        streaming.ResetStreamingState();
+
+        int64_t full_us = 0, streaming_us = 0;
+        double recomputed = 0;
+        int mismatches = 0;
+
+        // The first round fills the caches and is not measured.
+        for (int i = 0; i <= invocations; i++) {
+            if (i > 0) {
+                memmove(window.data(), window.data() + shift * row_bytes, (rows - shift) * row_bytes);
+                for (int j = (rows - shift) * row_bytes; j < rows * row_bytes; j++) {window[j] = NextFeature(&seed);}
+            }
+            memcpy(full_input->data.int8, window.data(), window.size());
+            memcpy(streaming_input->data.int8, window.data(), window.size());
+
+            int64_t start = esp_timer_get_time();
+            full.Invoke();
+            int64_t middle = esp_timer_get_time();
+            streaming.InvokeStreaming(i > 0 ? shift : -1);
+            int64_t end = esp_timer_get_time();
+
+            TfLiteTensor * full_output = full.output(0);
+            if (memcmp(full_output->data.int8, streaming.output(0)->data.int8, full_output->bytes)) {mismatches++;}
+
+            if (i > 0) {
+                full_us += middle - start;
+                streaming_us += end - middle;
+                recomputed += streaming.streaming_bytes() ? (double) streaming.last_recomputed_bytes() / streaming.streaming_bytes() : 1.0;
+            }
+        }
+
+        printf("%6d %12lld %12lld %7.2fx %11.1f%% %10d\n", shift, (long long) (full_us / invocations),
+               (long long) (streaming_us / invocations), streaming_us ? (double) full_us / streaming_us : 0.0,
+               100.0 * recomputed / invocations, mismatches);
+        total_mismatches += mismatches;
+    }
+
+    if (total_mismatches) {
+        ESP_LOGE(TAG, "Streaming output differs from the full invocation %d times", total_mismatches);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+/********************************************************************************************
+* Host shim for esp_err.h
+***********************************************************************************************/
+
+#ifndef _HOST_ESP_ERR_H
+#define _HOST_ESP_ERR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int esp_err_t;
+
+#define ESP_OK          0
+#define ESP_FAIL        -1
+#define ESP_ERR_NO_MEM  0x101
+
+#define ESP_ERROR_CHECK(x) do {                                                         \
+        esp_err_t err_rc_ = (x);                                                        \
+        if (err_rc_ != ESP_OK) {                                                        \
+            fprintf(stderr, "ESP_ERROR_CHECK failed: 0x%x at %s:%d\n",                  \
+                    err_rc_, __FILE__, __LINE__);                                       \
+            abort();                                                                    \
+        }                                                                               \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HOST_ESP_ERR_H
@@ -0,0 +1,22 @@
+/********************************************************************************************
+* Host shim for esp_heap_caps.h
+*
+* The host has a single heap, capabilities are ignored.
+***********************************************************************************************/
+
+#ifndef _HOST_ESP_HEAP_CAPS_H
+#define _HOST_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_DEFAULT      (1 << 12)
+
+#define heap_caps_malloc( size, caps )          malloc(size)
+#define heap_caps_calloc( n, size, caps )       calloc(n, size)
+#define heap_caps_free( ptr )                   free(ptr)
+#define heap_caps_get_free_size( caps )         ((size_t) 0)
+
+#endif // _HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,49 @@
+/********************************************************************************************
+* Host implementation of the esp_log and esp_timer shims.
+***********************************************************************************************/
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+/* INTERNAL VARIABLES */
+/* ------------------ */
+static esp_log_level_t log_level = (esp_log_level_t) CONFIG_LOG_DEFAULT_LEVEL;
+
+static const char log_letters[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+
+/* LOG */
+/* --- */
+void esp_log_level_set ( const char * tag, esp_log_level_t level ) {
+    (void) tag;
+    log_level = level;
+}
+
+void esp_log_write ( esp_log_level_t level, const char * tag, const char * format, ... ) {
+    if (level > log_level) {return;}
+
+    FILE * stream = (level <= ESP_LOG_WARN) ? stderr : stdout;
+    va_list args;
+
+    fprintf(stream, "%c (%lld) %s: ", log_letters[level], (long long) (esp_timer_get_time() / 1000), tag);
+    va_start(args, format);
+    vfprintf(stream, format, args);
+    va_end(args);
+    fputc('\n', stream);
+}
+
+/* TIMER */
+/* ----- */
+static int64_t HostMonotonicUs ( void ) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+int64_t esp_timer_get_time ( void ) {
+    static const int64_t boot = HostMonotonicUs();
+    return HostMonotonicUs() - boot;
+}
@@ -0,0 +1,23 @@
+/********************************************************************************************
+* Host shim for esp_timer.h
+***********************************************************************************************/
+
+#ifndef _HOST_ESP_TIMER_H
+#define _HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Microseconds elapsed since the process started, from a monotonic clock.
+ */
+int64_t esp_timer_get_time ( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HOST_ESP_TIMER_H
@@ -0,0 +1,43 @@
+/********************************************************************************************
+* Host shim for freertos/FreeRTOS.h
+*
+* Maps the subset of the FreeRTOS API used by ges_iavoz onto POSIX threads.
+* One tick is one millisecond.
+***********************************************************************************************/
+
+#ifndef _HOST_FREERTOS_H
+#define _HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <assert.h>
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int32_t     BaseType_t;
+typedef uint32_t    UBaseType_t;
+typedef uint32_t    TickType_t;
+
+#define pdFALSE                 ((BaseType_t) 0)
+#define pdTRUE                  ((BaseType_t) 1)
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+
+#define configTICK_RATE_HZ      1000
+#define portMAX_DELAY           ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS      ((TickType_t) 1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS        portTICK_PERIOD_MS
+#define pdMS_TO_TICKS( ms )     ((TickType_t) (ms) * configTICK_RATE_HZ / 1000)
+#define tskNO_AFFINITY          ((BaseType_t) 0x7fffffff)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HOST_FREERTOS_H
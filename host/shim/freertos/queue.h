@@ -0,0 +1,10 @@
+/********************************************************************************************
+* Host shim for freertos/queue.h
+***********************************************************************************************/
+
+#ifndef _HOST_FREERTOS_QUEUE_H
+#define _HOST_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+#endif // _HOST_FREERTOS_QUEUE_H
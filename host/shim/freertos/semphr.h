@@ -0,0 +1,37 @@
+/********************************************************************************************
+* Host shim for freertos/semphr.h
+*
+* Mutexes are binary semaphores, there is no priority inheritance on the host.
+***********************************************************************************************/
+
+#ifndef _HOST_FREERTOS_SEMPHR_H
+#define _HOST_FREERTOS_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HostSemaphore_t * SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+
+SemaphoreHandle_t xSemaphoreCreateBinary ( void );
+SemaphoreHandle_t xSemaphoreCreateMutex ( void );
+BaseType_t xSemaphoreTake ( SemaphoreHandle_t xSemaphore, TickType_t xTicksToWait );
+BaseType_t xSemaphoreGive ( SemaphoreHandle_t xSemaphore );
+void vSemaphoreDelete ( SemaphoreHandle_t xSemaphore );
+
+// Legacy API, the semaphore is created in the given state.
+#define vSemaphoreCreateBinary( xSemaphore ) do {           \
+        (xSemaphore) = xSemaphoreCreateBinary();            \
+        if ((xSemaphore) != NULL) {                         \
+            xSemaphoreGive(xSemaphore);                     \
+        }                                                   \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HOST_FREERTOS_SEMPHR_H
@@ -0,0 +1,35 @@
+/********************************************************************************************
+* Host shim for freertos/task.h
+***********************************************************************************************/
+
+#ifndef _HOST_FREERTOS_TASK_H
+#define _HOST_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HostTask_t * TaskHandle_t;
+typedef void (*TaskFunction_t)(void * vParam);
+
+BaseType_t xTaskCreate ( TaskFunction_t pxTaskCode, const char * pcName, uint32_t usStackDepth, void * pvParameters, UBaseType_t uxPriority, TaskHandle_t * pxCreatedTask );
+
+// Pins the thread when xCoreID exists on the host, otherwise same as xTaskCreate.
+BaseType_t xTaskCreatePinnedToCore ( TaskFunction_t pxTaskCode, const char * pcName, uint32_t usStackDepth, void * pvParameters, UBaseType_t uxPriority, TaskHandle_t * pxCreatedTask, BaseType_t xCoreID );
+
+void vTaskDelete ( TaskHandle_t xTask );
+void vTaskDelay ( TickType_t xTicksToDelay );
+TickType_t xTaskGetTickCount ( void );
+TaskHandle_t xTaskGetCurrentTaskHandle ( void );
+
+// Notification value used as a counting semaphore, the only way ges_iavoz uses it.
+BaseType_t xTaskNotifyGive ( TaskHandle_t xTaskToNotify );
+uint32_t ulTaskNotifyTake ( BaseType_t xClearCountOnExit, TickType_t xTicksToWait );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HOST_FREERTOS_TASK_H
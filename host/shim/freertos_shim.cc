@@ -0,0 +1,252 @@
+/********************************************************************************************
+* Host implementation of the FreeRTOS shim on top of POSIX threads.
+***********************************************************************************************/
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <new>
+
+/* TYPES */
+/* ----- */
+struct HostTask_t {
+    pthread_t thread;
+    TaskFunction_t code;
+    void * param;
+    bool is_detached;
+
+    pthread_mutex_t notify_mutex;
+    pthread_cond_t notify_cond;
+    uint32_t notify_value;
+};
+
+struct HostSemaphore_t {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t count;
+};
+
+/* INTERNAL VARIABLES */
+/* ------------------ */
+static thread_local HostTask_t * current_task = NULL;
+
+/* INTERNAL FUNCTIONS */
+/* ------------------ */
+static struct timespec HostDeadline ( TickType_t ticks ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t ns = (uint64_t) ts.tv_nsec + (uint64_t) ticks * (1000000000ULL / configTICK_RATE_HZ);
+    ts.tv_sec += ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    return ts;
+}
+
+static HostTask_t * HostTaskCreate ( void ) {
+    HostTask_t * task = new (std::nothrow) HostTask_t();
+    if (!task) {return NULL;}
+
+    pthread_mutex_init(&task->notify_mutex, NULL);
+    pthread_cond_init(&task->notify_cond, NULL);
+    task->notify_value = 0;
+    return task;
+}
+
+static void HostTaskFree ( HostTask_t * task ) {
+    pthread_cond_destroy(&task->notify_cond);
+    pthread_mutex_destroy(&task->notify_mutex);
+    delete task;
+}
+
+// vTaskDelete cancels tasks blocked in a condition wait, which returns with the mutex held.
+static void HostUnlock ( void * vMutex ) {
+    pthread_mutex_unlock((pthread_mutex_t *) vMutex);
+}
+
+static void * HostTaskEntry ( void * vParam ) {
+    HostTask_t * task = (HostTask_t *) vParam;
+    current_task = task;
+    task->code(task->param);
+    // FreeRTOS tasks must never return, behave as if they had called vTaskDelete(NULL).
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+/* TASKS */
+/* ----- */
+BaseType_t xTaskCreate ( TaskFunction_t pxTaskCode, const char *, uint32_t, void * pvParameters, UBaseType_t, TaskHandle_t * pxCreatedTask ) {
+    HostTask_t * task = HostTaskCreate();
+    if (!task) {return pdFAIL;}
+
+    task->code = pxTaskCode;
+    task->param = pvParameters;
+    task->is_detached = false;
+
+    if (pxCreatedTask) {*pxCreatedTask = task;}
+
+    if (pthread_create(&task->thread, NULL, HostTaskEntry, task) != 0) {
+        if (pxCreatedTask) {*pxCreatedTask = NULL;}
+        HostTaskFree(task);
+        return pdFAIL;
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore ( TaskFunction_t pxTaskCode, const char * pcName, uint32_t usStackDepth, void * pvParameters, UBaseType_t uxPriority, TaskHandle_t * pxCreatedTask, BaseType_t xCoreID ) {
+    TaskHandle_t task = NULL;
+    BaseType_t created = xTaskCreate(pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, &task);
+    if (pxCreatedTask) {*pxCreatedTask = task;}
+    if (created != pdPASS || xCoreID == tskNO_AFFINITY) {return created;}
+
+#ifdef __linux__
+    // Best effort, a host with fewer cores than the ESP32 just runs the task anywhere.
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(xCoreID, &cpus);
+    pthread_setaffinity_np(task->thread, sizeof(cpus), &cpus);
+#endif
+    return created;
+}
+
+void vTaskDelete ( TaskHandle_t xTask ) {
+    if (!xTask || xTask == current_task) {
+        HostTask_t * self = current_task;
+        if (self) {
+            self->is_detached = true;
+            pthread_detach(self->thread);
+            current_task = NULL;
+            HostTaskFree(self);
+        }
+        pthread_exit(NULL);
+    }
+
+    pthread_cancel(xTask->thread);
+    if (!xTask->is_detached) {pthread_join(xTask->thread, NULL);}
+    HostTaskFree(xTask);
+}
+
+void vTaskDelay ( TickType_t xTicksToDelay ) {
+    struct timespec ts;
+    ts.tv_sec = xTicksToDelay / configTICK_RATE_HZ;
+    ts.tv_nsec = (long) (xTicksToDelay % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+TickType_t xTaskGetTickCount ( void ) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t) (ts.tv_sec * configTICK_RATE_HZ + ts.tv_nsec / (1000000000L / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle ( void ) {
+    // Threads not started by xTaskCreate, e.g. main(), get a handle on first use.
+    if (!current_task) {
+        current_task = HostTaskCreate();
+        if (current_task) {
+            current_task->thread = pthread_self();
+            current_task->is_detached = true;
+        }
+    }
+    return current_task;
+}
+
+/* NOTIFICATIONS */
+/* ------------- */
+BaseType_t xTaskNotifyGive ( TaskHandle_t xTaskToNotify ) {
+    pthread_mutex_lock(&xTaskToNotify->notify_mutex);
+    xTaskToNotify->notify_value++;
+    pthread_cond_signal(&xTaskToNotify->notify_cond);
+    pthread_mutex_unlock(&xTaskToNotify->notify_mutex);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake ( BaseType_t xClearCountOnExit, TickType_t xTicksToWait ) {
+    HostTask_t * self = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = HostDeadline(xTicksToWait);
+
+    pthread_mutex_lock(&self->notify_mutex);
+    pthread_cleanup_push(HostUnlock, &self->notify_mutex);
+    while (self->notify_value == 0 && xTicksToWait != 0) {
+        if (xTicksToWait == portMAX_DELAY) {
+            pthread_cond_wait(&self->notify_cond, &self->notify_mutex);
+        } else if (pthread_cond_timedwait(&self->notify_cond, &self->notify_mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_cleanup_pop(0);
+    uint32_t value = self->notify_value;
+    if (value) {self->notify_value = xClearCountOnExit ? 0 : value - 1;}
+    pthread_mutex_unlock(&self->notify_mutex);
+
+    return value;
+}
+
+/* SEMAPHORES */
+/* ---------- */
+static SemaphoreHandle_t HostSemaphoreCreate ( uint32_t initial_count ) {
+    HostSemaphore_t * sem = new (std::nothrow) HostSemaphore_t();
+    if (!sem) {return NULL;}
+
+    pthread_mutex_init(&sem->mutex, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = initial_count;
+
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary ( void ) {
+    return HostSemaphoreCreate(0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex ( void ) {
+    return HostSemaphoreCreate(1);
+}
+
+BaseType_t xSemaphoreTake ( SemaphoreHandle_t xSemaphore, TickType_t xTicksToWait ) {
+    struct timespec deadline = HostDeadline(xTicksToWait);
+
+    pthread_mutex_lock(&xSemaphore->mutex);
+    pthread_cleanup_push(HostUnlock, &xSemaphore->mutex);
+    while (xSemaphore->count == 0 && xTicksToWait != 0) {
+        if (xTicksToWait == portMAX_DELAY) {
+            pthread_cond_wait(&xSemaphore->cond, &xSemaphore->mutex);
+        } else if (pthread_cond_timedwait(&xSemaphore->cond, &xSemaphore->mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_cleanup_pop(0);
+    // Decided after the cleanup scope, whose setjmp would otherwise clobber it.
+    BaseType_t taken = (xSemaphore->count > 0) ? pdTRUE : pdFALSE;
+    if (taken) {xSemaphore->count--;}
+    pthread_mutex_unlock(&xSemaphore->mutex);
+
+    return taken;
+}
+
+BaseType_t xSemaphoreGive ( SemaphoreHandle_t xSemaphore ) {
+    BaseType_t given = pdFALSE;
+
+    pthread_mutex_lock(&xSemaphore->mutex);
+    if (xSemaphore->count == 0) {
+        xSemaphore->count = 1;
+        given = pdTRUE;
+        pthread_cond_signal(&xSemaphore->cond);
+    }
+    pthread_mutex_unlock(&xSemaphore->mutex);
+
+    return given;
+}
+
+void vSemaphoreDelete ( SemaphoreHandle_t xSemaphore ) {
+    if (!xSemaphore) {return;}
+
+    pthread_cond_destroy(&xSemaphore->cond);
+    pthread_mutex_destroy(&xSemaphore->mutex);
+    delete xSemaphore;
+}
@@ -0,0 +1,40 @@
+/********************************************************************************************
+* Host build configuration.
+*
+* Stands in for the sdkconfig.h that ESP-IDF generates from Kconfig, so the
+* ges_iavoz component can be compiled and profiled on a workstation.
+***********************************************************************************************/
+
+#ifndef _HOST_SDKCONFIG_H
+#define _HOST_SDKCONFIG_H
+
+#define CONFIG_IAVOZ_ENABLE                 1
+#define CONFIG_IAVOZ_SYS_TASK_STACK_SIZE    7168
+#define CONFIG_IAVOZ_SYS_TASK_PRIORITY      5
+#define CONFIG_IAVOZ_MIC_TASK_STACK_SIZE    7168
+#define CONFIG_IAVOZ_MIC_TASK_PRIORITY      5
+#define CONFIG_IAVOZ_MIC_I2S_NUM            1
+#define CONFIG_IAVOZ_MIC_I2S_PIN_BCK        13
+#define CONFIG_IAVOZ_MIC_I2S_PIN_WS         0
+#define CONFIG_IAVOZ_MIC_I2S_PIN_DIN        22
+#if CONFIG_IAVOZ_STREAMING_INFERENCE
+#define CONFIG_IAVOZ_INVOKE_EVERY_SLICES    4
+#else
+#define CONFIG_IAVOZ_INVOKE_EVERY_SLICES    5
+#endif
+#define CONFIG_IAVOZ_VAD_GATE_MIN_VOICED_PERCENT  20
+#define CONFIG_IAVOZ_VAD_GATE_HANGOVER_MS         500
+#define CONFIG_IAVOZ_VAD_FRONTEND_SNR_DB          6
+#define CONFIG_IAVOZ_TENSOR_ARENA_SIZE      0
+#define CONFIG_IAVOZ_TENSOR_ARENA_MARGIN    1024
+#define CONFIG_IAVOZ_TENSOR_ARENA_INTERNAL  1
+#define CONFIG_IAVOZ_FEATURE_TASK_CORE      0
+#define CONFIG_IAVOZ_INFERENCE_TASK_CORE    1
+#define CONFIG_IAVOZ_MIC_TASK_CORE          -1
+
+// Audio is streamed from WAV files instead of the I2S microphone.
+#define CONFIG_IAVOZ_AUDIO_SOURCE_WAV       1
+
+#define CONFIG_LOG_DEFAULT_LEVEL            3
+
+#endif // _HOST_SDKCONFIG_H